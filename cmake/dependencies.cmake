@@ -161,8 +161,8 @@ ExternalProject_Add(sdl_mixer
 # Get linking order right
 # The most basic libraries must come last in the linking list.
 
-add_dependencies(ilmendur sdl sdl_mixer sdl_image pugixml)
-target_link_libraries(ilmendur ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libSDL2_mixer.a
+add_dependencies(ilmendur-core sdl sdl_mixer sdl_image pugixml)
+target_link_libraries(ilmendur-core ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libSDL2_mixer.a
                                ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libSDL2_image.a
                                ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libSDL2.a)
 
@@ -173,7 +173,7 @@ if (WIN32)
   find_package(Threads REQUIRED)
   find_package(OpenGL REQUIRED COMPONENTS OpenGL GLX)
 
-  target_link_libraries(ilmendur OpenGL::GLX OpenGL::GL Threads::Threads ${CMAKE_DL_LIBS})
+  target_link_libraries(ilmendur-core OpenGL::GLX OpenGL::GL Threads::Threads ${CMAKE_DL_LIBS})
   message(WARNING "Win32 support is experimental")
 elseif (APPLE)
   set(THREADS_PREFER_PTHREAD_FLAG ON)
@@ -181,7 +181,7 @@ elseif (APPLE)
   find_package(Threads REQUIRED)
   find_package(OpenGL REQUIRED COMPONENTS OpenGL GLX)
 
-  target_link_libraries(ilmendur OpenGL::GLX OpenGL::GL Threads::Threads ${CMAKE_DL_LIBS})
+  target_link_libraries(ilmendur-core OpenGL::GLX OpenGL::GL Threads::Threads ${CMAKE_DL_LIBS})
   message(WARNING "Apple support is experimental")
 else() # That is, Linux or another good Unix
   # As it turns out, SDL on Linux uses dlopen(3) to load all of its
@@ -195,12 +195,12 @@ else() # That is, Linux or another good Unix
   find_package(Wayland)
   find_package(X11 COMPONENTS Xrandr Xinerama Xkb Xfixes Xcursor Xi Xxf86vm)
 #  if (X11_FOUND)
-#    target_link_libraries(ilmendur
+#    target_link_libraries(ilmendur-core
 #      X11::Xrandr X11::Xinerama X11::Xfixes X11::Xcursor
 #      X11::Xi X11::Xss X11::Xxf86vm X11::Xkb ${X11_xkbcommon_LIB} X11::X11)
 #  endif()
 #  if (Wayland_FOUND)
-#    target_link_libraries(ilmendur ${Wayland_LIBRARIES})
+#    target_link_libraries(ilmendur-core ${Wayland_LIBRARIES})
 #  endif()
   if ((NOT X11_FOUND) AND (NOT Wayland_FOUND))
     message(SEND_ERROR "Either X11 or Wayland is required on non-Apple Unix.")
@@ -211,19 +211,19 @@ else() # That is, Linux or another good Unix
   # ALSA, Pipewire), but PulseAudio seems to be the current least
   # common denominator, so for now only require that one.
   find_package(Pulse REQUIRED)
-  #target_link_libraries(ilmendur ${Pulse_LIBRARIES})
+  #target_link_libraries(ilmendur-core ${Pulse_LIBRARIES})
 
   # 3. Core system libraries
   set(THREADS_PREFER_PTHREAD_FLAG ON)
   set(OpenGL_GL_PREFERENCE GLVND)
   find_package(Threads REQUIRED)
   find_package(OpenGL REQUIRED COMPONENTS OpenGL EGL)
-  target_link_libraries(ilmendur
+  target_link_libraries(ilmendur-core
     Threads::Threads
     ${CMAKE_DL_LIBS} rt)
 endif()
 
-target_link_libraries(ilmendur
+target_link_libraries(ilmendur-core
   ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libpugixml.a
   ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libpng16.a
   ${ILMENDUR_DEPS_INSTALL_DIR}/lib/libz.a
@@ -0,0 +1,136 @@
+#include "aabb.hpp"
+#include <cassert>
+#include <climits>
+
+#ifdef ILMENDUR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/// Sets the corners so that the box does not overlap anything.
+void AABB::emptyBox(int& x0, int& y0, int& x1, int& y1)
+{
+    x0 = INT_MAX;
+    y0 = INT_MAX;
+    x1 = INT_MIN;
+    y1 = INT_MIN;
+}
+
+/* Mask of the `count` (at most 32) candidates starting at `start`. */
+static uint32_t overlapWordScalar(int bx0, int by0, int bx1, int by1, size_t start, size_t count, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1)
+{
+    uint32_t bits = 0;
+    for(size_t i=0; i < count; i++) {
+        size_t j = start + i;
+        bool hit = p_x1[j] > bx0 && bx1 > p_x0[j] && p_y1[j] > by0 && by1 > p_y0[j];
+        bits |= static_cast<uint32_t>(hit) << i;
+    }
+    return bits;
+}
+
+#ifdef ILMENDUR_SIMD_X86
+/// 32 candidates starting at `start`, four per instruction.
+__attribute__((target("sse2")))
+static uint32_t overlapWordSSE2(int bx0, int by0, int bx1, int by1, size_t start, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1)
+{
+    const __m128i vbx0 = _mm_set1_epi32(bx0);
+    const __m128i vby0 = _mm_set1_epi32(by0);
+    const __m128i vbx1 = _mm_set1_epi32(bx1);
+    const __m128i vby1 = _mm_set1_epi32(by1);
+
+    uint32_t bits = 0;
+    for(size_t i=0; i < 32; i += 4) {
+        size_t j = start + i;
+        __m128i hit = _mm_and_si128(
+            _mm_and_si128(_mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_x1 + j)), vbx0),
+                          _mm_cmpgt_epi32(vbx1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_x0 + j)))),
+            _mm_and_si128(_mm_cmpgt_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_y1 + j)), vby0),
+                          _mm_cmpgt_epi32(vby1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_y0 + j)))));
+        bits |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(hit))) << i;
+    }
+    return bits;
+}
+
+/// 32 candidates starting at `start`, eight per instruction.
+__attribute__((target("avx2")))
+static uint32_t overlapWordAVX2(int bx0, int by0, int bx1, int by1, size_t start, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1)
+{
+    const __m256i vbx0 = _mm256_set1_epi32(bx0);
+    const __m256i vby0 = _mm256_set1_epi32(by0);
+    const __m256i vbx1 = _mm256_set1_epi32(bx1);
+    const __m256i vby1 = _mm256_set1_epi32(by1);
+
+    uint32_t bits = 0;
+    for(size_t i=0; i < 32; i += 8) {
+        size_t j = start + i;
+        __m256i hit = _mm256_and_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_x1 + j)), vbx0),
+                             _mm256_cmpgt_epi32(vbx1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_x0 + j)))),
+            _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_y1 + j)), vby0),
+                             _mm256_cmpgt_epi32(vby1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_y0 + j)))));
+        bits |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(hit))) << i;
+    }
+    return bits;
+}
+#endif
+
+/**
+ * Tests `box` against the `count` candidate boxes with the fastest
+ * kernel the CPU supports and writes maskWords(`count`) words to
+ * `p_mask`. See the module documentation.
+ */
+void AABB::overlapMask(const SDL_Rect& box, size_t count, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1, uint32_t* p_mask)
+{
+    overlapMask(SIMD::bestLevel(), box, count, p_x0, p_y0, p_x1, p_y1, p_mask);
+}
+
+/**
+ * Like the other overload, but uses the kernel for `l`, which must be
+ * supported (see SIMD::isSupported()). Only useful for verification
+ * and benchmarking.
+ */
+void AABB::overlapMask(SIMD::level l, const SDL_Rect& box, size_t count, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1, uint32_t* p_mask)
+{
+    assert(SIMD::isSupported(l));
+
+    const size_t words = maskWords(count);
+    if (box.w <= 0 || box.h <= 0) { // Empty boxes do not overlap anything
+        for(size_t w=0; w < words; w++) {
+            p_mask[w] = 0;
+        }
+        return;
+    }
+
+    const int bx0 = box.x;
+    const int by0 = box.y;
+    const int bx1 = box.x + box.w;
+    const int by1 = box.y + box.h;
+    for(size_t w=0; w < words; w++) {
+        size_t start = w * 32;
+        if (start + 32 > count) { // Partial last word
+            p_mask[w] = overlapWordScalar(bx0, by0, bx1, by1, start, count - start, p_x0, p_y0, p_x1, p_y1);
+            continue;
+        }
+
+        switch (l) {
+        case SIMD::level::scalar:
+            p_mask[w] = overlapWordScalar(bx0, by0, bx1, by1, start, 32, p_x0, p_y0, p_x1, p_y1);
+            break;
+        case SIMD::level::sse2:
+#ifdef ILMENDUR_SIMD_X86
+            p_mask[w] = overlapWordSSE2(bx0, by0, bx1, by1, start, p_x0, p_y0, p_x1, p_y1);
+#else
+            p_mask[w] = overlapWordScalar(bx0, by0, bx1, by1, start, 32, p_x0, p_y0, p_x1, p_y1);
+#endif
+            break;
+        case SIMD::level::avx2:
+#ifdef ILMENDUR_SIMD_X86
+            p_mask[w] = overlapWordAVX2(bx0, by0, bx1, by1, start, p_x0, p_y0, p_x1, p_y1);
+#else
+            p_mask[w] = overlapWordScalar(bx0, by0, bx1, by1, start, 32, p_x0, p_y0, p_x1, p_y1);
+#endif
+            break;
+        } // No default to provoke compiler warnings on missing elements
+    }
+}
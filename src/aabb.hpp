@@ -0,0 +1,32 @@
+#ifndef ILMENDUR_AABB_HPP
+#define ILMENDUR_AABB_HPP
+#include "simd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <SDL2/SDL.h>
+
+/**
+ * Overlap tests of one axis-aligned box against many boxes at once.
+ * The candidate boxes are given in struct-of-arrays layout as their
+ * corners: `x0`/`y0` is the top left corner (inclusive) and `x1`/`y1`
+ * the bottom right corner (exclusive), i.e. `x1 = x + w`. Empty boxes
+ * must be stored as `x0 = y0 = INT_MAX` and `x1 = y1 = INT_MIN` (see
+ * emptyBox()), so that they never overlap anything.
+ *
+ * The result is a bitmask: bit `i % 32` of `p_mask[i / 32]` is set
+ * if candidate `i` overlaps the box. The test is the same as the one
+ * of SDL_HasIntersection(), so that the two can be used
+ * interchangeably.
+ */
+namespace AABB {
+
+    /// Number of mask words required for `count` candidates.
+    inline size_t maskWords(size_t count) { return (count + 31) / 32; }
+
+    void emptyBox(int& x0, int& y0, int& x1, int& y1);
+
+    void overlapMask(const SDL_Rect& box, size_t count, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1, uint32_t* p_mask);
+    void overlapMask(SIMD::level l, const SDL_Rect& box, size_t count, const int* p_x0, const int* p_y0, const int* p_x1, const int* p_y1, uint32_t* p_mask);
+}
+
+#endif /* ILMENDUR_AABB_HPP */
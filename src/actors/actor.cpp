@@ -3,6 +3,8 @@
 #include "../texture_pool.hpp"
 #include "../scenes/scene.hpp"
 #include "../map.hpp"
+#include "../clock.hpp"
+#include "../render_list.hpp"
 #include <SDL2/SDL.h>
 #include <cassert>
 
@@ -18,22 +20,28 @@ using namespace std;
  * The actor is constructed with the requested graphic, or, if no
  * graphic is requested, it will be invisible. The parameter
  * `graphic` takes the same values as TexturePool's [] operator.
+ *
+ * The new actor adds itself to `p_layer`. Actors are owned by
+ * their map: create them with `map.arena().create<Actor>(...)` and
+ * never delete them yourself.
  */
 Actor::Actor(int id, ObjectLayer* p_layer, const string& graphic)
-    : mp_texinfo(nullptr),
-      m_current_frame(0),
-      m_ani_mode(animation_mode::on_move),
-      m_lookdir(direction::none),
-      m_ani_ticks(0),
-      m_id(id),
-      mp_layer(p_layer),
-      m_move_start(0),
-      m_passed_distance(0.0f),
-      m_total_distance(0.0f)
+    : m_id(id),
+      mp_layer(nullptr),
+      mp_store(nullptr),
+      m_index(0)
 {
+    ActorStore::Row row;
+    row.id = id;
+    p_layer->addActor(this, row);
+
     setGraphic(graphic);
 }
 
+/**
+ * Actors are only destroyed when their map's arena is released,
+ * together with their layer and its ActorStore.
+ */
 Actor::~Actor()
 {
 }
@@ -44,26 +52,47 @@ Actor::~Actor()
  */
 void Actor::setGraphic(const string& graphic)
 {
-    if (graphic.empty()) {
-        mp_texinfo = nullptr;
-    } else {
-        mp_texinfo = Ilmendur::instance().texturePool()[graphic];
+    TextureInfo* p_texinfo = nullptr;
+    if (!graphic.empty()) {
+        p_texinfo = Ilmendur::instance().texturePool()[graphic];
     }
 
     // Triggering this assert means that a non-existant graphics file was requested.
     if (!graphic.empty()) {
-        assert(mp_texinfo);
+        assert(p_texinfo);
+    }
+
+    mp_store->texinfo[m_index] = p_texinfo;
+
+    // The collision box is defined by the graphic's INI file.
+    if (p_texinfo) {
+        setCollisionShape(SDL_Rect{p_texinfo->collx - p_texinfo->origx,
+                                   p_texinfo->colly - p_texinfo->origy,
+                                   p_texinfo->collw,
+                                   p_texinfo->collh});
+    } else {
+        setCollisionShape(SDL_Rect{0, 0, 0, 0});
     }
 }
 
 void Actor::setAnimationMode(animation_mode mode)
 {
-    m_ani_mode = mode;
+    mp_store->ani_mode[m_index] = mode;
+}
+
+/**
+ * Sets the collision box relative to the actor's position. Visible
+ * actors get this from their graphic; subclasses for invisible
+ * actors that should collide set it in their constructors.
+ */
+void Actor::setCollisionShape(const SDL_Rect& shape)
+{
+    mp_store->collshape[m_index] = shape;
 }
 
 bool Actor::isMoving()
 {
-    return m_move_start != 0;
+    return mp_store->isMoving(m_index);
 }
 
 /**
@@ -75,7 +104,7 @@ bool Actor::isMoving()
  */
 void Actor::moveRelative(direction dir, int fields)
 {
-    Vector2f target = m_pos;
+    Vector2f target = position();
     switch (dir) {
     case direction::up:
         target.y -= TILEWIDTH * fields;
@@ -103,7 +132,7 @@ void Actor::moveRelative(direction dir, int fields)
  */
 void Actor::moveForward(int fields)
 {
-    moveRelative(m_lookdir, fields);
+    moveRelative(lookDirection(), fields);
 }
 
 /**
@@ -114,8 +143,9 @@ void Actor::moveForward(int fields)
  */
 void Actor::moveBackward(int fields)
 {
-    Vector2f target = m_pos;
-    switch (m_lookdir) {
+    Vector2f target = position();
+    direction ldir = lookDirection();
+    switch (ldir) {
     case direction::up:
         target.y += TILEWIDTH * fields;
         break;
@@ -136,10 +166,9 @@ void Actor::moveBackward(int fields)
      * of moveTo(), but moveTo() won't tamper with the looking
      * direction if it is set to direction::none. So temporaryly
      * do exactly that - the update function does not change it anymore. */
-    direction ldir = m_lookdir;
-    m_lookdir = direction::none;
+    mp_store->lookdir[m_index] = direction::none;
     moveTo(target, TILEWIDTH);
-    m_lookdir = ldir;
+    mp_store->lookdir[m_index] = ldir;
 }
 
 /**
@@ -147,66 +176,83 @@ void Actor::moveBackward(int fields)
  * the moving speed in pixels per second. For reference, a value of 32.0f
  * will make the actor cross one field in one second.
  *
- * Under the hood, this function calls the more general moveTo()
- * overload with a constant velocity alteration function that always
- * returns `velocity`.
+ * This is a shorthand for moveTo() with MotionCurve::constant().
  */
 void Actor::moveTo(const Vector2f& targetpos, float velocity)
 {
-    moveTo(targetpos, [velocity](uint64_t){return velocity;});
+    moveTo(targetpos, MotionCurve::constant(velocity));
 }
 
 /**
- * This is the generalised version of moveTo(). It allows to use any
- * function to distribute the change of velocity over the movement
- * operation. The function takes time passed (in milliseconds) since
- * the call to moveTo() and should return the velocity of the actor in
- * that point in time, in pixels per second (or, to me more precise:
- * the length of the velocity vector). It is called once per frame, so
- * try to keep it performant.
- *
- * You want to use this version of moveTo() if the simple linear function
- * applied by the other moveTo() function is insufficient, for instance
- * because you want a stone to slowly stop rolling instead of progressing
- * further in a linear fashion. In that case, setting `velfunc` to something
- * involving e.g. the tanh() function could be useful.
+ * This is the generalised version of moveTo(). `curve` describes how
+ * the velocity changes over the movement operation, for instance
+ * MotionCurve::tanhDecay() if you want a stone to slowly stop rolling
+ * instead of progressing further in a linear fashion. See MotionCurve
+ * for the available curves.
  *
  * It is possible to pass INFINITY as members of `targetpos`. In that case,
  * the actor is going to continue moving until stopMoving() is called. Beware
- * that your `velfunc` should handle this case then. Do not pass INFINITY for
+ * that your `curve` should not fall to zero then. Do not pass INFINITY for
  * only one component, unless that other component is zero. Doing so will
  * cause an exception when the function tries to normalise the vector.
  */
+void Actor::moveTo(const Vector2f& targetpos, const MotionCurve& curve)
+{
+    assert(curve.type != MotionCurve::curve_type::custom);
+    startMoving(targetpos, curve, nullptr);
+}
+
+/**
+ * Like the MotionCurve version of moveTo(), but uses an arbitrary
+ * function for the velocity. The function takes time passed (in
+ * milliseconds) since the call to moveTo() and should return the
+ * velocity of the actor in that point in time, in pixels per second.
+ * It is called once per frame from the main thread.
+ *
+ * Prefer the MotionCurve version where possible; the predefined curves
+ * are evaluated for all actors in one batch and do not allocate.
+ */
 void Actor::moveTo(const Vector2f& targetpos, function<float(uint64_t)> velfunc)
 {
-    if (m_pos == targetpos) {
+    MotionCurve curve = MotionCurve::constant(0.0f);
+    curve.type = MotionCurve::curve_type::custom;
+    startMoving(targetpos, curve, move(velfunc));
+}
+
+/// Common implementation of the moveTo() overloads.
+void Actor::startMoving(const Vector2f& targetpos, const MotionCurve& curve, function<float(uint64_t)> velfunc)
+{
+    ActorStore& store = *mp_store;
+    const Vector2f& pos = store.pos[m_index];
+    if (pos == targetpos) {
         return;
     }
 
-    Vector2f translation(targetpos.x - m_pos.x, targetpos.y - m_pos.y);
-    m_passed_distance = 0.0f;
-    m_total_distance  = translation.length();
-    m_movedir         = translation.normalise();
-    m_targetpos       = targetpos;
-    m_move_start      = SDL_GetTicks64();
-    m_velfunc         = velfunc;
+    Vector2f translation(targetpos.x - pos.x, targetpos.y - pos.y);
+    store.passed_distance[m_index] = 0.0f;
+    store.total_distance[m_index]  = translation.length();
+    store.movedir[m_index]         = translation.normalise();
+    store.targetpos[m_index]       = targetpos;
+    store.move_start[m_index]      = Clock::ticks();
+    store.setCurve(m_index, curve, move(velfunc));
 
-    if (m_lookdir != direction::none) { // Actors that do not look anywhere do not need their look direction to be changed.
-        float xdist = targetpos.x - m_pos.x;
-        float ydist = targetpos.y - m_pos.y;
+    direction& lookdir = store.lookdir[m_index];
+    if (lookdir != direction::none) { // Actors that do not look anywhere do not need their look direction to be changed.
+        float xdist = targetpos.x - pos.x;
+        float ydist = targetpos.y - pos.y;
 
         if (!float_equal(fabs(xdist), fabs(ydist))) { // Do not change lookdir if the X and Y distance covered are about equal.
             if (fabs(xdist) > fabs(ydist)) {
                 if (xdist > 0) {
-                    m_lookdir = direction::right;
+                    lookdir = direction::right;
                 } else {
-                    m_lookdir = direction::left;
+                    lookdir = direction::left;
                 }
             } else if (fabs(xdist) < fabs(ydist)) {
                 if (ydist > 0) {
-                    m_lookdir = direction::down;
+                    lookdir = direction::down;
                 } else {
-                    m_lookdir = direction::up;
+                    lookdir = direction::up;
                 }
             }
         }
@@ -221,24 +267,12 @@ void Actor::moveTo(const Vector2f& targetpos, function<float(uint64_t)> velfunc)
  */
 void Actor::stopMoving()
 {
-    std::function<float(uint64_t)> emptyfunc;
-    m_velfunc.swap(emptyfunc); // Clear the function object
-    m_movedir.clear();
-    m_targetpos.clear();
-    m_move_start      = 0;
-    m_passed_distance = 0.0f;
-    m_total_distance  = 0.0f;
-
-    // Ensure the animation always ends with the straight up graphic,
-    // unless this actor is permanently animated anyway.
-    if (m_ani_mode == animation_mode::on_move) {
-        setFrame(0);
-    }
+    mp_store->stopMoving(m_index);
 }
 
 void Actor::turn(direction dir)
 {
-    m_lookdir = dir;
+    mp_store->lookdir[m_index] = dir;
 }
 
 /**
@@ -247,89 +281,42 @@ void Actor::turn(direction dir)
  */
 void Actor::warp(const Vector2f& targetpos)
 {
-    m_pos = targetpos;
-}
-
-void Actor::setFrame(unsigned int frameno)
-{
-    m_current_frame = frameno;
-}
-
-void Actor::nextFrame()
-{
-    if (++m_current_frame >= mp_texinfo->frames) {
-        m_current_frame = 0;
-    }
+    mp_store->pos[m_index] = targetpos;
 }
 
+/**
+ * Per-frame hook for subclasses. ObjectLayer::update() calls it
+ * after it advanced the movement and animation of all its actors
+ * (see ActorStore). The default implementation does nothing.
+ */
 void Actor::update()
 {
-    // Progress movement, if any
-    if (isMoving()) {
-        move();
-    }
-
-    // Update frame for animation if requested
-    switch (m_ani_mode) {
-    case animation_mode::always:
-        if (++m_ani_ticks >= ILMENDUR_TARGET_FRAMERATE * (mp_texinfo->animation_time / 1000.0)) {
-            nextFrame();
-            m_ani_ticks = 0;
-        }
-        break;
-    case animation_mode::on_move:
-        if (isMoving()) {
-            if (++m_ani_ticks >= ILMENDUR_TARGET_FRAMERATE * (mp_texinfo->animation_time / 1000.0)) {
-                nextFrame();
-                m_ani_ticks = 0;
-            }
-        }
-        break;
-    case animation_mode::never:
-        break;
-    } // No default to provoke compiler warnings on missing elements
 }
 
 /**
- * Returns the draw rectangle, in world coordinates.
+ * Returns the draw rectangle, in world coordinates. This is empty for
+ * invisible actors; subclasses drawing themselves override it.
  */
 SDL_Rect Actor::drawRect() const
 {
-    SDL_Rect result;
-    result.w = mp_texinfo->stridex;
-    result.h = mp_texinfo->stridey;
-    result.x = m_pos.x - mp_texinfo->origx;
-    result.y = m_pos.y - mp_texinfo->origy;
-    return result;
-}
+    const TextureInfo* p_texinfo = mp_store->texinfo[m_index];
+    const Vector2f& pos = mp_store->pos[m_index];
+    if (!p_texinfo) {
+        return SDL_Rect{static_cast<int>(pos.x), static_cast<int>(pos.y), 0, 0};
+    }
 
-/**
- * Returns the collision rectangle, in world coordinates.
- * Unless overridden by a subclass, invisible actors do not
- * have a collision box; for them, this method returns a
- * rectangle with width and height set to zero and X and Y
- * set to the position().
- */
-SDL_Rect Actor::collisionBox() const
-{
     SDL_Rect result;
-    if (mp_texinfo) {
-        result.w = mp_texinfo->collw;
-        result.h = mp_texinfo->collh;
-        result.x = m_pos.x - mp_texinfo->origx + mp_texinfo->collx;
-        result.y = m_pos.y - mp_texinfo->origy + mp_texinfo->colly;
-    } else {
-        result.w = 0;
-        result.h = 0;
-        result.x = m_pos.x;
-        result.y = m_pos.y;
-    }
+    result.w = p_texinfo->stridex;
+    result.h = p_texinfo->stridey;
+    result.x = pos.x - p_texinfo->origx;
+    result.y = pos.y - p_texinfo->origy;
     return result;
 }
 
-void Actor::draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview)
+void Actor::draw(RenderList* p_stage, const SDL_Rect* p_camview)
 {
-    if (!mp_texinfo) { // Invisible actor
+    const TextureInfo* p_texinfo = mp_store->texinfo[m_index];
+    if (!p_texinfo) { // Invisible actor
         return;
     }
 
@@ -339,52 +326,35 @@ void Actor::draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview)
         return;
     }
 
-    // TODO: Honor p_camview width and height for scaling purposes.
+    // View coordinates; the renderer scales them to the camera's zoom
     destrect.x -= p_camview->x;
     destrect.y -= p_camview->y;
 
     SDL_Rect srcrect;
-    srcrect.x  = m_current_frame * mp_texinfo->stridex;
-    srcrect.w  = mp_texinfo->stridex;
-    srcrect.h  = mp_texinfo->stridex;
-    if (mp_texinfo->stridey == mp_texinfo->height) {
+    srcrect.x  = mp_store->frame[m_index] * p_texinfo->stridex;
+    srcrect.w  = p_texinfo->stridex;
+    srcrect.h  = p_texinfo->stridex;
+    if (p_texinfo->stridey == p_texinfo->height) {
         srcrect.y = 0;
     } else {
-        switch (m_lookdir) {
+        switch (mp_store->lookdir[m_index]) {
         case direction::none:
         case direction::up: // fall-through
             srcrect.y = 0;
             break;
         case direction::right:
-            srcrect.y = mp_texinfo->stridey;
+            srcrect.y = p_texinfo->stridey;
             break;
         case direction::down:
-            srcrect.y = mp_texinfo->stridey * 2;
+            srcrect.y = p_texinfo->stridey * 2;
             break;
         case direction::left:
-            srcrect.y = mp_texinfo->stridey * 3;
+            srcrect.y = p_texinfo->stridey * 3;
             break;
         }
     }
 
-    SDL_RenderCopy(p_stage, mp_texinfo->p_texture, &srcrect, &destrect);
-}
-
-void Actor::move()
-{
-    float distance_per_frame = m_velfunc(SDL_GetTicks64() - m_move_start) / static_cast<float>(ILMENDUR_TARGET_FRAMERATE);
-    m_passed_distance += distance_per_frame;
-
-    if (m_passed_distance >= m_total_distance) {
-        m_pos = m_targetpos;
-        stopMoving();
-    } else {
-        Vector2f translation = m_movedir * distance_per_frame;
-        m_pos.x += translation.x;
-        m_pos.y += translation.y;
-    }
-
-    // Note: Collision checks happen in Map::update().
+    p_stage->copy(p_texinfo->p_texture, &srcrect, &destrect);
 }
 
 /**
@@ -415,19 +385,22 @@ void Actor::interact(Actor*)
  */
 void Actor::antiCollide(Actor* p_actor, const Actor* p_other, const SDL_Rect& intersect)
 {
+    const Vector2f& movedir = p_actor->moveDirection();
+    Vector2f& pos = p_actor->mp_store->pos[p_actor->m_index];
+
     // First, the easy cases: four cardinal directions.
-    if (p_actor->m_movedir.x == 0.0f && p_actor->m_movedir.y < 0.0f) { // North
+    if (movedir.x == 0.0f && movedir.y < 0.0f) { // North
         p_actor->stopMoving();
-        p_actor->m_pos.y += intersect.h;
-    } else if (p_actor->m_movedir.x > 0.0f && p_actor->m_movedir.y == 0.0f) { // East
+        pos.y += intersect.h;
+    } else if (movedir.x > 0.0f && movedir.y == 0.0f) { // East
         p_actor->stopMoving();
-        p_actor->m_pos.x -= intersect.w;
-    } else if (p_actor->m_movedir.x == 0.0f && p_actor->m_movedir.y > 0.0f) { // South
+        pos.x -= intersect.w;
+    } else if (movedir.x == 0.0f && movedir.y > 0.0f) { // South
         p_actor->stopMoving();
-        p_actor->m_pos.y -= intersect.h;
-    } else if (p_actor->m_movedir.x < 0.0f && p_actor->m_movedir.y == 0.0f) { // West
+        pos.y -= intersect.h;
+    } else if (movedir.x < 0.0f && movedir.y == 0.0f) { // West
         p_actor->stopMoving();
-        p_actor->m_pos.x += intersect.w;
+        pos.x += intersect.w;
     } else { // Something in between. Complicated. (Note: both actors might not be moving at all!)
         /* The below seems to work fairly well. A clean solution would
          * probably generalise into a proper vector-movement based
@@ -437,15 +410,15 @@ void Actor::antiCollide(Actor* p_actor, const Actor* p_other, const SDL_Rect& in
 
         if (intersect.h > intersect.w) {
             if (collrect1.x <= collrect2.x) {
-                p_actor->m_pos.x -= intersect.w;
+                pos.x -= intersect.w;
             } else {
-                p_actor->m_pos.x += intersect.w;
+                pos.x += intersect.w;
             }
         } else {
             if (collrect1.y <= collrect2.y) {
-                p_actor->m_pos.y -= intersect.h;
+                pos.y -= intersect.h;
             } else {
-                p_actor->m_pos.y += intersect.h;
+                pos.y += intersect.h;
             }
         }
         p_actor->stopMoving();
@@ -2,26 +2,33 @@
 #define ILMENDUR_ACTOR_HPP
 #include "../util.hpp"
 #include "../globals.hpp"
+#include "actor_store.hpp"
 #include <cstdint>
 #include <functional>
 #include <string>
 #include <SDL2/SDL.h>
 
 struct TextureInfo;
+class RenderList;
 class Scene;
 class ObjectLayer;
 struct Event;
 
+/**
+ * Handle for one actor on a map layer. The actor's per-frame data
+ * lives in the ActorStore of its layer; see there. Subclasses
+ * implement the type-specific behaviour via the virtual methods.
+ */
 class Actor
 {
 public:
-    enum class animation_mode { never, on_move, always };
+    typedef ::animation_mode animation_mode;
 
     Actor(int id, ObjectLayer* p_layer, const std::string& graphic = "");
     virtual ~Actor();
 
     virtual void update();
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview);
     virtual void handleEvent(const Event& event);
     virtual void interact(Actor* p_other);
 
@@ -32,6 +39,7 @@ public:
 
     bool isMoving();
     void moveTo(const Vector2f& targetpos, float velocity);
+    void moveTo(const Vector2f& targetpos, const MotionCurve& curve);
     void moveTo(const Vector2f& targetpos, std::function<float(uint64_t)> velfunc);
     void moveRelative(direction dir, int fields = 1);
     void moveForward(int fields = 1);
@@ -40,40 +48,31 @@ public:
     void warp(const Vector2f& targetpos);
     void turn(direction dir);
 
-    SDL_Rect drawRect() const;
-    virtual SDL_Rect collisionBox() const;
+    virtual SDL_Rect drawRect() const;
+    inline SDL_Rect collisionBox() const { return mp_store->collisionBox(m_index); }
 
     inline int id() const { return m_id; }
-    inline const Vector2f& position() const { return m_pos; }
-    inline const Vector2f& moveDirection() const { return m_movedir; }
-    inline direction lookDirection() const { return m_lookdir; }
-    inline bool isInvisible() const { return !mp_texinfo; }
-private:
-    void move();
-    void setFrame(unsigned int frameno);
-    void nextFrame();
-
-    TextureInfo* mp_texinfo;
-    int m_current_frame;
-    animation_mode m_ani_mode;
-    direction m_lookdir;
-    int m_ani_ticks;
+    inline const Vector2f& position() const { return mp_store->pos[m_index]; }
+    inline const Vector2f& moveDirection() const { return mp_store->movedir[m_index]; }
+    inline direction lookDirection() const { return mp_store->lookdir[m_index]; }
+    inline bool isInvisible() const { return !mp_store->texinfo[m_index]; }
 
 protected:
+    void setCollisionShape(const SDL_Rect& shape);
+
     int m_id; ///< Map-wide unique ID of this actor.
     ObjectLayer* mp_layer; // Map layer the actor is on (this has an association to the map)
-    Vector2f m_pos;
-    Vector2f m_targetpos;
-    Vector2f m_movedir;
-    uint64_t m_move_start;
-    float m_passed_distance;
-    float m_total_distance;
-    std::function<float(uint64_t)> m_velfunc;
+    ActorStore* mp_store;  // Store of `mp_layer` that holds this actor's data
+    size_t m_index;        // Row in `mp_store`, kept up to date by the store
 
     static void antiCollide(Actor* p_actor, const Actor* p_other, const SDL_Rect& intersect);
 
+private:
+    void startMoving(const Vector2f& targetpos, const MotionCurve& curve, std::function<float(uint64_t)> velfunc);
+
     // For collision checks and mp_map assocation ObjectLayer needs access
     friend class ObjectLayer;
+    friend class ActorStore;
     friend class Map;
 };
 
@@ -0,0 +1,348 @@
+#include "actor_store.hpp"
+#include "actor.hpp"
+#include "integrator.hpp"
+#include "../aabb.hpp"
+#include "../ilmendur.hpp"
+#include "../texture_pool.hpp"
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+/// Creates an empty store whose columns allocate from `p_res`.
+ActorStore::ActorStore(pmr::memory_resource* p_res)
+    : actors(p_res),
+      ids(p_res),
+      pos(p_res),
+      movedir(p_res),
+      targetpos(p_res),
+      move_start(p_res),
+      passed_distance(p_res),
+      total_distance(p_res),
+      curve(p_res),
+      collshape(p_res),
+      box_x0(p_res),
+      box_y0(p_res),
+      box_x1(p_res),
+      box_y1(p_res),
+      texinfo(p_res),
+      frame(p_res),
+      ani_ticks(p_res),
+      ani_mode(p_res),
+      lookdir(p_res),
+      m_custom_velfuncs(p_res),
+      m_free_custom_slots(p_res),
+      m_speed(p_res),
+      m_buckets{std::pmr::vector<uint32_t>(p_res),
+                std::pmr::vector<uint32_t>(p_res),
+                std::pmr::vector<uint32_t>(p_res),
+                std::pmr::vector<uint32_t>(p_res),
+                std::pmr::vector<uint32_t>(p_res)}
+{
+}
+
+/**
+ * Inserts a row for `p_actor` with the values from `row` at the
+ * position corresponding to `row.id`, after any rows with the same
+ * ID. Updates the row indices of all actors behind it and returns
+ * the index of the new row. Leaves `p_actor` itself untouched.
+ */
+size_t ActorStore::insert(Actor* p_actor, const Row& row)
+{
+    size_t index = upper_bound(ids.begin(), ids.end(), row.id) - ids.begin();
+
+    actors.insert(actors.begin() + index, p_actor);
+    ids.insert(ids.begin() + index, row.id);
+    pos.insert(pos.begin() + index, row.pos);
+    movedir.insert(movedir.begin() + index, row.movedir);
+    targetpos.insert(targetpos.begin() + index, row.targetpos);
+    move_start.insert(move_start.begin() + index, row.move_start);
+    passed_distance.insert(passed_distance.begin() + index, row.passed_distance);
+    total_distance.insert(total_distance.begin() + index, row.total_distance);
+    curve.insert(curve.begin() + index, MotionCurve::constant(0.0f));
+    collshape.insert(collshape.begin() + index, row.collshape);
+    box_x0.insert(box_x0.begin() + index, 0);
+    box_y0.insert(box_y0.begin() + index, 0);
+    box_x1.insert(box_x1.begin() + index, 0);
+    box_y1.insert(box_y1.begin() + index, 0);
+    texinfo.insert(texinfo.begin() + index, row.p_texinfo);
+    frame.insert(frame.begin() + index, row.frame);
+    ani_ticks.insert(ani_ticks.begin() + index, row.ani_ticks);
+    ani_mode.insert(ani_mode.begin() + index, row.ani_mode);
+    lookdir.insert(lookdir.begin() + index, row.lookdir);
+
+    for(size_t i=index + 1; i < actors.size(); i++) {
+        actors[i]->m_index = i;
+    }
+
+    setCurve(index, row.curve, row.custom_velfunc);
+    updateBox(index);
+    return index;
+}
+
+/**
+ * Removes row `index` and returns its values. Updates the row
+ * indices of all actors behind it.
+ */
+ActorStore::Row ActorStore::erase(size_t index)
+{
+    assert(index < actors.size());
+
+    Row row;
+    row.id              = ids[index];
+    row.pos             = pos[index];
+    row.movedir         = movedir[index];
+    row.targetpos       = targetpos[index];
+    row.move_start      = move_start[index];
+    row.passed_distance = passed_distance[index];
+    row.total_distance  = total_distance[index];
+    row.curve           = curve[index];
+    row.collshape       = collshape[index];
+    row.p_texinfo       = texinfo[index];
+    row.frame           = frame[index];
+    row.ani_ticks       = ani_ticks[index];
+    row.ani_mode        = ani_mode[index];
+    row.lookdir         = lookdir[index];
+
+    if (row.curve.type == MotionCurve::curve_type::custom) {
+        row.custom_velfunc = move(m_custom_velfuncs[row.curve.custom_slot]);
+        releaseCustomCurve(index);
+        row.curve.custom_slot = 0;
+    }
+
+    actors.erase(actors.begin() + index);
+    ids.erase(ids.begin() + index);
+    pos.erase(pos.begin() + index);
+    movedir.erase(movedir.begin() + index);
+    targetpos.erase(targetpos.begin() + index);
+    move_start.erase(move_start.begin() + index);
+    passed_distance.erase(passed_distance.begin() + index);
+    total_distance.erase(total_distance.begin() + index);
+    curve.erase(curve.begin() + index);
+    collshape.erase(collshape.begin() + index);
+    box_x0.erase(box_x0.begin() + index);
+    box_y0.erase(box_y0.begin() + index);
+    box_x1.erase(box_x1.begin() + index);
+    box_y1.erase(box_y1.begin() + index);
+    texinfo.erase(texinfo.begin() + index);
+    frame.erase(frame.begin() + index);
+    ani_ticks.erase(ani_ticks.begin() + index);
+    ani_mode.erase(ani_mode.begin() + index);
+    lookdir.erase(lookdir.begin() + index);
+
+    for(size_t i=index; i < actors.size(); i++) {
+        actors[i]->m_index = i;
+    }
+
+    return row;
+}
+
+/// Removes all rows. The actors are not deleted.
+void ActorStore::clear()
+{
+    actors.clear();
+    ids.clear();
+    pos.clear();
+    movedir.clear();
+    targetpos.clear();
+    move_start.clear();
+    passed_distance.clear();
+    total_distance.clear();
+    curve.clear();
+    collshape.clear();
+    box_x0.clear();
+    box_y0.clear();
+    box_x1.clear();
+    box_y1.clear();
+    texinfo.clear();
+    frame.clear();
+    ani_ticks.clear();
+    ani_mode.clear();
+    lookdir.clear();
+    m_custom_velfuncs.clear();
+    m_free_custom_slots.clear();
+}
+
+/**
+ * First movement pass: fills the speed scratch column with the
+ * current speed of each row, zero for rows that are not moving.
+ * `now` is the current Clock time. The moving rows are sorted into
+ * buckets by curve type first, so that each curve formula runs in
+ * its own loop. The custom velocity functions are called serially on
+ * this thread, so they need not be thread-safe.
+ *
+ * Progressing the movement of all actors by one frame consists of
+ * calling this, integrate() for all rows, and finishMovement(), in
+ * this order.
+ */
+void ActorStore::evaluateCurves(uint64_t now)
+{
+    const size_t count = actors.size();
+    m_speed.assign(count, 0.0f);
+    for(auto& bucket: m_buckets) {
+        bucket.clear();
+    }
+
+    for(size_t i=0; i < count; i++) {
+        if (move_start[i] != 0) {
+            m_buckets[static_cast<size_t>(curve[i].type)].push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    float* p_speed = m_speed.data();
+    for(uint32_t i: m_buckets[static_cast<size_t>(MotionCurve::curve_type::constant)]) {
+        p_speed[i] = curve[i].v[0];
+    }
+    for(uint32_t i: m_buckets[static_cast<size_t>(MotionCurve::curve_type::ease_in_out)]) {
+        p_speed[i] = curve[i].evaluateEaseInOut(static_cast<float>(now - move_start[i]));
+    }
+    for(uint32_t i: m_buckets[static_cast<size_t>(MotionCurve::curve_type::tanh_decay)]) {
+        p_speed[i] = curve[i].evaluateTanhDecay(static_cast<float>(now - move_start[i]));
+    }
+    for(uint32_t i: m_buckets[static_cast<size_t>(MotionCurve::curve_type::spline)]) {
+        p_speed[i] = curve[i].evaluateSpline(static_cast<float>(now - move_start[i]));
+    }
+    for(uint32_t i: m_buckets[static_cast<size_t>(MotionCurve::curve_type::custom)]) {
+        p_speed[i] = m_custom_velfuncs[curve[i].custom_slot](now - move_start[i]);
+    }
+}
+
+/**
+ * Second movement pass: advances the positions of the rows
+ * [`begin`; `end`) by the distance covered at the speed calculated
+ * by evaluateCurves(), using the SIMD kernels of the Integrator
+ * module.
+ */
+void ActorStore::integrate(size_t begin, size_t end)
+{
+    assert(begin <= end && end <= m_speed.size());
+    Integrator::integrate(end - begin, m_speed.data() + begin, passed_distance.data() + begin, pos.data() + begin, movedir.data() + begin);
+}
+
+/**
+ * Last movement pass: stops all actors that reached their target.
+ * Not range-based because stopMoving() may release a custom curve.
+ */
+void ActorStore::finishMovement()
+{
+    const size_t count = actors.size();
+    for(size_t i=0; i < count; i++) {
+        if (move_start[i] != 0 && passed_distance[i] >= total_distance[i]) {
+            pos[i] = targetpos[i];
+            stopMoving(i);
+        }
+    }
+
+    // Note: Collision checks happen in ObjectLayer::checkCollisions().
+}
+
+/// Advances the sprite animation frames of the visible actors in the rows [`begin`; `end`) by one frame.
+void ActorStore::advanceAnimation(size_t begin, size_t end)
+{
+    assert(begin <= end && end <= actors.size());
+    for(size_t i=begin; i < end; i++) {
+        const TextureInfo* p_texinfo = texinfo[i];
+        if (!p_texinfo) {
+            continue;
+        }
+
+        bool animate = false;
+        switch (ani_mode[i]) {
+        case animation_mode::always:
+            animate = true;
+            break;
+        case animation_mode::on_move:
+            animate = move_start[i] != 0;
+            break;
+        case animation_mode::never:
+            break;
+        } // No default to provoke compiler warnings on missing elements
+
+        if (animate && ++ani_ticks[i] >= ILMENDUR_TARGET_FRAMERATE * (p_texinfo->animation_time / 1000.0)) {
+            if (++frame[i] >= p_texinfo->frames) {
+                frame[i] = 0;
+            }
+            ani_ticks[i] = 0;
+        }
+    }
+}
+
+/**
+ * Stops the movement of the actor in row `index`.
+ * See Actor::stopMoving().
+ */
+void ActorStore::stopMoving(size_t index)
+{
+    setCurve(index, MotionCurve::constant(0.0f));
+    movedir[index].clear();
+    targetpos[index].clear();
+    move_start[index]      = 0;
+    passed_distance[index] = 0.0f;
+    total_distance[index]  = 0.0f;
+
+    // Ensure the animation always ends with the straight up graphic,
+    // unless this actor is permanently animated anyway.
+    if (ani_mode[index] == animation_mode::on_move) {
+        frame[index] = 0;
+    }
+}
+
+/**
+ * Sets the motion curve of row `index`. For custom curves, pass the
+ * function as `custom_velfunc`; it is kept on the side until the
+ * curve is replaced.
+ */
+void ActorStore::setCurve(size_t index, const MotionCurve& new_curve, function<float(uint64_t)> custom_velfunc)
+{
+    releaseCustomCurve(index);
+    curve[index] = new_curve;
+
+    if (new_curve.type == MotionCurve::curve_type::custom) {
+        assert(custom_velfunc);
+
+        uint32_t slot;
+        if (m_free_custom_slots.empty()) {
+            slot = static_cast<uint32_t>(m_custom_velfuncs.size());
+            m_custom_velfuncs.push_back(move(custom_velfunc));
+        } else {
+            slot = m_free_custom_slots.back();
+            m_free_custom_slots.pop_back();
+            m_custom_velfuncs[slot] = move(custom_velfunc);
+        }
+        curve[index].custom_slot = slot;
+    }
+}
+
+/// Frees the custom function slot of row `index`, if it has one.
+void ActorStore::releaseCustomCurve(size_t index)
+{
+    MotionCurve& old_curve = curve[index];
+    if (old_curve.type == MotionCurve::curve_type::custom) {
+        m_custom_velfuncs[old_curve.custom_slot] = nullptr;
+        m_free_custom_slots.push_back(old_curve.custom_slot);
+        old_curve = MotionCurve::constant(0.0f);
+    }
+}
+
+/// Recalculates the cached collision boxes of all rows.
+void ActorStore::updateBoxes()
+{
+    const size_t count = actors.size();
+    for(size_t i=0; i < count; i++) {
+        updateBox(i);
+    }
+}
+
+/// Recalculates the cached collision box of row `index` from collisionBox().
+void ActorStore::updateBox(size_t index)
+{
+    SDL_Rect box = collisionBox(index);
+    if (box.w <= 0 || box.h <= 0) {
+        AABB::emptyBox(box_x0[index], box_y0[index], box_x1[index], box_y1[index]);
+    } else {
+        box_x0[index] = box.x;
+        box_y0[index] = box.y;
+        box_x1[index] = box.x + box.w;
+        box_y1[index] = box.y + box.h;
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef ILMENDUR_ACTOR_STORE_HPP
+#define ILMENDUR_ACTOR_STORE_HPP
+#include "../util.hpp"
+#include "../globals.hpp"
+#include "motion_curve.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <vector>
+#include <SDL2/SDL.h>
+
+class Actor;
+struct TextureInfo;
+
+enum class animation_mode { never, on_move, always };
+
+/**
+ * Struct-of-arrays storage for the per-frame data of all actors on
+ * one ObjectLayer: position and motion, collision shape, and sprite
+ * state. Each column holds one value per actor; row `i` belongs to
+ * the actor `actors[i]`. Rows are kept sorted by actor ID, which
+ * is the order ObjectLayer has always guaranteed for its actors.
+ *
+ * Actor instances are thin handles onto their row (Actor::m_index),
+ * used for scripting and for the per-type behaviour implemented in
+ * Actor subclasses. The store keeps the handles' row indices up to
+ * date when rows are inserted or erased. The hot per-frame passes
+ * (the movement and animation passes, and the collision checks of
+ * ObjectLayer) iterate the columns linearly instead of chasing
+ * Actor pointers across the heap.
+ *
+ * The passes that take a row range (integrate(), advanceAnimation())
+ * only touch the rows in that range and may run in parallel on
+ * disjoint ranges; see ObjectLayer::advanceActors(). All other
+ * methods must not run concurrently with anything else on the store,
+ * nor with any other store allocating from the same memory resource.
+ * In particular, evaluateCurves() calls the custom velocity functions
+ * on the calling thread, which is the main thread in the game.
+ */
+class ActorStore
+{
+public:
+    /// All data of one row; used to create rows and to move them between stores.
+    struct Row
+    {
+        int id = 0;
+        Vector2f pos;
+        Vector2f movedir;
+        Vector2f targetpos;
+        uint64_t move_start = 0;
+        float passed_distance = 0.0f;
+        float total_distance = 0.0f;
+        MotionCurve curve = MotionCurve::constant(0.0f);
+        std::function<float(uint64_t)> custom_velfunc; ///< Only for custom curves
+        SDL_Rect collshape = {0, 0, 0, 0};
+        TextureInfo* p_texinfo = nullptr;
+        int frame = 0;
+        int ani_ticks = 0;
+        animation_mode ani_mode = animation_mode::on_move;
+        direction lookdir = direction::none;
+    };
+
+    ActorStore(std::pmr::memory_resource* p_res = std::pmr::get_default_resource());
+
+    size_t insert(Actor* p_actor, const Row& row);
+    Row erase(size_t index);
+    void clear();
+    inline size_t size() const { return actors.size(); }
+
+    void evaluateCurves(uint64_t now);
+    void integrate(size_t begin, size_t end);
+    void finishMovement();
+    void advanceAnimation(size_t begin, size_t end);
+    void setCurve(size_t index, const MotionCurve& curve, std::function<float(uint64_t)> custom_velfunc = nullptr);
+    void stopMoving(size_t index);
+    void updateBoxes();
+    void updateBox(size_t index);
+
+    /// True if the actor in row `index` is currently moving.
+    inline bool isMoving(size_t index) const { return move_start[index] != 0; }
+
+    /**
+     * Collision box of row `index` in world coordinates. Empty
+     * (zero width and height) for actors without a collision shape.
+     */
+    inline SDL_Rect collisionBox(size_t index) const
+    {
+        const SDL_Rect& shape = collshape[index];
+        return SDL_Rect{static_cast<int>(pos[index].x + shape.x),
+                        static_cast<int>(pos[index].y + shape.y),
+                        shape.w,
+                        shape.h};
+    }
+
+    // Identity
+    std::pmr::vector<Actor*> actors;
+    std::pmr::vector<int> ids;
+
+    // Position and motion; see Actor::moveTo()
+    std::pmr::vector<Vector2f> pos;
+    std::pmr::vector<Vector2f> movedir;
+    std::pmr::vector<Vector2f> targetpos;
+    std::pmr::vector<uint64_t> move_start; ///< Zero if not moving
+    std::pmr::vector<float> passed_distance;
+    std::pmr::vector<float> total_distance;
+    std::pmr::vector<MotionCurve> curve;
+
+    // Collision box relative to `pos`
+    std::pmr::vector<SDL_Rect> collshape;
+
+    /* Cached collision boxes in world coordinates as AABB corners, for
+     * the SIMD overlap tests; see AABB. Only valid after updateBoxes()
+     * or updateBox() if `pos` or `collshape` changed. */
+    std::pmr::vector<int> box_x0;
+    std::pmr::vector<int> box_y0;
+    std::pmr::vector<int> box_x1;
+    std::pmr::vector<int> box_y1;
+
+    // Sprite
+    std::pmr::vector<TextureInfo*> texinfo; ///< nullptr for invisible actors
+    std::pmr::vector<int> frame;
+    std::pmr::vector<int> ani_ticks;
+    std::pmr::vector<animation_mode> ani_mode;
+    std::pmr::vector<direction> lookdir;
+
+private:
+    void releaseCustomCurve(size_t index);
+
+    // Functions of custom curves, see MotionCurve::custom_slot
+    std::pmr::vector<std::function<float(uint64_t)>> m_custom_velfuncs;
+    std::pmr::vector<uint32_t> m_free_custom_slots;
+
+    // Scratch space of the movement passes
+    std::pmr::vector<float> m_speed;
+    std::pmr::vector<uint32_t> m_buckets[5]; ///< Moving rows per MotionCurve::curve_type
+};
+
+#endif /* ILMENDUR_ACTOR_STORE_HPP */
@@ -8,7 +8,7 @@ CollisionBox::CollisionBox(int id, ObjectLayer* p_layer, SDL_Rect box)
     : Actor(id, p_layer)
 {
     warp(Vector2f(box.x, box.y));
-    m_collbox = box;
+    setCollisionShape(SDL_Rect{0, 0, box.w, box.h});
 }
 
 CollisionBox::~CollisionBox()
@@ -20,16 +20,11 @@ void CollisionBox::update()
     // The collision box does nothing on update.
 }
 
-void CollisionBox::draw(SDL_Renderer*, const SDL_Rect*)
+void CollisionBox::draw(RenderList*, const SDL_Rect*)
 {
     // Collision boxes are not drawn, they are invisible.
 }
 
-SDL_Rect CollisionBox::collisionBox() const
-{
-    return m_collbox;
-}
-
 void CollisionBox::handleEvent(const Event& event)
 {
     if (event.type == Event::Type::collision) {
@@ -9,12 +9,8 @@ public:
     virtual ~CollisionBox();
 
     virtual void update();
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview);
     virtual void handleEvent(const Event& event);
-
-    virtual SDL_Rect collisionBox() const;
-private:
-    SDL_Rect m_collbox;
 };
 
 #endif /* ILMENDUR_COLLBOX_HPP */
@@ -0,0 +1,45 @@
+#include "draw_order.hpp"
+#include <algorithm>
+
+using namespace std;
+
+/* More new rows than one in this many make sort() fall back to std::sort. */
+#define NEW_ROWS_DIVISOR 8
+
+/**
+ * True if row `a` is to be drawn before row `b`.
+ */
+bool DrawOrder::less(const Vector2f* p_pos, uint32_t a, uint32_t b)
+{
+    return p_pos[a].y < p_pos[b].y || (p_pos[a].y == p_pos[b].y && a < b);
+}
+
+/**
+ * Sorts the `count` rows in `p_order` by depth. The first `sorted` of
+ * them are in last frame's order; the others were added since.
+ */
+void DrawOrder::sort(uint32_t* p_order, size_t count, size_t sorted, const Vector2f* p_pos)
+{
+    if ((count - sorted) * NEW_ROWS_DIVISOR > count) {
+        fullSort(p_order, count, p_pos);
+    } else {
+        insertionSort(p_order, count, p_pos);
+    }
+}
+
+void DrawOrder::insertionSort(uint32_t* p_order, size_t count, const Vector2f* p_pos)
+{
+    for(size_t i=1; i < count; i++) {
+        uint32_t row = p_order[i];
+        size_t j = i;
+        for(; j > 0 && less(p_pos, row, p_order[j-1]); j--) {
+            p_order[j] = p_order[j-1];
+        }
+        p_order[j] = row;
+    }
+}
+
+void DrawOrder::fullSort(uint32_t* p_order, size_t count, const Vector2f* p_pos)
+{
+    std::sort(p_order, p_order + count, [p_pos](uint32_t a, uint32_t b) { return less(p_pos, a, b); });
+}
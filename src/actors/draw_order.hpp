@@ -0,0 +1,29 @@
+#ifndef ILMENDUR_DRAW_ORDER_HPP
+#define ILMENDUR_DRAW_ORDER_HPP
+#include "../util.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Depth order of the actors of an ObjectLayer. Actors further down on
+ * the screen are drawn later, so that they cover the ones behind them.
+ * The depth of a row is the Y coördinate of its foot, i.e. of its
+ * origin (`origy` in the texture's INI file), which is what the
+ * ActorStore keeps in `pos`; rows with equal depth stay in row
+ * (= ID) order.
+ *
+ * From one frame to the next, only the moving actors change their
+ * depth, and only a little, so last frame's order is nearly sorted.
+ * sort() therefore uses insertion sort, which is linear on nearly
+ * sorted input, and only falls back to std::sort if many new rows
+ * were added to the order. ilmendur-bench --microbench compares both.
+ */
+namespace DrawOrder {
+
+    bool less(const Vector2f* p_pos, uint32_t a, uint32_t b);
+    void sort(uint32_t* p_order, size_t count, size_t sorted, const Vector2f* p_pos);
+    void insertionSort(uint32_t* p_order, size_t count, const Vector2f* p_pos);
+    void fullSort(uint32_t* p_order, size_t count, const Vector2f* p_pos);
+}
+
+#endif /* ILMENDUR_DRAW_ORDER_HPP */
@@ -1,5 +1,6 @@
 #include "hero.hpp"
 #include "../scenes/scene.hpp"
+#include "../input.hpp"
 
 #define HERO_ID 999999
 #define HERO_VELOCITY 80
@@ -28,7 +29,7 @@ void Hero::update()
 void Hero::checkInput()
 {
     Vector2f vec;
-    const uint8_t* keys = SDL_GetKeyboardState(nullptr);
+    const uint8_t* keys = Input::keyboardState();
 
     if (keys[SDL_SCANCODE_UP]) {
         if (keys[SDL_SCANCODE_RIGHT]) {
@@ -61,16 +62,16 @@ void Hero::checkInput()
 
     if (isMoving()) {
         // If already moving, just alter the move direction
-        m_movedir = vec;
+        mp_store->movedir[m_index] = vec;
     } else {
         // Otherwise start a new movement process
         if (vec.x == 0.0f) {
-            vec.x = m_pos.x;
+            vec.x = position().x;
         } else {
             vec.x /= 0.0f;
         }
         if (vec.y == 0.0f) {
-            vec.y = m_pos.y;
+            vec.y = position().y;
         } else {
             vec.y /= 0.0f;
         }
@@ -0,0 +1,117 @@
+#include "integrator.hpp"
+#include "../ilmendur.hpp"
+#include <cassert>
+
+#ifdef ILMENDUR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// The kernels treat the position and direction columns as flat arrays
+// of x/y pairs.
+static_assert(sizeof(Vector2f) == 2 * sizeof(float), "Vector2f must consist of exactly two packed floats");
+
+static void integrateScalar(size_t start, size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir)
+{
+    const float fps = static_cast<float>(ILMENDUR_TARGET_FRAMERATE);
+    for(size_t i=start; i < count; i++) {
+        // Idle actors have zero speed and zero move direction.
+        float distance_per_frame = p_speed[i] / fps;
+        p_passed[i] += distance_per_frame;
+        p_pos[i].x += p_movedir[i].x * distance_per_frame;
+        p_pos[i].y += p_movedir[i].y * distance_per_frame;
+    }
+}
+
+#ifdef ILMENDUR_SIMD_X86
+/// Four actors per iteration.
+__attribute__((target("sse2")))
+static void integrateSSE2(size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir)
+{
+    const __m128 fps = _mm_set1_ps(static_cast<float>(ILMENDUR_TARGET_FRAMERATE));
+    float* p_posf = reinterpret_cast<float*>(p_pos);
+    const float* p_dirf = reinterpret_cast<const float*>(p_movedir);
+
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4) {
+        __m128 dist = _mm_div_ps(_mm_loadu_ps(p_speed + i), fps);
+        _mm_storeu_ps(p_passed + i, _mm_add_ps(_mm_loadu_ps(p_passed + i), dist));
+
+        // Positions are x/y interleaved: duplicate each distance.
+        __m128 dist_lo = _mm_unpacklo_ps(dist, dist); // d0 d0 d1 d1
+        __m128 dist_hi = _mm_unpackhi_ps(dist, dist); // d2 d2 d3 d3
+        float* p_p = p_posf + 2*i;
+        const float* p_d = p_dirf + 2*i;
+        _mm_storeu_ps(p_p,     _mm_add_ps(_mm_loadu_ps(p_p),     _mm_mul_ps(_mm_loadu_ps(p_d),     dist_lo)));
+        _mm_storeu_ps(p_p + 4, _mm_add_ps(_mm_loadu_ps(p_p + 4), _mm_mul_ps(_mm_loadu_ps(p_d + 4), dist_hi)));
+    }
+
+    integrateScalar(i, count, p_speed, p_passed, p_pos, p_movedir);
+}
+
+/// Eight actors per iteration.
+__attribute__((target("avx2")))
+static void integrateAVX2(size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir)
+{
+    const __m256 fps = _mm256_set1_ps(static_cast<float>(ILMENDUR_TARGET_FRAMERATE));
+    const __m256i lo_index = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i hi_index = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+    float* p_posf = reinterpret_cast<float*>(p_pos);
+    const float* p_dirf = reinterpret_cast<const float*>(p_movedir);
+
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8) {
+        __m256 dist = _mm256_div_ps(_mm256_loadu_ps(p_speed + i), fps);
+        _mm256_storeu_ps(p_passed + i, _mm256_add_ps(_mm256_loadu_ps(p_passed + i), dist));
+
+        // Unlike unpacklo/hi, this permutation crosses the 128 bit lanes.
+        __m256 dist_lo = _mm256_permutevar8x32_ps(dist, lo_index);
+        __m256 dist_hi = _mm256_permutevar8x32_ps(dist, hi_index);
+        float* p_p = p_posf + 2*i;
+        const float* p_d = p_dirf + 2*i;
+        _mm256_storeu_ps(p_p,     _mm256_add_ps(_mm256_loadu_ps(p_p),     _mm256_mul_ps(_mm256_loadu_ps(p_d),     dist_lo)));
+        _mm256_storeu_ps(p_p + 8, _mm256_add_ps(_mm256_loadu_ps(p_p + 8), _mm256_mul_ps(_mm256_loadu_ps(p_d + 8), dist_hi)));
+    }
+
+    integrateScalar(i, count, p_speed, p_passed, p_pos, p_movedir);
+}
+#endif
+
+/// Integrates `count` rows with the best kernel. See the module documentation.
+void Integrator::integrate(size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir)
+{
+    integrate(SIMD::bestLevel(), count, p_speed, p_passed, p_pos, p_movedir);
+}
+
+/**
+ * Integrates `count` rows with the kernel for `l`, which must be
+ * supported (see SIMD::isSupported()). Only useful for verification
+ * and benchmarking; use the other overload otherwise.
+ */
+void Integrator::integrate(SIMD::level l, size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir)
+{
+    assert(SIMD::isSupported(l));
+
+    switch (l) {
+    case SIMD::level::scalar:
+        integrateScalar(0, count, p_speed, p_passed, p_pos, p_movedir);
+        return;
+    case SIMD::level::sse2:
+#ifdef ILMENDUR_SIMD_X86
+        integrateSSE2(count, p_speed, p_passed, p_pos, p_movedir);
+        return;
+#else
+        break;
+#endif
+    case SIMD::level::avx2:
+#ifdef ILMENDUR_SIMD_X86
+        integrateAVX2(count, p_speed, p_passed, p_pos, p_movedir);
+        return;
+#else
+        break;
+#endif
+    } // No default to provoke compiler warnings on missing elements
+
+    integrateScalar(0, count, p_speed, p_passed, p_pos, p_movedir);
+}
@@ -0,0 +1,24 @@
+#ifndef ILMENDUR_INTEGRATOR_HPP
+#define ILMENDUR_INTEGRATOR_HPP
+#include "../util.hpp"
+#include "../simd.hpp"
+#include <cstddef>
+
+/**
+ * Movement integration step of the ActorStore. For each row i, this
+ * advances `p_pos[i]` along `p_movedir[i]` by the distance covered in
+ * one frame at `p_speed[i]` pixels per second, and adds that distance
+ * to `p_passed[i]`.
+ *
+ * There is one implementation of this step per SIMD::level, and
+ * integrate() uses the fastest one the CPU supports. All kernels do
+ * the exact same IEEE operations in the same order, so their results
+ * are bit-identical; ilmendur-bench --microbench checks this.
+ */
+namespace Integrator {
+
+    void integrate(size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir);
+    void integrate(SIMD::level l, size_t count, const float* p_speed, float* p_passed, Vector2f* p_pos, const Vector2f* p_movedir);
+}
+
+#endif /* ILMENDUR_INTEGRATOR_HPP */
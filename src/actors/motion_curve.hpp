@@ -0,0 +1,112 @@
+#ifndef ILMENDUR_MOTION_CURVE_HPP
+#define ILMENDUR_MOTION_CURVE_HPP
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+/**
+ * Velocity profile of an actor movement: the speed in pixels per
+ * second as a function of the time `t` in milliseconds passed since
+ * the movement started. See Actor::moveTo().
+ *
+ * This is a plain value type from a small closed set of curve types,
+ * so that it can be stored inline in the ActorStore and evaluated for
+ * all moving actors in one batch, one tight loop per curve type. Use
+ * the static factory functions to create curves:
+ *
+ * - constant(): Always the same speed.
+ * - easeInOut(): Accelerates from zero and decelerates back to
+ *   (almost) zero so that `distance` pixels are covered in
+ *   `duration` milliseconds.
+ * - tanhDecay(): Starts with `velocity` and slows down following
+ *   1 - tanh(t/tau), like a stone that stops rolling. Never falls
+ *   below `min_velocity`.
+ * - spline(): Cubic Bézier curve through the velocities `v0`..`v3`
+ *   over `duration` milliseconds; `v3` is kept afterwards.
+ *
+ * For anything else, Actor::moveTo() accepts an std::function; this
+ * sets the type to `custom`, and `custom_slot` refers to the function
+ * stored on the side by the ActorStore.
+ */
+struct MotionCurve
+{
+    enum class curve_type: uint8_t { constant, ease_in_out, tanh_decay, spline, custom };
+
+    curve_type type;
+    uint32_t custom_slot; ///< Only for `custom`
+    float v[4];           ///< Velocities, meaning depends on `type`
+    float duration;       ///< Milliseconds; `tau` for tanh_decay
+
+    static MotionCurve constant(float velocity)
+    {
+        return MotionCurve{curve_type::constant, 0, {velocity, 0.0f, 0.0f, 0.0f}, 0.0f};
+    }
+
+    static MotionCurve easeInOut(float distance, float duration)
+    {
+        assert(duration > 0.0f);
+
+        // v(t) = peak * sin²(πt/T) integrates to peak * T/2 over [0;T].
+        float peak = 2.0f * distance / (duration / 1000.0f);
+        return MotionCurve{curve_type::ease_in_out, 0, {peak, peak * 0.05f, 0.0f, 0.0f}, duration};
+    }
+
+    static MotionCurve tanhDecay(float velocity, float tau, float min_velocity = 0.0f)
+    {
+        assert(tau > 0.0f);
+        return MotionCurve{curve_type::tanh_decay, 0, {velocity, min_velocity, 0.0f, 0.0f}, tau};
+    }
+
+    static MotionCurve spline(float v0, float v1, float v2, float v3, float duration)
+    {
+        assert(duration > 0.0f);
+        return MotionCurve{curve_type::spline, 0, {v0, v1, v2, v3}, duration};
+    }
+
+    /**
+     * Evaluates the curve for a single point in time. The batched
+     * evaluation in ActorStore::evaluateCurves() uses the same
+     * formulas. Returns 0 for `custom` curves.
+     */
+    inline float evaluate(float t) const
+    {
+        switch (type) {
+        case curve_type::constant:
+            return v[0];
+        case curve_type::ease_in_out:
+            return evaluateEaseInOut(t);
+        case curve_type::tanh_decay:
+            return evaluateTanhDecay(t);
+        case curve_type::spline:
+            return evaluateSpline(t);
+        case curve_type::custom:
+            return 0.0f;
+        } // No default to provoke compiler warnings on missing elements
+        return 0.0f;
+    }
+
+    inline float evaluateEaseInOut(float t) const
+    {
+        // After `duration`, rounding may have left a few pixels; the
+        // floor velocity v[1] ensures the target is reached anyway.
+        if (t >= duration) {
+            return v[1];
+        }
+        float s = std::sin(static_cast<float>(M_PI) * t / duration);
+        return std::fmax(v[0] * s * s, v[1]);
+    }
+
+    inline float evaluateTanhDecay(float t) const
+    {
+        return std::fmax(v[0] * (1.0f - std::tanh(t / duration)), v[1]);
+    }
+
+    inline float evaluateSpline(float t) const
+    {
+        float s = std::fmin(t / duration, 1.0f);
+        float r = 1.0f - s;
+        return r*r*r*v[0] + 3.0f*r*r*s*v[1] + 3.0f*r*s*s*v[2] + s*s*s*v[3];
+    }
+};
+
+#endif /* ILMENDUR_MOTION_CURVE_HPP */
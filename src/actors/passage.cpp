@@ -22,21 +22,12 @@ Passage::Passage(int id, ObjectLayer* p_layer, SDL_Rect area, pass_direction dir
     if (area.h == 0.0f)  {
         area.h = 10.0f;
     }
-}
 
-Passage::~Passage()
-{
+    setCollisionShape(SDL_Rect{0, 0, static_cast<int>(m_size.x), static_cast<int>(m_size.y)});
 }
 
-SDL_Rect Passage::collisionBox() const
+Passage::~Passage()
 {
-    SDL_Rect box;
-    box.x = m_pos.x;
-    box.y = m_pos.y;
-    box.w = m_size.x;
-    box.h = m_size.y;
-
-    return box;
 }
 
 void Passage::handleEvent(const Event& event)
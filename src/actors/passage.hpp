@@ -1,6 +1,7 @@
 #ifndef ILMENDUR_PASSAGE_HPP
 #define ILMENDUR_PASSAGE_HPP
 #include "actor.hpp"
+#include "../string_id.hpp"
 
 class Passage: public Actor
 {
@@ -16,11 +17,10 @@ public:
 
     virtual void handleEvent(const Event& event);
 
-    virtual SDL_Rect collisionBox() const;
 private:
     Vector2f m_size;
     pass_direction m_passdir;
-    std::string m_targetlayer;
+    StringId m_targetlayer;
 
     friend class Map;
 };
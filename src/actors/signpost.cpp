@@ -3,6 +3,7 @@
 #include "../ilmendur.hpp"
 #include "../texture_pool.hpp"
 #include "../gui.hpp"
+#include "../render_list.hpp"
 #include "hero.hpp"
 
 #define TILEWIDTH 32
@@ -13,6 +14,7 @@ Signpost::Signpost(int id, ObjectLayer* p_layer, vector<string> texts)
     : Actor(id, p_layer),
       m_texts(texts)
 {
+    setCollisionShape(SDL_Rect{-TILEWIDTH / 2, -TILEWIDTH / 2, TILEWIDTH, TILEWIDTH});
 }
 
 Signpost::~Signpost()
@@ -29,35 +31,32 @@ void Signpost::update()
  * draw() implementation, because it renders a part of the
  * “signposts” tileset rather than a separate character graphic.
  */
-void Signpost::draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview)
+void Signpost::draw(RenderList* p_stage, const SDL_Rect* p_camview)
 {
-    TextureInfo* p_tileset = Ilmendur::instance().texturePool()["tilesets/signposts.png"];
+    static const StringId s_tileset = StringId::find("tilesets/signposts.png"_hs);
+    TextureInfo* p_tileset = Ilmendur::instance().texturePool()[s_tileset];
     static const SDL_Rect srcrect { 32, 0, 32, 32 };
-    SDL_Rect destrect;
-    destrect.x = m_pos.x - 0.5 * TILEWIDTH;
-    destrect.y = m_pos.y - 0.5 * TILEWIDTH;
-    destrect.w = 32;
-    destrect.h = 32;
+    SDL_Rect destrect = drawRect();
 
     if (!SDL_HasIntersection(&destrect, p_camview)) {
         return;
     }
 
-    // TODO: Honor p_camview width and height for scaling purposes.
+    // View coordinates; the renderer scales them to the camera's zoom
     destrect.x -= p_camview->x;
     destrect.y -= p_camview->y;
 
-    SDL_RenderCopy(p_stage, p_tileset->p_texture, &srcrect, &destrect);
+    p_stage->copy(p_tileset->p_texture, &srcrect, &destrect);
 }
 
-SDL_Rect Signpost::collisionBox() const
+SDL_Rect Signpost::drawRect() const
 {
-    SDL_Rect rect;
-    rect.x = m_pos.x - 0.5 * TILEWIDTH;
-    rect.y = m_pos.y - 0.5 * TILEWIDTH;
-    rect.w = TILEWIDTH;
-    rect.h = TILEWIDTH;
-    return rect;
+    SDL_Rect result;
+    result.x = position().x - 0.5 * TILEWIDTH;
+    result.y = position().y - 0.5 * TILEWIDTH;
+    result.w = 32;
+    result.h = 32;
+    return result;
 }
 
 void Signpost::handleEvent(const Event& event)
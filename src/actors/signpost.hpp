@@ -11,11 +11,11 @@ public:
     virtual ~Signpost();
 
     virtual void update();
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview);
+    virtual SDL_Rect drawRect() const;
     virtual void handleEvent(const Event& event);
     virtual void interact(Actor* p_other);
 
-    virtual SDL_Rect collisionBox() const;
 private:
     std::vector<std::string> m_texts;
 };
@@ -29,7 +29,7 @@ Teleport::Teleport(int id, ObjectLayer* p_layer, SDL_Rect box, int target_entry_
       m_target_map_name(target_map_name)
 {
     warp(Vector2f(box.x, box.y));
-    m_collbox = box;
+    setCollisionShape(SDL_Rect{0, 0, box.w, box.h});
 }
 
 Teleport::~Teleport()
@@ -40,16 +40,11 @@ void Teleport::update()
 {
 }
 
-void Teleport::draw(SDL_Renderer*, const SDL_Rect*)
+void Teleport::draw(RenderList*, const SDL_Rect*)
 {
     // Invisible
 }
 
-SDL_Rect Teleport::collisionBox() const
-{
-    return m_collbox;
-}
-
 void Teleport::handleEvent(const Event& event)
 {
     if (event.type == Event::Type::collision) {
@@ -61,7 +56,7 @@ void Teleport::handleEvent(const Event& event)
             assert(p_scene); // Can only call this from a map scene
 
             bool both_heroes_in = false;
-            vector<Actor*> teleportees = p_scene->map().findActorsInArea(m_collbox, mp_layer);
+            vector<Actor*> teleportees = p_scene->map().findActorsInArea(collisionBox(), mp_layer);
             for (Actor* p_actor: teleportees) {
                 Hero* p_hero2 = dynamic_cast<Hero*>(p_actor);
                 if (p_hero2 && p_hero2->id() != p_hero1->id()) {
@@ -21,12 +21,9 @@ public:
     virtual ~Teleport();
 
     virtual void update();
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview);
     virtual void handleEvent(const Event& event);
-
-    virtual SDL_Rect collisionBox() const;
 private:
-    SDL_Rect m_collbox;
     int m_target_entry_id;
     std::string m_target_map_name;
 };
@@ -0,0 +1,73 @@
+#include "arena.hpp"
+#include <algorithm>
+
+using namespace std;
+
+CountingResource::CountingResource(pmr::memory_resource* p_upstream)
+    : mp_upstream(p_upstream)
+{
+}
+
+/// Zero all counters.
+void CountingResource::reset()
+{
+    m_stats = Stats();
+}
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+    void* p = mp_upstream->allocate(bytes, alignment);
+
+    m_stats.allocations++;
+    m_stats.bytes += bytes;
+    m_stats.peak_bytes = max(m_stats.peak_bytes, m_stats.bytes);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    mp_upstream->deallocate(p, bytes, alignment);
+
+    m_stats.deallocations++;
+    m_stats.bytes -= bytes;
+}
+
+bool CountingResource::do_is_equal(const pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+/**
+ * Creates an empty arena. The first block requested from the heap
+ * will have `initial_size` bytes; further blocks grow geometrically.
+ */
+Arena::Arena(size_t initial_size)
+    : m_buffer(initial_size, &m_upstream),
+      mp_destructors(nullptr),
+      m_objects(0)
+{
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+/**
+ * Destroys all objects created in the arena, latest first, and
+ * returns all memory to the heap. Afterwards, the arena can be
+ * used again.
+ */
+void Arena::release()
+{
+    Destructor* p_rec = mp_destructors;
+    while (p_rec) {
+        Destructor* p_next = p_rec->p_next;
+        p_rec->p_destroy(p_rec->p_object);
+        p_rec = p_next;
+    }
+
+    mp_destructors = nullptr;
+    m_objects = 0;
+    m_buffer.release();
+}
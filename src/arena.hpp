@@ -0,0 +1,101 @@
+#ifndef ILMENDUR_ARENA_HPP
+#define ILMENDUR_ARENA_HPP
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Memory resource that forwards to another memory resource and
+ * counts the allocations and deallocations passing through it.
+ */
+class CountingResource: public std::pmr::memory_resource
+{
+public:
+    struct Stats
+    {
+        size_t allocations   = 0;
+        size_t deallocations = 0;
+        size_t bytes         = 0; ///< Currently allocated
+        size_t peak_bytes    = 0; ///< Maximum of `bytes` since the last reset()
+    };
+
+    CountingResource(std::pmr::memory_resource* p_upstream = std::pmr::new_delete_resource());
+
+    inline const Stats& stats() const { return m_stats; }
+    void reset();
+protected:
+    virtual void* do_allocate(size_t bytes, size_t alignment);
+    virtual void do_deallocate(void* p, size_t bytes, size_t alignment);
+    virtual bool do_is_equal(const std::pmr::memory_resource& other) const noexcept;
+private:
+    std::pmr::memory_resource* mp_upstream;
+    Stats m_stats;
+};
+
+/**
+ * Region of memory for objects that all die at the same time.
+ *
+ * Objects are created in the arena with create() and never deleted
+ * individually. Their memory is handed out from large blocks by a
+ * monotonic buffer; release() runs the destructors of all objects
+ * in reverse order of creation and then frees the blocks in one go.
+ * Containers can allocate from the arena as well by passing
+ * resource() to their (std::pmr) constructor; their memory is
+ * only reclaimed by release() then.
+ *
+ * Each Map owns an arena for its layers, actors, tilesets, and
+ * properties, so that loading a map results in a few big rather
+ * than thousands of small heap allocations, and so that destroying
+ * it does not free thousands of small blocks one by one.
+ */
+class Arena
+{
+public:
+    Arena(size_t initial_size = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    inline std::pmr::memory_resource* resource() { return &m_buffer; }
+    inline const CountingResource::Stats& upstreamStats() const { return m_upstream.stats(); }
+    inline size_t objectCount() const { return m_objects; }
+
+    /**
+     * Constructs a `T` from `args` in the arena and returns it.
+     * The object is destroyed by release() or the arena's destructor;
+     * never `delete` it.
+     */
+    template<typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        void* p_mem = m_buffer.allocate(sizeof(T), alignof(T));
+        T* p_obj = new (p_mem) T(std::forward<Args>(args)...);
+
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            void* p_rec = m_buffer.allocate(sizeof(Destructor), alignof(Destructor));
+            mp_destructors = new (p_rec) Destructor{[](void* p) { static_cast<T*>(p)->~T(); }, p_obj, mp_destructors};
+        }
+
+        m_objects++;
+        return p_obj;
+    }
+
+    void release();
+private:
+    struct Destructor
+    {
+        void (*p_destroy)(void*);
+        void* p_object;
+        Destructor* p_next;
+    };
+
+    CountingResource m_upstream;
+    std::pmr::monotonic_buffer_resource m_buffer;
+    Destructor* mp_destructors;
+    size_t m_objects;
+};
+
+#endif /* ILMENDUR_ARENA_HPP */
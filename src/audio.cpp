@@ -18,28 +18,32 @@ AudioSystem::AudioSystem()
     // TODO: Maybe not a good idea to preload all music into memory; could grow large!
     // It is only done here because SDL's own file loading functions are unable
     // to deal with Unicode path names, so C++11's filesystem library can be used.
-    for (const fs::directory_entry& iter: fs::directory_iterator(OS::gameDataDir() / fs::u8path("audio") / fs::u8path("music"))) {
-        if (iter.path().extension() == fs::u8path(".ogg")) {
+    for (const fs::directory_entry& iter: fs::directory_iterator(OS::gameDataDir() / OS::utf8Path("audio") / OS::utf8Path("music"))) {
+        if (iter.path().extension() == OS::utf8Path(".ogg")) {
             ifstream file(iter.path(), ifstream::in | ifstream::binary);
             string binary(READ_FILE(file));
             assert(binary.size() > 1);
 
-            string name = fs::relative(iter.path(), OS::gameDataDir() / fs::u8path("audio") / fs::u8path("music")).u8string();
+            string name = OS::utf8String(fs::relative(iter.path(), OS::gameDataDir() / OS::utf8Path("audio") / OS::utf8Path("music")));
             m_music_table[name] = binary;
         }
     }
 
     // Preload all sounds into memory (no disk access please for short sounds)
     // Note that the sounds are stored in decoded form in m_sound_table.
-    for (const fs::directory_entry& iter: fs::recursive_directory_iterator(OS::gameDataDir() / fs::u8path("audio") / fs::u8path("sounds"))) {
-        if (iter.path().extension() == fs::u8path(".ogg")) {
+    for (const fs::directory_entry& iter: fs::recursive_directory_iterator(OS::gameDataDir() / OS::utf8Path("audio") / OS::utf8Path("sounds"))) {
+        if (iter.path().extension() == OS::utf8Path(".ogg")) {
             ifstream file(iter.path(), ifstream::in | ifstream::binary);
             string binary(READ_FILE(file));
             assert(binary.size() > 1);
 
-            string name = fs::relative(iter.path(), OS::gameDataDir() / fs::u8path("audio") / fs::u8path("sounds")).u8string();
+            StringId name(OS::utf8String(fs::relative(iter.path(), OS::gameDataDir() / OS::utf8Path("audio") / OS::utf8Path("sounds"))));
+            if (name.value() >= m_sound_table.size()) {
+                m_sound_table.resize(name.value() + 1, nullptr);
+            }
+
             SDL_RWops* p_rwops = SDL_RWFromMem(binary.data(), binary.size());
-            m_sound_table[name] = Mix_LoadWAV_RW(p_rwops, SDL_TRUE); // frees p_rwops, and returns a completely decoded version of `binary'.
+            m_sound_table[name.value()] = Mix_LoadWAV_RW(p_rwops, SDL_TRUE); // frees p_rwops, and returns a completely decoded version of `binary'.
             // Note that in contrast to music loading, it is not required
             // to keep `binary' around.
         }
@@ -52,8 +56,10 @@ AudioSystem::AudioSystem()
 AudioSystem::~AudioSystem()
 {
     stopBackgroundMusic();
-    for(auto iter: m_sound_table) {
-        Mix_FreeChunk(static_cast<Mix_Chunk*>(iter.second));
+    for(void* p_chunk: m_sound_table) {
+        if (p_chunk) {
+            Mix_FreeChunk(static_cast<Mix_Chunk*>(p_chunk));
+        }
     }
     m_sound_table.clear();
 }
@@ -99,7 +105,8 @@ bool AudioSystem::isPlayingBackgroundMusic() const
 }
 
 /**
- * Plays a sound. `name` is the path relative to the audio/sounds directory.
+ * Plays a sound. `sound` is the path relative to the audio/sounds directory,
+ * usually resolved once from a literal with StringId::find().
  * Returns the channel used.
  *
  * There may only ever be one sound being played at once in any given
@@ -114,10 +121,10 @@ bool AudioSystem::isPlayingBackgroundMusic() const
  * This method crashes with an assertion failure if the sound cannot
  * be played for whatever reason.
  */
-AudioSystem::channel AudioSystem::playSound(const std::string& name, AudioSystem::channel chan)
+AudioSystem::channel AudioSystem::playSound(StringId sound, AudioSystem::channel chan)
 {
-    assert(m_sound_table.count(name) != 0);
-    int result = Mix_PlayChannel(static_cast<int>(chan), static_cast<Mix_Chunk*>(m_sound_table[name]), 0);
+    assert(sound.isValid() && sound.value() < m_sound_table.size() && m_sound_table[sound.value()]);
+    int result = Mix_PlayChannel(static_cast<int>(chan), static_cast<Mix_Chunk*>(m_sound_table[sound.value()]), 0);
     assert(result != -1);
     return static_cast<AudioSystem::channel>(result);
 }
@@ -125,14 +132,25 @@ AudioSystem::channel AudioSystem::playSound(const std::string& name, AudioSystem
 /**
  * Like `playSound()', but blocks until the sound has finished playing.
  * The blocking time is not exact, but resolves with a resolution of
- * about 25 milliseconds.
+ * about 25 milliseconds. This freezes the game meanwhile; scripts
+ * should `co_await Scripts::sound()` instead.
  */
-AudioSystem::channel AudioSystem::playSoundBlocking(const std::string& name, AudioSystem::channel chan)
+AudioSystem::channel AudioSystem::playSoundBlocking(StringId sound, AudioSystem::channel chan)
 {
-    chan = playSound(name, chan);
+    chan = playSound(sound, chan);
     while (Mix_Playing(static_cast<int>(chan))) {
         this_thread::sleep_for(chrono::milliseconds(25));
     }
 
     return chan;
 }
+
+/**
+ * Queries whether a sound is currently playing in channel `chan`,
+ * which must not be channel::any.
+ */
+bool AudioSystem::isPlaying(AudioSystem::channel chan) const
+{
+    assert(chan != channel::any);
+    return Mix_Playing(static_cast<int>(chan));
+}
@@ -1,7 +1,9 @@
 #ifndef ILMENDUR_AUDIO_HPP
 #define ILMENDUR_AUDIO_HPP
+#include "string_id.hpp"
 #include <string>
 #include <map>
+#include <vector>
 
 class AudioSystem
 {
@@ -17,12 +19,13 @@ public:
         any = -1,
         ui = 3 // UI channel should be a high one so it is normally free
     };
-    channel playSound(const std::string& name, channel chan);
-    channel playSoundBlocking(const std::string& name, channel chan);
+    channel playSound(StringId sound, channel chan);
+    channel playSoundBlocking(StringId sound, channel chan);
+    bool isPlaying(channel chan) const;
 
 private:
     std::map<std::string, std::string> m_music_table;
-    std::map<std::string, void*> m_sound_table;
+    std::vector<void*> m_sound_table; ///< Indexed by StringId value; nullptr if there is no such sound
 
     struct {
         std::string name;
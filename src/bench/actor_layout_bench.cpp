@@ -0,0 +1,436 @@
+#include "bench.hpp"
+#include "../ilmendur.hpp"
+#include "../util.hpp"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+
+using namespace std;
+
+/* The collision checks of both layouts compare every row with every
+ * other one, so only this many frames are run. */
+#define LAYOUT_FRAMES 10
+
+namespace {
+
+    /* The sprite all rows share, like the NPCs of a stress map. */
+    struct Sprite
+    {
+        int frames         = 4;
+        int animation_time = 500;
+        int origx          = 16;
+        int origy          = 32;
+        int collx          = 4;
+        int colly          = 16;
+        int collw          = 24;
+        int collh          = 16;
+    };
+
+    const Sprite s_sprite;
+    const int MAP_WIDTH  = 200 * 32;
+    const int MAP_HEIGHT = 200 * 32;
+
+    /* Stand-in for Clock::ticks(). */
+    uint64_t s_now = 0;
+
+    typedef function<float(uint64_t)> VelocityFunction;
+
+    /* An actor as it was before the ActorStore: a heap object with
+     * virtual update() and collisionBox(), on a layer that keeps
+     * pointers to them. The loops follow the code as of 15ee701^. */
+    class HeapActor
+    {
+    public:
+        HeapActor(int id, const Vector2f& pos) : m_id(id), m_pos(pos) {}
+        virtual ~HeapActor() {}
+
+        virtual void update();
+        virtual SDL_Rect collisionBox() const;
+
+        bool isMoving() const { return static_cast<bool>(m_velfunc); }
+        void moveTo(const Vector2f& target, uint64_t now, float speed);
+        void stopMoving();
+
+        int m_id;
+        Vector2f m_pos;
+    private:
+        void move(uint64_t now);
+
+        int m_current_frame = 0;
+        int m_ani_ticks     = 0;
+        Vector2f m_targetpos;
+        Vector2f m_movedir;
+        uint64_t m_move_start = 0;
+        float m_passed        = 0.0f;
+        float m_total         = 0.0f;
+        VelocityFunction m_velfunc;
+    };
+
+    class HeapNpc: public HeapActor
+    {
+    public:
+        using HeapActor::HeapActor;
+        virtual void update() { HeapActor::update(); }
+    };
+
+    void HeapActor::moveTo(const Vector2f& target, uint64_t now, float speed)
+    {
+        Vector2f trajectory(target.x - m_pos.x, target.y - m_pos.y);
+        float length = sqrtf(trajectory.x * trajectory.x + trajectory.y * trajectory.y);
+        m_passed     = 0.0f;
+        m_total      = length;
+        m_movedir    = Vector2f(trajectory.x / length, trajectory.y / length);
+        m_targetpos  = target;
+        m_move_start = now;
+        m_velfunc    = [speed](uint64_t) { return speed; };
+    }
+
+    void HeapActor::stopMoving()
+    {
+        VelocityFunction empty;
+        m_velfunc.swap(empty);
+        m_movedir.clear();
+        m_targetpos.clear();
+        m_move_start    = 0;
+        m_passed        = 0.0f;
+        m_total         = 0.0f;
+        m_current_frame = 0;
+    }
+
+    void HeapActor::move(uint64_t now)
+    {
+        float distance = m_velfunc(now - m_move_start) / static_cast<float>(ILMENDUR_TARGET_FRAMERATE);
+        m_passed += distance;
+        if (m_passed >= m_total) {
+            m_pos = m_targetpos;
+            stopMoving();
+        } else {
+            m_pos.x += m_movedir.x * distance;
+            m_pos.y += m_movedir.y * distance;
+        }
+    }
+
+    void HeapActor::update()
+    {
+        if (isMoving()) {
+            move(s_now);
+        }
+        if (isMoving() && ++m_ani_ticks >= ILMENDUR_TARGET_FRAMERATE * (s_sprite.animation_time / 1000.0)) {
+            if (++m_current_frame >= s_sprite.frames) {
+                m_current_frame = 0;
+            }
+            m_ani_ticks = 0;
+        }
+    }
+
+    SDL_Rect HeapActor::collisionBox() const
+    {
+        SDL_Rect rect;
+        rect.w = s_sprite.collw;
+        rect.h = s_sprite.collh;
+        rect.x = m_pos.x - s_sprite.origx + s_sprite.collx;
+        rect.y = m_pos.y - s_sprite.origy + s_sprite.colly;
+        return rect;
+    }
+
+    struct HeapLayer
+    {
+        vector<HeapActor*> actors;
+        size_t collisions = 0;
+
+        void checkBoundary(HeapActor* p_actor);
+        void checkActors(HeapActor* p_actor);
+    };
+
+    void HeapLayer::checkBoundary(HeapActor* p_actor)
+    {
+        SDL_Rect box = p_actor->collisionBox();
+        if (box.x < 0) {
+            p_actor->m_pos.x = s_sprite.origx - s_sprite.collx;
+            p_actor->stopMoving();
+        }
+        if (box.x + box.w > MAP_WIDTH) {
+            p_actor->m_pos.x = MAP_WIDTH - s_sprite.origx - s_sprite.collx;
+            p_actor->stopMoving();
+        }
+        if (box.y < 0) {
+            p_actor->m_pos.y = s_sprite.origy - s_sprite.colly;
+            p_actor->stopMoving();
+        }
+        if (box.y + box.h > MAP_HEIGHT) {
+            p_actor->m_pos.y = MAP_HEIGHT - s_sprite.origy - s_sprite.colly;
+            p_actor->stopMoving();
+        }
+    }
+
+    void HeapLayer::checkActors(HeapActor* p_actor)
+    {
+        vector<pair<HeapActor*,HeapActor*>> found;
+        SDL_Rect box = p_actor->collisionBox();
+        for(HeapActor* p_other: actors) {
+            if (p_other->m_id == p_actor->m_id) {
+                continue;
+            }
+            SDL_Rect other_box = p_other->collisionBox();
+            if (SDL_HasIntersection(&box, &other_box)) {
+                if (p_actor->m_id < p_other->m_id) {
+                    found.emplace_back(p_actor, p_other);
+                } else {
+                    found.emplace_back(p_other, p_actor);
+                }
+            }
+        }
+        collisions += found.size();
+    }
+
+    /* The same actors in columns, as the ActorStore introduced by
+     * 15ee701 kept them, with its movement, animation and collision
+     * loops. */
+    struct ColumnStore
+    {
+        vector<int> ids;
+        vector<Vector2f> pos;
+        vector<Vector2f> movedir;
+        vector<Vector2f> targetpos;
+        vector<uint64_t> move_start;
+        vector<float> passed;
+        vector<float> total;
+        vector<VelocityFunction> velfunc;
+        vector<SDL_Rect> collshape; ///< Relative to `pos`
+        vector<int> frame;
+        vector<int> ani_ticks;
+        size_t collisions = 0;
+
+        void add(int id, const Vector2f& position);
+        SDL_Rect collisionBox(size_t row) const;
+        void moveTo(size_t row, const Vector2f& target, uint64_t now, float speed);
+        void stopMoving(size_t row);
+        void advanceMovement(uint64_t now);
+        void advanceAnimation();
+        void checkBoundary(size_t row);
+        void checkActors(size_t row);
+    };
+
+    void ColumnStore::add(int id, const Vector2f& position)
+    {
+        ids.push_back(id);
+        pos.push_back(position);
+        movedir.emplace_back();
+        targetpos.emplace_back();
+        move_start.push_back(0);
+        passed.push_back(0.0f);
+        total.push_back(0.0f);
+        velfunc.emplace_back();
+        collshape.push_back(SDL_Rect{s_sprite.collx - s_sprite.origx, s_sprite.colly - s_sprite.origy, s_sprite.collw, s_sprite.collh});
+        frame.push_back(0);
+        ani_ticks.push_back(0);
+    }
+
+    SDL_Rect ColumnStore::collisionBox(size_t row) const
+    {
+        const SDL_Rect& shape = collshape[row];
+        return SDL_Rect{static_cast<int>(pos[row].x + shape.x), static_cast<int>(pos[row].y + shape.y), shape.w, shape.h};
+    }
+
+    void ColumnStore::moveTo(size_t row, const Vector2f& target, uint64_t now, float speed)
+    {
+        Vector2f trajectory(target.x - pos[row].x, target.y - pos[row].y);
+        float length    = sqrtf(trajectory.x * trajectory.x + trajectory.y * trajectory.y);
+        passed[row]     = 0.0f;
+        total[row]      = length;
+        movedir[row]    = Vector2f(trajectory.x / length, trajectory.y / length);
+        targetpos[row]  = target;
+        move_start[row] = now;
+        velfunc[row]    = [speed](uint64_t) { return speed; };
+    }
+
+    void ColumnStore::stopMoving(size_t row)
+    {
+        velfunc[row] = nullptr;
+        movedir[row].clear();
+        targetpos[row].clear();
+        move_start[row] = 0;
+        passed[row]     = 0.0f;
+        total[row]      = 0.0f;
+        frame[row]      = 0;
+    }
+
+    void ColumnStore::advanceMovement(uint64_t now)
+    {
+        for(size_t i=0; i < ids.size(); i++) {
+            if (move_start[i] == 0) {
+                continue;
+            }
+            float distance = velfunc[i](now - move_start[i]) / static_cast<float>(ILMENDUR_TARGET_FRAMERATE);
+            passed[i] += distance;
+            if (passed[i] >= total[i]) {
+                pos[i] = targetpos[i];
+                stopMoving(i);
+            } else {
+                pos[i].x += movedir[i].x * distance;
+                pos[i].y += movedir[i].y * distance;
+            }
+        }
+    }
+
+    void ColumnStore::advanceAnimation()
+    {
+        for(size_t i=0; i < ids.size(); i++) {
+            if (move_start[i] != 0 && ++ani_ticks[i] >= ILMENDUR_TARGET_FRAMERATE * (s_sprite.animation_time / 1000.0)) {
+                if (++frame[i] >= s_sprite.frames) {
+                    frame[i] = 0;
+                }
+                ani_ticks[i] = 0;
+            }
+        }
+    }
+
+    void ColumnStore::checkBoundary(size_t row)
+    {
+        SDL_Rect box = collisionBox(row);
+        if (box.x < 0) {
+            pos[row].x = s_sprite.origx - s_sprite.collx;
+            stopMoving(row);
+        }
+        if (box.x + box.w > MAP_WIDTH) {
+            pos[row].x = MAP_WIDTH - s_sprite.origx - s_sprite.collx;
+            stopMoving(row);
+        }
+        if (box.y < 0) {
+            pos[row].y = s_sprite.origy - s_sprite.colly;
+            stopMoving(row);
+        }
+        if (box.y + box.h > MAP_HEIGHT) {
+            pos[row].y = MAP_HEIGHT - s_sprite.origy - s_sprite.colly;
+            stopMoving(row);
+        }
+    }
+
+    void ColumnStore::checkActors(size_t row)
+    {
+        vector<pair<int,int>> found;
+        const int id = ids[row];
+        SDL_Rect box = collisionBox(row);
+        for(size_t i=0; i < ids.size(); i++) {
+            if (ids[i] == id) {
+                continue;
+            }
+            SDL_Rect other_box = collisionBox(i);
+            if (SDL_HasIntersection(&box, &other_box)) {
+                found.emplace_back(min(id, ids[i]), max(id, ids[i]));
+            }
+        }
+        collisions += found.size();
+    }
+}
+
+/**
+ * Compares the update and collision loops of the actors before and
+ * after the ActorStore (commit 15ee701): `rows` heap allocated actors
+ * behind virtual calls against the same actors in columns. Both walk
+ * the same random paths on a map the size of a stress map. Runs at
+ * most LAYOUT_FRAMES frames, as the collision checks of that time are
+ * quadratic. With 10720 rows, the actor count of `--stress soa --npcs
+ * 10000`, it stands in for running that stress map on both trees.
+ * Returns false if the layouts end up with different positions or
+ * collisions.
+ */
+bool Bench::runActorLayoutBenchmark(size_t rows, const Options& options, ostream& report)
+{
+    const unsigned int frames = min(options.frames, static_cast<unsigned int>(LAYOUT_FRAMES));
+
+    mt19937 rng(options.seed);
+    uniform_real_distribution<float> coord_x(32.0f, MAP_WIDTH - 32.0f);
+    uniform_real_distribution<float> coord_y(64.0f, MAP_HEIGHT - 32.0f);
+    vector<Vector2f> start(rows);
+    for(Vector2f& pos: start) {
+        pos = Vector2f(coord_x(rng), coord_y(rng));
+    }
+
+    // Interleave other allocations, as loading a map does, so that
+    // the actors are not next to each other on the heap
+    HeapLayer layer;
+    vector<unique_ptr<HeapActor>> heap_actors;
+    vector<unique_ptr<char[]>> other_allocations;
+    ColumnStore store;
+    for(size_t i=0; i < rows; i++) {
+        other_allocations.emplace_back(new char[64 + (i * 37) % 200]);
+        heap_actors.emplace_back(new HeapNpc(i + 1, start[i]));
+        layer.actors.push_back(heap_actors.back().get());
+        store.add(i + 1, start[i]);
+    }
+
+    // One actor in 30 starts walking each frame, if it stands
+    uniform_int_distribution<int> walk(0, 29);
+    uniform_real_distribution<float> offset(-96.0f, 96.0f);
+    mt19937 heap_rng(options.seed + 1);
+    mt19937 column_rng(options.seed + 1);
+
+    Phase heap_update, heap_collision, column_update, column_collision;
+    s_now = 1000;
+    for(unsigned int frame=0; frame < frames; frame++) {
+        s_now += 1000 / ILMENDUR_TARGET_FRAMERATE;
+
+        for(HeapActor* p_actor: layer.actors) {
+            if (walk(heap_rng) == 0 && !p_actor->isMoving()) {
+                Vector2f target = p_actor->m_pos;
+                target.x += offset(heap_rng);
+                target.y += offset(heap_rng);
+                p_actor->moveTo(target, s_now, 64.0f);
+            }
+        }
+        auto start_time = clock::now();
+        for(HeapActor* p_actor: layer.actors) {
+            p_actor->update();
+        }
+        heap_update.add(elapsedUs(start_time));
+        start_time = clock::now();
+        for(HeapActor* p_actor: layer.actors) {
+            layer.checkBoundary(p_actor);
+            layer.checkActors(p_actor);
+        }
+        heap_collision.add(elapsedUs(start_time));
+
+        for(size_t i=0; i < rows; i++) {
+            if (walk(column_rng) == 0 && store.move_start[i] == 0) {
+                Vector2f target = store.pos[i];
+                target.x += offset(column_rng);
+                target.y += offset(column_rng);
+                store.moveTo(i, target, s_now, 64.0f);
+            }
+        }
+        start_time = clock::now();
+        store.advanceMovement(s_now);
+        store.advanceAnimation();
+        column_update.add(elapsedUs(start_time));
+        start_time = clock::now();
+        for(size_t i=0; i < rows; i++) {
+            store.checkBoundary(i);
+            store.checkActors(i);
+        }
+        column_collision.add(elapsedUs(start_time));
+    }
+
+    bool identical = layer.collisions == store.collisions;
+    for(size_t i=0; i < rows; i++) {
+        identical = identical && layer.actors[i]->m_pos.x == store.pos[i].x && layer.actors[i]->m_pos.y == store.pos[i].y;
+    }
+
+    report << "{\"rows\":" << rows
+           << ",\"frames\":" << frames
+           << ",\"identical\":" << (identical ? "true" : "false")
+           << ",\"heap\":{\"update\":";
+    heap_update.writeJson(report);
+    report << ",\"collision\":";
+    heap_collision.writeJson(report);
+    report << "},\"columns\":{\"update\":";
+    column_update.writeJson(report);
+    report << ",\"collision\":";
+    column_collision.writeJson(report);
+    report << "}}";
+
+    return identical;
+}
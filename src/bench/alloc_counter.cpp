@@ -0,0 +1,97 @@
+#include "bench.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/* Replacements of the global allocation functions that count all
+ * heap allocations of the process. The array and nothrow variants
+ * of the standard library forward to these, so only the plain and
+ * the aligned ones (and their sized deletes) need to be replaced. This is linked
+ * into ilmendur-bench only; the game itself uses the standard
+ * allocation functions. */
+
+using namespace std;
+
+static atomic<uint64_t> s_allocations(0);
+static atomic<uint64_t> s_deallocations(0);
+static atomic<uint64_t> s_bytes(0);
+
+static inline void countAllocation(size_t size)
+{
+    s_allocations.fetch_add(1, memory_order_relaxed);
+    s_bytes.fetch_add(size, memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+    countAllocation(size);
+    if (void* p = malloc(size > 0 ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+    countAllocation(size);
+
+    // aligned_alloc() requires the size to be a multiple of the alignment.
+    size_t align = static_cast<size_t>(alignment);
+    size_t padded = (size + align - 1) / align * align;
+    if (void* p = aligned_alloc(align, padded > 0 ? padded : align)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p) {
+        s_deallocations.fetch_add(1, memory_order_relaxed);
+        free(p);
+    }
+}
+
+void operator delete(void* p, align_val_t) noexcept
+{
+    if (p) {
+        s_deallocations.fetch_add(1, memory_order_relaxed);
+        free(p);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t, align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
+
+Bench::AllocCounts Bench::allocCounts()
+{
+    AllocCounts counts;
+    counts.allocations   = s_allocations.load(memory_order_relaxed);
+    counts.deallocations = s_deallocations.load(memory_order_relaxed);
+    counts.bytes         = s_bytes.load(memory_order_relaxed);
+    return counts;
+}
+
+Bench::AllocCounts Bench::AllocCounts::operator-(const AllocCounts& other) const
+{
+    AllocCounts result;
+    result.allocations   = allocations - other.allocations;
+    result.deallocations = deallocations - other.deallocations;
+    result.bytes         = bytes - other.bytes;
+    return result;
+}
+
+void Bench::AllocCounts::writeJson(std::ostream& stream) const
+{
+    stream << "{\"allocations\":" << allocations
+           << ",\"deallocations\":" << deallocations
+           << ",\"bytes\":" << bytes
+           << "}";
+}
@@ -0,0 +1,44 @@
+#include "bench.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <numeric>
+
+using namespace std;
+
+double Bench::Phase::mean() const
+{
+    if (m_samples.empty()) {
+        return 0.0;
+    }
+    return accumulate(m_samples.begin(), m_samples.end(), 0.0) / m_samples.size();
+}
+
+/**
+ * Writes the phase as a JSON object with the sample count and the
+ * mean, minimum, median, 95th and 99th percentile, and maximum
+ * sample, all in microseconds.
+ */
+void Bench::Phase::writeJson(std::ostream& stream) const
+{
+    vector<double> sorted(m_samples);
+    sort(sorted.begin(), sorted.end());
+
+    auto percentile = [&sorted](double p) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t index = static_cast<size_t>(ceil(p * sorted.size()));
+        return sorted[min(index > 0 ? index - 1 : 0, sorted.size() - 1)];
+    };
+
+    stream << fixed << setprecision(2)
+           << "{\"samples\":" << sorted.size()
+           << ",\"mean_us\":" << mean()
+           << ",\"min_us\":"  << (sorted.empty() ? 0.0 : sorted.front())
+           << ",\"p50_us\":"  << percentile(0.50)
+           << ",\"p95_us\":"  << percentile(0.95)
+           << ",\"p99_us\":"  << percentile(0.99)
+           << ",\"max_us\":"  << (sorted.empty() ? 0.0 : sorted.back())
+           << "}";
+}
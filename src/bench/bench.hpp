@@ -0,0 +1,75 @@
+#ifndef ILMENDUR_BENCH_HPP
+#define ILMENDUR_BENCH_HPP
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/* Shared infrastructure of the ilmendur-bench executable. Every
+ * benchmark writes one JSON object into the report stream; see
+ * main.cpp for the overall report layout. */
+
+namespace Bench {
+
+    typedef std::chrono::steady_clock clock;
+
+    /// Microseconds elapsed since `start`.
+    inline double elapsedUs(clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    }
+
+    /**
+     * Timing samples of one benchmark phase. writeJson() emits
+     * summary statistics rather than the raw samples.
+     */
+    class Phase
+    {
+    public:
+        void add(double us) { m_samples.push_back(us); }
+        double mean() const;
+        void writeJson(std::ostream& stream) const;
+    private:
+        std::vector<double> m_samples;
+    };
+
+    /// Options shared by all benchmarks, as given on the command line.
+    struct Options
+    {
+        unsigned int frames = 1000;
+        unsigned int load_repeats = 5;
+        unsigned int seed = 1;
+        unsigned int threads = 0; ///< Job system threads, 0 = one per core
+        bool scaling = false;     ///< Repeat the simulation with 1 to `threads` threads
+    };
+
+    /**
+     * Heap allocation counters of the whole process. ilmendur-bench
+     * replaces the global operator new and delete to maintain them;
+     * see alloc_counter.cpp.
+     */
+    struct AllocCounts
+    {
+        uint64_t allocations   = 0;
+        uint64_t deallocations = 0;
+        uint64_t bytes         = 0; ///< Total bytes requested by allocations
+
+        AllocCounts operator-(const AllocCounts& other) const;
+        void writeJson(std::ostream& stream) const;
+    };
+
+    AllocCounts allocCounts();
+
+    bool runMapBenchmark(const std::string& name, const std::filesystem::path& path, const Options& options, std::ostream& report);
+    bool runIntegratorBenchmark(size_t rows, const Options& options, std::ostream& report);
+    bool runActorLayoutBenchmark(size_t rows, const Options& options, std::ostream& report);
+    bool runAabbBenchmark(size_t rows, size_t queries, const Options& options, std::ostream& report);
+    bool runDrawOrderBenchmark(size_t rows, const Options& options, std::ostream& report);
+    bool runTimerBenchmark(size_t count, const Options& options, std::ostream& report);
+    bool runScriptBenchmark(size_t count, const Options& options, std::ostream& report);
+    bool runTitleFrameBenchmark(const Options& options, std::ostream& report);
+}
+
+#endif /* ILMENDUR_BENCH_HPP */
@@ -0,0 +1,209 @@
+#include "bench.hpp"
+#include "../actors/draw_order.hpp"
+#include "../ilmendur.hpp"
+#include <cmath>
+#include <numeric>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+    /* Actors spread over a large map; about a quarter of them walk
+     * into a random direction at a random speed, the others stand. */
+    struct Actors
+    {
+        vector<Vector2f> pos;
+        vector<Vector2f> velocity; // Pixels per frame
+
+        Actors(size_t rows, unsigned int seed);
+        void move();
+    };
+
+    Actors::Actors(size_t rows, unsigned int seed)
+        : pos(rows), velocity(rows)
+    {
+        mt19937 rng(seed);
+        uniform_real_distribution<float> coord(0.0f, 4096.0f);
+        uniform_real_distribution<float> speed(8.0f, 256.0f);
+        uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        uniform_int_distribution<int> walking(0, 3);
+
+        for(size_t i=0; i < rows; i++) {
+            // Whole pixels, so that there are rows of equal depth
+            pos[i] = Vector2f(roundf(coord(rng)), roundf(coord(rng)));
+            if (walking(rng) == 0) {
+                float a = angle(rng);
+                float s = speed(rng) / ILMENDUR_TARGET_FRAMERATE;
+                velocity[i] = Vector2f(cosf(a) * s, sinf(a) * s);
+            } else {
+                velocity[i].clear();
+            }
+        }
+    }
+
+    void Actors::move()
+    {
+        for(size_t i=0; i < pos.size(); i++) {
+            pos[i].x += velocity[i].x;
+            pos[i].y += velocity[i].y;
+        }
+    }
+
+    /* Stand-in for Actor::drawRect(): a 32x32 sprite standing on its
+     * foot. */
+    SDL_Rect drawRect(const Actors& actors, uint32_t row)
+    {
+        const Vector2f& pos = actors.pos[row];
+        return SDL_Rect{static_cast<int>(pos.x) - 16, static_cast<int>(pos.y) - 32, 32, 32};
+    }
+
+    /* The order of the rows inside `rect`, as ObjectLayer::draw() kept
+     * it when each call saved its own: the rows still visible in the
+     * order of the previous call, whatever its rectangle was, then the
+     * rows that entered, sorted again. */
+    void sortPerCall(vector<uint32_t>& order, vector<bool>& visible, const Actors& actors, const SDL_Rect& rect)
+    {
+        const size_t rows = actors.pos.size();
+        visible.assign(rows, false);
+        for(size_t i=0; i < rows; i++) {
+            SDL_Rect actor_rect = drawRect(actors, i);
+            visible[i] = SDL_HasIntersection(&actor_rect, &rect);
+        }
+
+        size_t kept = 0;
+        for(uint32_t row: order) {
+            if (visible[row]) {
+                order[kept++] = row;
+                visible[row] = false;
+            }
+        }
+        order.resize(kept);
+        for(size_t i=0; i < rows; i++) {
+            if (visible[i]) {
+                order.push_back(i);
+            }
+        }
+        DrawOrder::sort(order.data(), order.size(), kept, actors.pos.data());
+    }
+
+    /* The rows of `order`, which holds all rows in depth order, that are
+     * inside `rect`; what ObjectLayer::draw() does now. */
+    void filter(vector<uint32_t>& result, const vector<uint32_t>& order, const Actors& actors, const SDL_Rect& rect)
+    {
+        result.clear();
+        for(uint32_t row: order) {
+            SDL_Rect actor_rect = drawRect(actors, row);
+            if (SDL_HasIntersection(&actor_rect, &rect)) {
+                result.push_back(row);
+            }
+        }
+    }
+}
+
+/**
+ * Moves `rows` actors for `options.frames` frames and keeps them in
+ * depth order, once with DrawOrder::sort() on last frame's order and
+ * once with a std::sort of it every frame, and times both.
+ *
+ * Then draws the same frames the way DebugMapScene does with two
+ * cameras and view caching: a few small patch rectangles and the two
+ * camera views, alternately. It times sorting one order per call, as
+ * ObjectLayer::draw() did, against sorting one order of all rows per
+ * frame and filtering it per call. Returns false if any of the orders
+ * ever differ.
+ */
+bool Bench::runDrawOrderBenchmark(size_t rows, const Options& options, ostream& report)
+{
+    static const int VIEW_W     = 640;
+    static const int VIEW_H     = 360;
+    static const int PATCHES    = 8;
+    static const int PATCH_SIZE = 64;
+
+    bool identical = true;
+    {
+        Actors actors(rows, options.seed);
+        vector<uint32_t> incremental(rows);
+        iota(incremental.begin(), incremental.end(), 0);
+        vector<uint32_t> full(incremental);
+
+        Phase insertion, stdsort;
+        for(unsigned int frame=0; frame < options.frames; frame++) {
+            actors.move();
+
+            auto start = clock::now();
+            DrawOrder::sort(incremental.data(), rows, frame == 0 ? 0 : rows, actors.pos.data());
+            insertion.add(elapsedUs(start));
+
+            start = clock::now();
+            DrawOrder::fullSort(full.data(), rows, actors.pos.data());
+            stdsort.add(elapsedUs(start));
+
+            identical = identical && incremental == full;
+        }
+
+        report << "{\"rows\":" << rows
+               << ",\"insertion\":";
+        insertion.writeJson(report);
+        report << ",\"std_sort\":";
+        stdsort.writeJson(report);
+    }
+
+    // Same actors again, drawn through several rectangles per frame
+    Actors actors(rows, options.seed);
+    mt19937 rng(options.seed);
+    uniform_int_distribution<uint32_t> patch_row(0, rows - 1);
+    vector<SDL_Rect> rects;
+    vector<uint32_t> per_call_order, shared_order(rows), shared_result;
+    vector<vector<uint32_t>> per_call_results(PATCHES + 2);
+    vector<bool> visible;
+    iota(shared_order.begin(), shared_order.end(), 0);
+
+    Phase per_call, shared;
+    for(unsigned int frame=0; frame < options.frames; frame++) {
+        actors.move();
+
+        // Patches around random actors, as if they had moved, and the
+        // two cameras crossing the map in different directions
+        rects.clear();
+        for(int i=0; i < PATCHES; i++) {
+            SDL_Rect rect = drawRect(actors, patch_row(rng));
+            rects.push_back(SDL_Rect{rect.x - PATCH_SIZE / 2, rect.y - PATCH_SIZE / 2, PATCH_SIZE, PATCH_SIZE});
+        }
+        int offset = static_cast<int>(frame * 4 % (4096 - VIEW_W));
+        rects.push_back(SDL_Rect{offset, 1024, VIEW_W, VIEW_H});
+        rects.push_back(SDL_Rect{2048, offset * (4096 - VIEW_H) / (4096 - VIEW_W), VIEW_W, VIEW_H});
+
+        double per_call_us = 0.0;
+        double shared_us   = 0.0;
+        for(size_t i=0; i < rects.size(); i++) {
+            auto start = clock::now();
+            sortPerCall(per_call_order, visible, actors, rects[i]);
+            per_call_us += elapsedUs(start);
+            per_call_results[i] = per_call_order;
+        }
+
+        auto start = clock::now();
+        DrawOrder::sort(shared_order.data(), rows, frame == 0 ? 0 : rows, actors.pos.data());
+        shared_us += elapsedUs(start);
+        for(size_t i=0; i < rects.size(); i++) {
+            start = clock::now();
+            filter(shared_result, shared_order, actors, rects[i]);
+            shared_us += elapsedUs(start);
+            identical = identical && shared_result == per_call_results[i];
+        }
+
+        per_call.add(per_call_us);
+        shared.add(shared_us);
+    }
+
+    report << ",\"draws_per_frame\":" << PATCHES + 2
+           << ",\"per_call\":";
+    per_call.writeJson(report);
+    report << ",\"shared\":";
+    shared.writeJson(report);
+    report << ",\"identical\":" << (identical ? "true" : "false")
+           << "}";
+
+    return identical;
+}
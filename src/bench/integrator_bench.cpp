@@ -0,0 +1,110 @@
+#include "bench.hpp"
+#include "../actors/integrator.hpp"
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+    /* Column data as the ActorStore would have it. About a quarter
+     * of the rows are idle, i.e. have zero speed and direction. */
+    struct Columns
+    {
+        vector<float> speed;
+        vector<float> passed;
+        vector<Vector2f> pos;
+        vector<Vector2f> movedir;
+
+        Columns(size_t rows, unsigned int seed);
+    };
+
+    Columns::Columns(size_t rows, unsigned int seed)
+        : speed(rows), passed(rows, 0.0f), pos(rows), movedir(rows)
+    {
+        mt19937 rng(seed);
+        uniform_real_distribution<float> coord(0.0f, 4096.0f);
+        uniform_real_distribution<float> velocity(8.0f, 256.0f);
+        uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        uniform_int_distribution<int> idle(0, 3);
+
+        for(size_t i=0; i < rows; i++) {
+            pos[i] = Vector2f(coord(rng), coord(rng));
+            if (idle(rng) != 0) {
+                float a = angle(rng);
+                speed[i]   = velocity(rng);
+                movedir[i] = Vector2f(cosf(a), sinf(a));
+            } else {
+                speed[i] = 0.0f;
+                movedir[i].clear();
+            }
+        }
+    }
+
+    /* Largest absolute difference between the float arrays `a` and `b`. */
+    float maxDifference(const float* a, const float* b, size_t count)
+    {
+        float result = 0.0f;
+        for(size_t i=0; i < count; i++) {
+            result = fmax(result, fabs(a[i] - b[i]));
+        }
+        return result;
+    }
+}
+
+/**
+ * Runs every integrator kernel the CPU supports on the same random
+ * columns for `options.frames` frames, compares the results with
+ * the scalar kernel and times the kernels. `rows` is deliberately
+ * not a multiple of the SIMD widths, so that the scalar tails are
+ * covered. Returns false if any kernel's results are not identical
+ * to the scalar ones.
+ */
+bool Bench::runIntegratorBenchmark(size_t rows, const Options& options, ostream& report)
+{
+    const SIMD::level levels[] = {SIMD::level::scalar, SIMD::level::sse2, SIMD::level::avx2};
+
+    Columns reference(rows, options.seed);
+    for(unsigned int frame=0; frame < options.frames; frame++) {
+        Integrator::integrate(SIMD::level::scalar, rows, reference.speed.data(), reference.passed.data(), reference.pos.data(), reference.movedir.data());
+    }
+
+    bool all_identical = true;
+    report << "{\"best\":\"" << SIMD::levelName(SIMD::bestLevel())
+           << "\",\"rows\":" << rows
+           << ",\"kernels\":[";
+    for(size_t k=0; k < sizeof(levels) / sizeof(SIMD::level); k++) {
+        if (k > 0) {
+            report << ",";
+        }
+        report << "{\"name\":\"" << SIMD::levelName(levels[k]) << "\"";
+        if (!SIMD::isSupported(levels[k])) {
+            report << ",\"supported\":false}";
+            continue;
+        }
+
+        Columns columns(rows, options.seed);
+        Phase integrate;
+        for(unsigned int frame=0; frame < options.frames; frame++) {
+            auto start = clock::now();
+            Integrator::integrate(levels[k], rows, columns.speed.data(), columns.passed.data(), columns.pos.data(), columns.movedir.data());
+            integrate.add(elapsedUs(start));
+        }
+
+        bool identical = memcmp(columns.pos.data(), reference.pos.data(), rows * sizeof(Vector2f)) == 0
+            && memcmp(columns.passed.data(), reference.passed.data(), rows * sizeof(float)) == 0;
+        float max_error = fmax(maxDifference(reinterpret_cast<const float*>(columns.pos.data()), reinterpret_cast<const float*>(reference.pos.data()), 2 * rows),
+                               maxDifference(columns.passed.data(), reference.passed.data(), rows));
+        all_identical = all_identical && identical;
+
+        report << ",\"supported\":true,\"identical\":" << (identical ? "true" : "false")
+               << ",\"max_error\":" << max_error
+               << ",\"integrate\":";
+        integrate.writeJson(report);
+        report << "}";
+    }
+    report << "]}";
+
+    return all_identical;
+}
@@ -0,0 +1,227 @@
+/* ilmendur-bench: headless benchmark runner.
+ *
+ * Loads maps and drives them for a fixed number of frames with
+ * scripted movement, using SDL's dummy video driver and software
+ * renderer. The timings of the individual phases (load, teardown,
+ * update, collision, record, draw) and the heap allocation counts of loading
+ * and destroying each map are written as JSON to standard output or
+ * to the file given with --output:
+ *
+ *   {"version":"...","frames":1000,"seed":1,"maps":[{...}, ...]}
+ *
+ * Usage: ilmendur-bench [--frames N] [--seed N] [--load-repeats N]
+ *                       [--map NAME]... [--map-file PATH]...
+ *                       [--stress NAME]... [--generate NAME]...
+ *                       [--map-dir DIR] [--size WxH]
+ *                       [--tile-layers N] [--object-layers N]
+ *                       [--collboxes N] [--npcs N] [--statics N]
+ *                       [--teleports N] [--output FILE]
+ *                       [--threads N] [--scaling] [--microbench]
+ *
+ * --map loads a map by name like the game does; --map-file loads
+ * an arbitrary TMX file. --stress generates a synthetic map of the
+ * given name (see stress_map.cpp) into the map directory and runs
+ * it; --generate only writes the map. The map directory defaults
+ * to the user's map directory, so that generated maps can also be
+ * played. The --size etc. options configure all generated maps.
+ * Without any maps given, all the maps listed in s_default_maps
+ * are run.
+ *
+ * --threads sets the number of threads of the job system, which
+ * defaults to one per CPU core. --scaling additionally runs the
+ * simulation of each map with 1 to that many threads and checks
+ * that all runs dispatch the same collision events and end in the
+ * same state (see map_bench.cpp); the exit status is 1 if not, and
+ * also if drawing both cameras with a shared visibility pass gives a
+ * different result than drawing them one by one. --scaling also
+ * adds the generated map "Scaling Layers" with at least
+ * SCALING_OBJECT_LAYERS object layers, as the layers of a map share
+ * its arena.
+ *
+ * --microbench runs no maps, but checks that the SIMD kernels of the
+ * movement integrator and of the collision overlap test produce the
+ * same results as their scalar counterparts and times them (see
+ * integrator_bench.cpp and aabb_bench.cpp). It also compares keeping
+ * 5000 actors in depth order by insertion sort with a std::sort every
+ * frame (see draw_order_bench.cpp), runs 100000 timers on the
+ * timing wheel (see timer_bench.cpp), and runs 1000 patrolling NPC
+ * routines as scripts and as chained callbacks (see script_bench.cpp).
+ * The exit status is 1 if any result deviates. */
+
+#include "bench.hpp"
+#include "stress_map.hpp"
+#include "buildconfig.hpp"
+#include "../ilmendur.hpp"
+#include "../map.hpp"
+#include "../os.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+static const vector<string> s_default_maps = {"Oak Fortress", "Test Map 2"};
+static const unsigned int SCALING_OBJECT_LAYERS = 3;
+
+int main(int argc, char* argv[])
+{
+    vector<string> args(argv + 1, argv + argc);
+    Bench::Options options;
+    vector<pair<string, fs::path>> maps;
+    Bench::StressMapSpec spec;
+    vector<string> stress_maps;
+    vector<string> generate_only;
+    fs::path map_dir;
+    string outfile;
+    bool microbench = false;
+
+    try {
+        for(size_t i=0; i < args.size(); i++) {
+            bool has_value = i + 1 < args.size();
+            if (args[i] == "--frames" && has_value) {
+                options.frames = stoul(args[++i]);
+            } else if (args[i] == "--seed" && has_value) {
+                options.seed = stoul(args[++i]);
+            } else if (args[i] == "--load-repeats" && has_value) {
+                options.load_repeats = stoul(args[++i]);
+            } else if (args[i] == "--map" && has_value) {
+                maps.emplace_back(args[i+1], Map::findMapFile(args[i+1]));
+                i++;
+            } else if (args[i] == "--map-file" && has_value) {
+                fs::path path = fs::absolute(OS::utf8Path(args[++i]));
+                maps.emplace_back(OS::utf8String(path.stem()), path);
+            } else if (args[i] == "--stress" && has_value) {
+                stress_maps.push_back(args[++i]);
+            } else if (args[i] == "--generate" && has_value) {
+                generate_only.push_back(args[++i]);
+            } else if (args[i] == "--map-dir" && has_value) {
+                map_dir = OS::utf8Path(args[++i]);
+            } else if (args[i] == "--size" && has_value) {
+                const string& size = args[++i];
+                size_t x = size.find('x');
+                if (x == string::npos) {
+                    throw(runtime_error("Invalid size '" + size + "', expected WIDTHxHEIGHT"));
+                }
+                spec.width  = stoi(size.substr(0, x));
+                spec.height = stoi(size.substr(x + 1));
+            } else if (args[i] == "--tile-layers" && has_value) {
+                spec.tile_layers = stoul(args[++i]);
+            } else if (args[i] == "--object-layers" && has_value) {
+                spec.object_layers = stoul(args[++i]);
+            } else if (args[i] == "--collboxes" && has_value) {
+                spec.collboxes = stoul(args[++i]);
+            } else if (args[i] == "--npcs" && has_value) {
+                spec.npcs = stoul(args[++i]);
+            } else if (args[i] == "--statics" && has_value) {
+                spec.statics = stoul(args[++i]);
+            } else if (args[i] == "--teleports" && has_value) {
+                spec.teleports = stoul(args[++i]);
+            } else if (args[i] == "--output" && has_value) {
+                outfile = args[++i];
+            } else if (args[i] == "--threads" && has_value) {
+                options.threads = stoul(args[++i]);
+            } else if (args[i] == "--scaling") {
+                options.scaling = true;
+            } else if (args[i] == "--microbench") {
+                microbench = true;
+            } else {
+                throw(runtime_error("Invalid or incomplete option '" + args[i] + "'"));
+            }
+        }
+
+        if (map_dir.empty()) {
+            map_dir = OS::userDataDir() / OS::utf8Path("maps");
+        }
+
+        spec.seed = options.seed;
+        for(const string& name: generate_only) {
+            spec.name = name;
+            cerr << "Wrote " << OS::utf8String(Bench::generateStressMap(spec, map_dir)) << endl;
+        }
+        for(const string& name: stress_maps) {
+            spec.name = name;
+            maps.emplace_back(name, Bench::generateStressMap(spec, map_dir));
+        }
+        if (maps.empty() && !generate_only.empty()) {
+            return 0;
+        }
+
+        ofstream file;
+        if (!outfile.empty()) {
+            file.open(OS::utf8Path(outfile));
+            if (!file) {
+                throw(runtime_error("Failed to open '" + outfile + "' for writing"));
+            }
+        }
+        ostream& report = outfile.empty() ? cout : file;
+
+        report << "{\"version\":\"" ILMENDUR_VERSION "\",\"frames\":" << options.frames
+               << ",\"seed\":" << options.seed;
+
+        if (microbench) {
+            // Odd row counts so that the SIMD kernels' scalar tails are covered.
+            report << ",\"integrator\":";
+            bool ok = Bench::runIntegratorBenchmark(10007, options, report);
+            report << ",\"actor_layout\":";
+            ok = Bench::runActorLayoutBenchmark(10720, options, report) && ok;
+            report << ",\"aabb\":";
+            ok = Bench::runAabbBenchmark(2047, 64, options, report) && ok;
+            report << ",\"draw_order\":";
+            ok = Bench::runDrawOrderBenchmark(5000, options, report) && ok;
+            report << ",\"timers\":";
+            ok = Bench::runTimerBenchmark(100000, options, report) && ok;
+            report << ",\"scripts\":";
+            ok = Bench::runScriptBenchmark(1000, options, report) && ok;
+            report << ",\"title_frame\":";
+            ok = Bench::runTitleFrameBenchmark(options, report) && ok;
+            report << "}" << endl;
+            if (!ok) {
+                cerr << "ilmendur-bench: Optimised results deviate from the reference implementations" << endl;
+                return 1;
+            }
+            return 0;
+        }
+
+        Ilmendur app({"--headless", "--threads", to_string(options.threads)});
+        app.loadAssets();
+
+        if (maps.empty()) {
+            for(const string& name: s_default_maps) {
+                maps.emplace_back(name, Map::findMapFile(name));
+            }
+        }
+        if (options.scaling) {
+            Bench::StressMapSpec layers_spec = spec;
+            layers_spec.name = "Scaling Layers";
+            layers_spec.object_layers = max(spec.object_layers, SCALING_OBJECT_LAYERS);
+            maps.emplace_back(layers_spec.name, Bench::generateStressMap(layers_spec, map_dir));
+        }
+
+        bool deterministic = true;
+        report << ",\"maps\":[";
+        for(size_t i=0; i < maps.size(); i++) {
+            cerr << "Benchmarking map '" << maps[i].first << "'" << endl;
+            if (i > 0) {
+                report << ",";
+            }
+            if (!Bench::runMapBenchmark(maps[i].first, maps[i].second, options, report)) {
+                cerr << "ilmendur-bench: Map '" << maps[i].first << "' behaves differently with different thread counts or cameras" << endl;
+                deterministic = false;
+            }
+        }
+        report << "]}" << endl;
+
+        if (!deterministic) {
+            return 1;
+        }
+    } catch (exception& err) {
+        cerr << "ilmendur-bench: " << err.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
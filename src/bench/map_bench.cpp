@@ -0,0 +1,562 @@
+#include "bench.hpp"
+#include "../ilmendur.hpp"
+#include "../map.hpp"
+#include "../camera.hpp"
+#include "../actors/actor.hpp"
+#include "../actors/hero.hpp"
+#include "../scenes/scene.hpp"
+#include "../tmx.hpp"
+#include "../jobs.hpp"
+#include "../render_thread.hpp"
+#include "../os.hpp"
+#include "../util.hpp"
+#include <fstream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <pugixml.hpp>
+
+#define TILEWIDTH 32
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+    /* The cameras need a scene to belong to, but never call
+     * into it. */
+    class BenchScene: public Scene
+    {
+    public:
+        virtual void update() {}
+        virtual void draw(RenderList*) {}
+    };
+
+    /* Start of every frame of the game's main loop. */
+    void clearFrame(RenderList& list)
+    {
+        list.setScale(1.0f, 1.0f);
+        list.setViewport(nullptr);
+        list.setClipRect(nullptr);
+        list.setDrawColor(0, 0, 0, 255);
+        list.clear();
+    }
+
+    /* Means of RenderList::Stats over several frames. */
+    struct DrawCost
+    {
+        uint64_t copies = 0;
+        uint64_t pixels = 0;
+
+        void add(const RenderList::Stats& stats) { copies += stats.copies; pixels += stats.pixels; }
+        void writeJson(ostream& stream, unsigned int frames, const Bench::Phase& draw) const;
+    };
+
+    void DrawCost::writeJson(ostream& stream, unsigned int frames, const Bench::Phase& draw) const
+    {
+        stream << "{\"copies\":" << (frames > 0 ? copies / frames : 0)
+               << ",\"pixels\":" << (frames > 0 ? pixels / frames : 0)
+               << ",\"draw\":";
+        draw.writeJson(stream);
+        stream << "}";
+    }
+
+    const direction s_directions[] = {direction::up, direction::right, direction::down, direction::left};
+
+    /* Deterministic stand-in for player input and map controllers:
+     * the heroes walk a square, and idle actors start a one-field
+     * walk into a random direction now and then. */
+    void scriptMovement(Map& map, const vector<ObjectLayer*>& obj_layers, unsigned int frame, mt19937& rng)
+    {
+        Hero* p_freya    = nullptr;
+        Hero* p_benjamin = nullptr;
+        map.heroes(&p_freya, &p_benjamin);
+
+        if (frame % ILMENDUR_TARGET_FRAMERATE == 0) {
+            direction dir = s_directions[(frame / ILMENDUR_TARGET_FRAMERATE) % 4];
+            p_freya->moveRelative(dir, 4);
+            p_benjamin->moveRelative(dir, 4);
+        }
+
+        uniform_int_distribution<unsigned int> chance(0, ILMENDUR_TARGET_FRAMERATE - 1);
+        uniform_int_distribution<unsigned int> dirdist(0, 3);
+        for (ObjectLayer* p_layer: obj_layers) {
+            for (Actor* p_actor: p_layer->actors()) {
+                if (p_actor == p_freya || p_actor == p_benjamin || p_actor->isInvisible() || p_actor->isMoving()) {
+                    continue;
+                }
+                if (chance(rng) == 0) {
+                    p_actor->moveRelative(s_directions[dirdist(rng)], 1);
+                }
+            }
+        }
+    }
+
+    /* Parses the properties of all objects of the TMX file `path`
+     * `repeats` times without creating any actors. Writes the parse
+     * time per run and the memory retained per object. */
+    void benchmarkProperties(const fs::path& path, unsigned int repeats, std::ostream& report)
+    {
+        pugi::xml_document doc;
+        ifstream file(path);
+        if (!doc.load(file)) {
+            throw(runtime_error("Failed to parse " + OS::utf8String(path)));
+        }
+
+        vector<pugi::xml_node> objects;
+        for (const pugi::xml_node& group: doc.child("map").children("objectgroup")) {
+            for (const pugi::xml_node& obj: group.children("object")) {
+                objects.push_back(obj);
+            }
+        }
+
+        Bench::Phase parse;
+        CountingResource counter;
+        CountingResource::Stats retained;
+        for(unsigned int i=0; i < repeats; i++) {
+            vector<Properties> parsed;
+            parsed.reserve(objects.size());
+            counter.reset();
+
+            auto start = Bench::clock::now();
+            for (const pugi::xml_node& obj: objects) {
+                parsed.push_back(TMX::readProperties(obj, &counter));
+            }
+            parse.add(Bench::elapsedUs(start));
+
+            retained = counter.stats(); // While `parsed` is still alive
+        }
+
+        double count = static_cast<double>(max<size_t>(objects.size(), 1));
+        report << "{\"objects\":" << objects.size()
+               << ",\"bytes_per_object\":" << sizeof(Properties) + retained.bytes / count
+               << ",\"allocations_per_object\":" << retained.allocations / count
+               << ",\"parse\":";
+        parse.writeJson(report);
+        report << "}";
+    }
+
+}
+
+/* One frame of the map simulation as Map::update() does it, but with
+ * the update and collision phases timed separately and the scripted
+ * movement instead of map controllers. If `p_event_hash` is given,
+ * the IDs of all collisions dispatched are hashed into it in dispatch
+ * order. */
+static void simulateFrame(Map& map, const vector<ObjectLayer*>& obj_layers, unsigned int frame, mt19937& rng, Bench::Phase& update, Bench::Phase& collision, uint64_t* p_event_hash = nullptr)
+{
+    scriptMovement(map, obj_layers, frame, rng);
+
+    auto start = Bench::clock::now();
+    map.advanceActors();
+    for (MapLayer* p_layer: map.layers()) {
+        if (ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(p_layer)) {
+            p_obj_layer->updateActors();
+        } else {
+            p_layer->update();
+        }
+    }
+    update.add(Bench::elapsedUs(start));
+
+    start = Bench::clock::now();
+    for (ObjectLayer* p_layer: obj_layers) {
+        p_layer->checkCollisions();
+    }
+    collision.add(Bench::elapsedUs(start));
+
+    if (p_event_hash) {
+        // FNV-1a over the ID sequence
+        for (ObjectLayer* p_layer: obj_layers) {
+            for (const ObjectLayer::Collision& coll: p_layer->collisions()) {
+                *p_event_hash = (*p_event_hash ^ static_cast<uint32_t>(coll.first->id())) * 1099511628211u;
+                *p_event_hash = (*p_event_hash ^ static_cast<uint32_t>(coll.second->id())) * 1099511628211u;
+            }
+        }
+    }
+}
+
+/* Runs `options.frames` more frames of the simulation of `map` for
+ * each zoom level of the cameras, following the heroes, and writes
+ * the record and draw times and the draw cost at each zoom as a JSON
+ * array to `report`. The first frame at each zoom is not timed, as it
+ * posts the creation of the merge target for the new view size. The
+ * cameras are left at zoom 1. */
+static void benchmarkZoom(Map& map, const vector<ObjectLayer*>& obj_layers, Camera* const* pp_cameras, const Bench::Options& options, ostream& report)
+{
+    static const float zooms[] = {0.5f, 1.0f, 2.0f};
+
+    Hero* p_freya    = nullptr;
+    Hero* p_benjamin = nullptr;
+    map.heroes(&p_freya, &p_benjamin);
+
+    RenderThread& render_thread = Ilmendur::instance().renderThread();
+    mt19937 rng(options.seed);
+    report << "[";
+    for(size_t i=0; i < sizeof(zooms) / sizeof(float); i++) {
+        pp_cameras[0]->setZoom(zooms[i]);
+        pp_cameras[1]->setZoom(zooms[i]);
+
+        Bench::Phase update, collision, record, draw;
+        DrawCost cost;
+        for(unsigned int frame=0; frame <= options.frames; frame++) {
+            simulateFrame(map, obj_layers, frame, rng, update, collision);
+            pp_cameras[0]->setPosition(p_freya->position());
+            pp_cameras[1]->setPosition(p_benjamin->position());
+
+            auto start = Bench::clock::now();
+            RenderList& list = render_thread.beginFrame();
+            clearFrame(list);
+            map.draw(&list, pp_cameras, 2);
+            double record_us = Bench::elapsedUs(start);
+            RenderList::Stats stats = list.stats();
+
+            start = Bench::clock::now();
+            render_thread.submitFrame();
+            render_thread.finish();
+            double draw_us = Bench::elapsedUs(start);
+
+            if (frame > 0) {
+                record.add(record_us);
+                draw.add(draw_us);
+                cost.add(stats);
+            }
+        }
+
+        if (i > 0) {
+            report << ",";
+        }
+        report << "{\"zoom\":" << zooms[i]
+               << ",\"record\":";
+        record.writeJson(report);
+        report << ",\"cost\":";
+        cost.writeJson(report, options.frames, draw);
+        report << ",\"frame_us\":" << record.mean() + draw.mean()
+               << "}";
+    }
+    report << "]";
+
+    pp_cameras[0]->setZoom(1.0f);
+    pp_cameras[1]->setZoom(1.0f);
+}
+
+/* Runs `options.frames` more frames of the simulation of `map` with
+ * the cameras standing still where the heroes are, first drawn the
+ * usual way and then for as many frames with Map::setCacheViews(),
+ * and writes the record time and the draw cost of both to `report`
+ * as a JSON object; "cached_views" is the mean number of cameras per
+ * frame that were drawn from their cache. */
+static void benchmarkViewCache(Map& map, const vector<ObjectLayer*>& obj_layers, Camera* const* pp_cameras, const Bench::Options& options, ostream& report)
+{
+    Hero* p_freya    = nullptr;
+    Hero* p_benjamin = nullptr;
+    map.heroes(&p_freya, &p_benjamin);
+    pp_cameras[0]->setPosition(p_freya->position());
+    pp_cameras[1]->setPosition(p_benjamin->position());
+
+    RenderThread& render_thread = Ilmendur::instance().renderThread();
+    mt19937 rng(options.seed);
+    Bench::Phase update, collision;
+    Bench::Phase record[2], draw[2];
+    DrawCost cost[2];
+    size_t cached_views = 0;
+    for(int cached=0; cached < 2; cached++) {
+        map.setCacheViews(cached != 0);
+        for(unsigned int frame=0; frame < options.frames; frame++) {
+            simulateFrame(map, obj_layers, frame, rng, update, collision);
+
+            auto start = Bench::clock::now();
+            RenderList& list = render_thread.beginFrame();
+            clearFrame(list);
+            map.draw(&list, pp_cameras, 2);
+            record[cached].add(Bench::elapsedUs(start));
+            cost[cached].add(list.stats());
+            cached_views += map.cachedViews();
+
+            start = Bench::clock::now();
+            render_thread.submitFrame();
+            render_thread.finish();
+            draw[cached].add(Bench::elapsedUs(start));
+        }
+    }
+    map.setCacheViews(false);
+
+    report << "{\"frames\":" << options.frames
+           << ",\"cached_views\":" << (options.frames > 0 ? static_cast<double>(cached_views) / options.frames : 0.0)
+           << ",\"uncached\":{\"record\":";
+    record[0].writeJson(report);
+    report << ",\"cost\":";
+    cost[0].writeJson(report, options.frames, draw[0]);
+    report << "},\"cached\":{\"record\":";
+    record[1].writeJson(report);
+    report << ",\"cost\":";
+    cost[1].writeJson(report, options.frames, draw[1]);
+    report << "}}";
+}
+
+/* Runs the simulation of the map with 1 to `options.threads` threads
+ * (all cores if 0) and writes the update and collision timings of
+ * each run as a JSON array to `report`. Also checks that all runs
+ * dispatch the exact same sequence of collision events and end with
+ * the exact same actor positions as the single-threaded run; the
+ * result is reported as "deterministic" for each run, and the number
+ * of collision events as "events". Restores the thread count
+ * afterwards. Returns false if any run was not deterministic. */
+static bool benchmarkScaling(const string& name, const fs::path& path, const Bench::Options& options, ostream& report)
+{
+    JobSystem& jobs = Ilmendur::instance().jobSystem();
+    const unsigned int original_threads = jobs.threadCount();
+    const unsigned int max_threads = options.threads > 0 ? options.threads : max(thread::hardware_concurrency(), 1u);
+
+    vector<Vector2f> reference;
+    uint64_t reference_hash = 0;
+    bool all_deterministic = true;
+    report << "[";
+    for(unsigned int threads=1; threads <= max_threads; threads++) {
+        jobs.setThreadCount(threads);
+
+        Map map(name, path);
+        map.makeHeroes();
+        vector<ObjectLayer*> obj_layers;
+        for (MapLayer* p_layer: map.layers()) {
+            if (ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(p_layer)) {
+                obj_layers.push_back(p_obj_layer);
+            }
+        }
+
+        mt19937 rng(options.seed);
+        Bench::Phase update, collision;
+        uint64_t event_hash = 14695981039346656037u;
+        size_t events = 0;
+        for(unsigned int frame=0; frame < options.frames; frame++) {
+            simulateFrame(map, obj_layers, frame, rng, update, collision, &event_hash);
+            for (ObjectLayer* p_layer: obj_layers) {
+                events += p_layer->collisions().size();
+            }
+        }
+
+        vector<Vector2f> positions;
+        for (ObjectLayer* p_layer: obj_layers) {
+            const ActorStore& store = p_layer->actorStore();
+            positions.insert(positions.end(), store.pos.begin(), store.pos.end());
+        }
+        if (threads == 1) {
+            reference = positions;
+            reference_hash = event_hash;
+        }
+
+        bool deterministic = positions == reference && event_hash == reference_hash;
+        all_deterministic = all_deterministic && deterministic;
+
+        if (threads > 1) {
+            report << ",";
+        }
+        report << "{\"threads\":" << threads
+               << ",\"events\":" << events
+               << ",\"deterministic\":" << (deterministic ? "true" : "false")
+               << ",\"update\":";
+        update.writeJson(report);
+        report << ",\"collision\":";
+        collision.writeJson(report);
+        report << "}";
+    }
+    report << "]";
+
+    jobs.setThreadCount(original_threads);
+    return all_deterministic;
+}
+
+/**
+ * Benchmarks one map: loading and destroying it `options.load_repeats`
+ * times, counting the heap allocations of the last repetition, and
+ * parsing the properties of its objects as many times; then running `options.frames` frames of scripted movement, split into
+ * the update, collision, record, and draw phases. Recording fills
+ * a RenderList with the split screen of the real game; drawing
+ * executes it on the (software) renderer of the running Ilmendur
+ * instance's RenderThread. Recording is timed both with the shared
+ * visibility pass of both cameras and with one pass per camera
+ * ("record_separate"); "visibility" reports the mean savings per
+ * frame, and in how many frames the views overlapped. In the frames
+ * in which the views are close enough to be merged (see Map::drawViews()),
+ * the frame is additionally drawn through the merge target; "merge"
+ * compares the copies, filled pixels, and draw times of both ways.
+ * Finally, the cameras are zoomed to 1/2, 1, and 2 for another
+ * `options.frames` frames each; see benchmarkZoom(). With the cameras
+ * standing still, drawing with and without view caching is compared
+ * ("view_cache"); see benchmarkViewCache(). Map controllers are not run. With
+ * `options.scaling`, the simulation is repeated with increasing
+ * thread counts; see benchmarkScaling(). Returns false if these
+ * runs did not all end in the same state, or if the shared visibility
+ * pass recorded anything different from the per-camera passes.
+ * Writes a JSON object describing the results to `report`.
+ */
+bool Bench::runMapBenchmark(const std::string& name, const fs::path& path, const Options& options, std::ostream& report)
+{
+    Phase load, teardown;
+    AllocCounts load_allocs, teardown_allocs;
+    CountingResource::Stats arena_stats;
+    size_t arena_objects = 0;
+    for(unsigned int i=0; i < options.load_repeats; i++) {
+        AllocCounts before = allocCounts();
+        auto start = clock::now();
+        Map* p_loaded = new Map(name, path);
+        load.add(elapsedUs(start));
+        AllocCounts loaded = allocCounts();
+
+        arena_stats   = p_loaded->arena().upstreamStats();
+        arena_objects = p_loaded->arena().objectCount();
+
+        start = clock::now();
+        delete p_loaded;
+        teardown.add(elapsedUs(start));
+
+        load_allocs     = loaded - before;
+        teardown_allocs = allocCounts() - loaded;
+    }
+
+    unique_ptr<Map> p_map(new Map(name, path));
+    p_map->makeHeroes();
+
+    vector<ObjectLayer*> obj_layers;
+    size_t actor_count = 0;
+    for (MapLayer* p_layer: p_map->layers()) {
+        if (ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(p_layer)) {
+            obj_layers.push_back(p_obj_layer);
+            actor_count += p_obj_layer->actors().size();
+        }
+    }
+
+    Hero* p_freya    = nullptr;
+    Hero* p_benjamin = nullptr;
+    p_map->heroes(&p_freya, &p_benjamin);
+
+    RenderThread& render_thread = Ilmendur::instance().renderThread();
+    BenchScene scene;
+    Camera cam1(scene, Ilmendur::instance().viewportPlayer1());
+    Camera cam2(scene, Ilmendur::instance().viewportPlayer2());
+    cam1.setBounds(p_map->drawRect());
+    cam2.setBounds(p_map->drawRect());
+    cam1.setViewport(Ilmendur::instance().viewportPlayer1());
+    cam2.setViewport(Ilmendur::instance().viewportPlayer2());
+
+    mt19937 rng(options.seed);
+    Phase update, collision, record_separate, record, draw;
+    RenderList separate;
+    Camera* cameras[] = {&cam1, &cam2};
+    unsigned int shared_frames = 0;
+    bool identical = true;
+    unsigned int merged_frames = 0;
+    Phase unmerged_draw, merged_draw;
+    DrawCost unmerged_cost, merged_cost;
+    for(unsigned int frame=0; frame < options.frames; frame++) {
+        simulateFrame(*p_map, obj_layers, frame, rng, update, collision);
+
+        cam1.setPosition(p_freya->position());
+        cam2.setPosition(p_benjamin->position());
+
+        // One pass over the map per camera, for comparison
+        auto start = clock::now();
+        separate.reset();
+        clearFrame(separate);
+        cam1.draw(&separate);
+        p_map->draw(&separate, &cam1.view());
+        cam2.draw(&separate);
+        p_map->draw(&separate, &cam2.view());
+        record_separate.add(elapsedUs(start));
+
+        start = clock::now();
+        RenderList& list = render_thread.beginFrame();
+        clearFrame(list);
+        p_map->draw(&list, cameras, 2);
+        record.add(elapsedUs(start));
+
+        identical = identical && list == separate;
+        if (SDL_HasIntersection(&cam1.view(), &cam2.view())) {
+            shared_frames++;
+        }
+
+        // Unlike the game, wait for the render thread, so that the
+        // two phases are timed separately.
+        RenderList::Stats stats = list.stats();
+        start = clock::now();
+        render_thread.submitFrame();
+        render_thread.finish();
+        double draw_us = elapsedUs(start);
+        draw.add(draw_us);
+
+        // The same frame through the merge target, if the views are
+        // close enough to each other
+        RenderList& merged = render_thread.beginFrame();
+        clearFrame(merged);
+        p_map->setMergeViews(true);
+        p_map->draw(&merged, cameras, 2);
+        p_map->setMergeViews(false);
+        if (p_map->viewsMerged()) {
+            merged_frames++;
+            unmerged_cost.add(stats);
+            unmerged_draw.add(draw_us);
+            merged_cost.add(merged.stats());
+
+            start = clock::now();
+            render_thread.submitFrame();
+            render_thread.finish();
+            merged_draw.add(elapsedUs(start));
+        }
+    }
+
+    SDL_Rect maprect = p_map->drawRect();
+    report << "{\"name\":";
+    writeJsonString(report, name);
+    report << ",\"file\":";
+    writeJsonString(report, OS::utf8String(path));
+    report << ",\"width\":" << maprect.w / TILEWIDTH
+           << ",\"height\":" << maprect.h / TILEWIDTH
+           << ",\"layers\":" << p_map->layers().size()
+           << ",\"actors\":" << actor_count
+           << ",\"load\":";
+    load.writeJson(report);
+    report << ",\"teardown\":";
+    teardown.writeJson(report);
+    report << ",\"load_allocs\":";
+    load_allocs.writeJson(report);
+    report << ",\"teardown_allocs\":";
+    teardown_allocs.writeJson(report);
+    report << ",\"properties\":";
+    benchmarkProperties(path, max(options.load_repeats, 1u), report);
+    report << ",\"arena\":{\"blocks\":" << arena_stats.allocations
+           << ",\"bytes\":" << arena_stats.bytes
+           << ",\"objects\":" << arena_objects
+           << "}";
+    report << ",\"update\":";
+    update.writeJson(report);
+    report << ",\"collision\":";
+    collision.writeJson(report);
+    report << ",\"record_separate\":";
+    record_separate.writeJson(report);
+    report << ",\"record\":";
+    record.writeJson(report);
+    report << ",\"visibility\":{\"shared_frames\":" << shared_frames
+           << ",\"saved_us\":" << record_separate.mean() - record.mean()
+           << ",\"identical\":" << (identical ? "true" : "false")
+           << "}";
+    report << ",\"merge\":{\"frames\":" << merged_frames
+           << ",\"separate\":";
+    unmerged_cost.writeJson(report, merged_frames, unmerged_draw);
+    report << ",\"merged\":";
+    merged_cost.writeJson(report, merged_frames, merged_draw);
+    report << "}";
+    report << ",\"draw\":";
+    draw.writeJson(report);
+    report << ",\"zoom\":";
+    benchmarkZoom(*p_map, obj_layers, cameras, options, report);
+    report << ",\"view_cache\":";
+    benchmarkViewCache(*p_map, obj_layers, cameras, options, report);
+    report << ",\"threads\":" << Ilmendur::instance().jobSystem().threadCount();
+    bool deterministic = true;
+    if (options.scaling) {
+        report << ",\"scaling\":";
+        deterministic = benchmarkScaling(name, path, options, report);
+    }
+    report << "}";
+
+    return deterministic && identical;
+}
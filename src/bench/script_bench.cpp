@@ -0,0 +1,178 @@
+#include "bench.hpp"
+#include "../script.hpp"
+#include "../timer.hpp"
+#include "../clock.hpp"
+#include <memory>
+#include <random>
+
+using namespace std;
+
+namespace {
+
+    /* Stands in for an NPC that patrols between two points 64 pixels
+     * apart, pausing at each end. */
+    struct Walker
+    {
+        float x;
+        float target;
+        uint64_t pause; // Milliseconds
+        unsigned int steps;
+
+        void move()
+        {
+            if (x < target) {
+                x += 4.0f;
+            } else if (x > target) {
+                x -= 4.0f;
+            }
+        }
+    };
+
+    vector<Walker> makeWalkers(size_t count, unsigned int seed)
+    {
+        mt19937 rng(seed);
+        uniform_int_distribution<uint64_t> pause(100, 2000);
+
+        vector<Walker> walkers(count);
+        for(Walker& walker: walkers) {
+            walker.x      = 0.0f;
+            walker.target = 0.0f;
+            walker.pause  = pause(rng);
+            walker.steps  = 0;
+        }
+        return walkers;
+    }
+
+    bool arrived(void* p_walker)
+    {
+        Walker* p = static_cast<Walker*>(p_walker);
+        return p->x == p->target;
+    }
+
+    Script patrol(Walker* p_walker)
+    {
+        for(;;) {
+            co_await Scripts::sleep(p_walker->pause);
+            p_walker->target = p_walker->target == 0.0f ? 64.0f : 0.0f;
+            co_await Scripts::until(arrived, p_walker);
+            p_walker->steps++;
+        }
+    }
+
+    /* The same routine as chained callbacks, the way map controllers
+     * had to write it before scripts: each pause creates a new timer
+     * whose callback starts the walk, and the arrival is polled. */
+    struct Routine
+    {
+        Walker* p_walker;
+        unique_ptr<Timer> p_timer;
+        bool walking;
+
+        void pauseThenWalk()
+        {
+            walking = false;
+            p_timer.reset(new Timer(static_cast<float>(p_walker->pause), false, [this] {
+                p_walker->target = p_walker->target == 0.0f ? 64.0f : 0.0f;
+                walking = true;
+            }));
+        }
+
+        void update()
+        {
+            if (walking && arrived(p_walker)) {
+                p_walker->steps++;
+                pauseThenWalk();
+            }
+        }
+    };
+}
+
+/**
+ * Runs `count` patrolling NPC routines for `options.frames` frames on
+ * the virtual clock, once as scripts and once as chained callbacks,
+ * and times the per-frame scheduling and counts its heap allocations.
+ * Returns false if the routines took different numbers of steps, or
+ * if stopping the scripts left any behind.
+ */
+bool Bench::runScriptBenchmark(size_t count, const Options& options, ostream& report)
+{
+    vector<Walker> scripted = makeWalkers(count, options.seed);
+    vector<Walker> chained  = makeWalkers(count, options.seed);
+
+    Clock::setVirtual(true);
+    AllocCounts before = allocCounts();
+    auto start = clock::now();
+    for(Walker& walker: scripted) {
+        Scripts::start(patrol(&walker), &scripted);
+    }
+    double script_start_us = elapsedUs(start);
+    AllocCounts script_start_allocs = allocCounts() - before;
+
+    Phase script_update;
+    before = allocCounts();
+    for(unsigned int frame=0; frame < options.frames; frame++) {
+        Clock::advanceFrame();
+        start = clock::now();
+        Timer::updateAll();
+        Scripts::update();
+        script_update.add(elapsedUs(start));
+
+        for(Walker& walker: scripted) {
+            walker.move();
+        }
+    }
+    AllocCounts script_allocs = allocCounts() - before;
+    Scripts::stop(&scripted);
+    bool stopped = Scripts::count() == 0 && Timer::nextDeadline() == UINT64_MAX;
+
+    Clock::setVirtual(true);
+    vector<Routine> routines(count);
+    for(size_t i=0; i < count; i++) {
+        routines[i].p_walker = &chained[i];
+        routines[i].pauseThenWalk();
+    }
+
+    Phase chained_update;
+    before = allocCounts();
+    for(unsigned int frame=0; frame < options.frames; frame++) {
+        Clock::advanceFrame();
+        start = clock::now();
+        Timer::updateAll();
+        for(Routine& routine: routines) {
+            routine.update();
+        }
+        chained_update.add(elapsedUs(start));
+
+        for(Walker& walker: chained) {
+            walker.move();
+        }
+    }
+    AllocCounts chained_allocs = allocCounts() - before;
+    routines.clear();
+    Clock::setVirtual(false);
+
+    unsigned int steps = 0;
+    bool identical = stopped;
+    for(size_t i=0; i < count; i++) {
+        steps += scripted[i].steps;
+        identical = identical && scripted[i].steps == chained[i].steps;
+    }
+
+    report << "{\"routines\":" << count
+           << ",\"steps\":" << steps
+           << ",\"identical\":" << (identical ? "true" : "false")
+           << ",\"scripts\":{\"start_us\":" << script_start_us
+           << ",\"start_allocations\":";
+    script_start_allocs.writeJson(report);
+    report << ",\"update\":";
+    script_update.writeJson(report);
+    report << ",\"allocations\":";
+    script_allocs.writeJson(report);
+    report << "},\"callbacks\":{\"update\":";
+    chained_update.writeJson(report);
+    report << ",\"allocations\":";
+    chained_allocs.writeJson(report);
+    report << "}}";
+
+    return identical;
+}
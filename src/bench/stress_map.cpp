@@ -0,0 +1,310 @@
+#include "stress_map.hpp"
+#include "../os.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <pugixml.hpp>
+
+#define TILEWIDTH 32
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+    /* Half the edge length (in tiles) of the square around the start
+     * positions that is kept free of objects. The benchmark heroes
+     * walk within it, so they never hit a teleporter (which would
+     * require a running scene). */
+    const int CLEAR_RADIUS = 10;
+    const int MIN_STRESS_MAP_SIZE = 2 * CLEAR_RADIUS + 4;
+
+    const char* s_dirnames[] = {"up", "right", "down", "left"};
+
+    struct TilesetRef
+    {
+        int firstgid;
+        int tilecount;
+        string filename;
+    };
+
+    /* All shipped tilesets, sorted by file name, with the firstgid
+     * values they get in the generated map. */
+    vector<TilesetRef> collectTilesets()
+    {
+        vector<fs::path> files;
+        for(const fs::directory_entry& entry: fs::directory_iterator(OS::gameDataDir() / OS::utf8Path("tilesets"))) {
+            if (entry.path().extension() == ".tsx") {
+                files.push_back(entry.path());
+            }
+        }
+        sort(files.begin(), files.end());
+
+        vector<TilesetRef> result;
+        int firstgid = 1;
+        for(const fs::path& path: files) {
+            ifstream file(path);
+            pugi::xml_document doc;
+            if (!doc.load(file)) {
+                throw(runtime_error("Failed to load tileset '" + OS::utf8String(path) + "'"));
+            }
+
+            int tilecount = doc.child("tileset").attribute("tilecount").as_int();
+            if (tilecount > 0) {
+                result.push_back(TilesetRef{firstgid, tilecount, OS::utf8String(path.filename())});
+                firstgid += tilecount;
+            }
+        }
+
+        if (result.empty()) {
+            throw(runtime_error("No tilesets found"));
+        }
+        return result;
+    }
+
+    class Generator
+    {
+    public:
+        Generator(const Bench::StressMapSpec& spec)
+            : m_spec(spec),
+              m_rng(spec.seed),
+              m_tilesets(collectTilesets()),
+              m_next_layer_id(1),
+              m_next_object_id(1)
+        {
+        }
+
+        void generate(pugi::xml_document& doc);
+    private:
+        void addTileLayer(pugi::xml_node& mapnode, const string& name, bool ground);
+        pugi::xml_node addObject(pugi::xml_node& group, const string& type, int tx, int ty);
+        void randomTile(int& tx, int& ty);
+        int randomInt(int min, int max);
+
+        const Bench::StressMapSpec& m_spec;
+        mt19937 m_rng;
+        vector<TilesetRef> m_tilesets;
+        int m_next_layer_id;
+        int m_next_object_id;
+    };
+
+    int Generator::randomInt(int min, int max)
+    {
+        return uniform_int_distribution<int>(min, max)(m_rng);
+    }
+
+    /* Picks a random tile outside the area kept clear for the heroes. */
+    void Generator::randomTile(int& tx, int& ty)
+    {
+        int cx = m_spec.width / 2;
+        int cy = m_spec.height / 2;
+        do {
+            tx = randomInt(0, m_spec.width - 1);
+            ty = randomInt(0, m_spec.height - 1);
+        } while (abs(tx - cx) <= CLEAR_RADIUS && abs(ty - cy) <= CLEAR_RADIUS);
+    }
+
+    /* Adds a tile layer. The ground layer is completely filled from the
+     * first tileset; all other layers cover about a fifth of the map
+     * with tiles from any tileset. */
+    void Generator::addTileLayer(pugi::xml_node& mapnode, const string& name, bool ground)
+    {
+        const TilesetRef& last = m_tilesets.back();
+        int maxgid = ground ? m_tilesets.front().tilecount : last.firstgid + last.tilecount - 1;
+
+        ostringstream csv;
+        for(int y=0; y < m_spec.height; y++) {
+            csv << "\n";
+            for(int x=0; x < m_spec.width; x++) {
+                int gid = 0;
+                if (ground || randomInt(0, 4) == 0) {
+                    gid = randomInt(1, maxgid);
+                }
+                csv << gid;
+                if (x + 1 < m_spec.width || y + 1 < m_spec.height) {
+                    csv << ",";
+                }
+            }
+        }
+        csv << "\n";
+
+        pugi::xml_node layer = mapnode.append_child("layer");
+        layer.append_attribute("id")     = m_next_layer_id++;
+        layer.append_attribute("name")   = name.c_str();
+        layer.append_attribute("width")  = m_spec.width;
+        layer.append_attribute("height") = m_spec.height;
+
+        pugi::xml_node data = layer.append_child("data");
+        data.append_attribute("encoding") = "csv";
+        data.text().set(csv.str().c_str());
+    }
+
+    /* Adds an object of the given type at the given tile. Without
+     * width and height set later on, it is a Tiled point object. */
+    pugi::xml_node Generator::addObject(pugi::xml_node& group, const string& type, int tx, int ty)
+    {
+        pugi::xml_node obj = group.append_child("object");
+        obj.append_attribute("id") = m_next_object_id++;
+        obj.append_attribute("x")  = tx * TILEWIDTH;
+        obj.append_attribute("y")  = ty * TILEWIDTH;
+
+        pugi::xml_node prop = obj.append_child("properties").append_child("property");
+        prop.append_attribute("name")  = "type";
+        prop.append_attribute("value") = type.c_str();
+        return obj;
+    }
+
+    void addProperty(pugi::xml_node& obj, const char* name, const char* value, const char* type = nullptr)
+    {
+        pugi::xml_node prop = obj.child("properties").append_child("property");
+        prop.append_attribute("name") = name;
+        if (type) {
+            prop.append_attribute("type") = type;
+        }
+        prop.append_attribute("value") = value;
+    }
+
+    void Generator::generate(pugi::xml_document& doc)
+    {
+        pugi::xml_node decl = doc.append_child(pugi::node_declaration);
+        decl.append_attribute("version")  = "1.0";
+        decl.append_attribute("encoding") = "UTF-8";
+
+        pugi::xml_node mapnode = doc.append_child("map");
+        mapnode.append_attribute("version")     = "1.9";
+        mapnode.append_attribute("orientation") = "orthogonal";
+        mapnode.append_attribute("renderorder") = "right-down";
+        mapnode.append_attribute("width")       = m_spec.width;
+        mapnode.append_attribute("height")      = m_spec.height;
+        mapnode.append_attribute("tilewidth")   = TILEWIDTH;
+        mapnode.append_attribute("tileheight")  = TILEWIDTH;
+        mapnode.append_attribute("infinite")    = 0;
+
+        for(const TilesetRef& tileset: m_tilesets) {
+            pugi::xml_node node = mapnode.append_child("tileset");
+            node.append_attribute("firstgid") = tileset.firstgid;
+            node.append_attribute("source")   = ("../tilesets/" + tileset.filename).c_str();
+        }
+
+        // Layer order like in the shipped maps: ground, then object
+        // layers interleaved with further tile layers.
+        unsigned int tile_layers = 0;
+        if (m_spec.tile_layers > 0) {
+            addTileLayer(mapnode, "ground", true);
+            tile_layers++;
+        }
+
+        vector<pugi::xml_node> groups;
+        for(unsigned int i=0; i < m_spec.object_layers; i++) {
+            pugi::xml_node group = mapnode.append_child("objectgroup");
+            group.append_attribute("id")   = m_next_layer_id++;
+            group.append_attribute("name") = ("objects " + to_string(i + 1)).c_str();
+            groups.push_back(group);
+
+            if (tile_layers < m_spec.tile_layers) {
+                addTileLayer(mapnode, "tiles " + to_string(++tile_layers), false);
+            }
+        }
+        while (tile_layers < m_spec.tile_layers) {
+            addTileLayer(mapnode, "tiles " + to_string(++tile_layers), false);
+        }
+
+        if (groups.empty()) {
+            mapnode.append_attribute("nextlayerid")  = m_next_layer_id;
+            mapnode.append_attribute("nextobjectid") = m_next_object_id;
+            return;
+        }
+
+        int cx = m_spec.width / 2;
+        int cy = m_spec.height / 2;
+        for(int herono=1; herono <= 2; herono++) {
+            pugi::xml_node obj = addObject(groups[0], "startpos", cx + (herono == 1 ? -2 : 2), cy);
+            addProperty(obj, "startpos", to_string(herono).c_str());
+            obj.append_child("point");
+        }
+
+        // Distribute all other objects round-robin over the object layers
+        size_t group_index = 0;
+        auto nextGroup = [&]() -> pugi::xml_node& { return groups[group_index++ % groups.size()]; };
+        int tx = 0, ty = 0;
+
+        for(unsigned int i=0; i < m_spec.teleports; i++) {
+            randomTile(tx, ty);
+            pugi::xml_node entry = addObject(nextGroup(), "entry", tx, ty);
+            addProperty(entry, "enter_dir", "down");
+            entry.append_child("point");
+            int entry_id = entry.attribute("id").as_int();
+
+            randomTile(tx, ty);
+            pugi::xml_node teleport = addObject(nextGroup(), "teleport", tx, ty);
+            teleport.append_attribute("width")  = TILEWIDTH;
+            teleport.append_attribute("height") = TILEWIDTH;
+            addProperty(teleport, "entry", to_string(entry_id).c_str(), "int");
+        }
+
+        for(unsigned int i=0; i < m_spec.collboxes; i++) {
+            randomTile(tx, ty);
+            pugi::xml_node collbox = addObject(nextGroup(), "collbox", tx, ty);
+            collbox.append_attribute("width")  = min(randomInt(1, 4), m_spec.width - tx) * TILEWIDTH;
+            collbox.append_attribute("height") = min(randomInt(1, 4), m_spec.height - ty) * TILEWIDTH;
+        }
+
+        for(unsigned int i=0; i < m_spec.npcs; i++) {
+            randomTile(tx, ty);
+            pugi::xml_node npc = addObject(nextGroup(), "npc", tx, ty);
+            addProperty(npc, "graphic", "chars/spaceship.png");
+            addProperty(npc, "animation_mode", "on_move");
+            addProperty(npc, "direction", s_dirnames[randomInt(0, 3)]);
+            npc.append_child("point");
+        }
+
+        for(unsigned int i=0; i < m_spec.statics; i++) {
+            randomTile(tx, ty);
+            pugi::xml_node actor = addObject(nextGroup(), "static", tx, ty);
+            addProperty(actor, "graphic", "flags/mageflag-waving.png");
+            addProperty(actor, "animation_mode", "always");
+            actor.append_child("point");
+        }
+
+        mapnode.append_attribute("nextlayerid")  = m_next_layer_id;
+        mapnode.append_attribute("nextobjectid") = m_next_object_id;
+    }
+
+}
+
+/**
+ * Writes a synthetic map for scaling tests as specified by `spec`
+ * into `directory` and returns the path of the TMX file, which is
+ * named after `spec.name`. The map references all shipped tilesets
+ * and can be loaded by the game like any other map; put it into
+ * OS::userDataDir()/maps to play it.
+ *
+ * Objects are placed randomly (deterministic for a given seed),
+ * except for an area around the heroes' start positions in the
+ * map centre, which is kept free. Teleporters lead to entries on
+ * the same map.
+ */
+fs::path Bench::generateStressMap(const StressMapSpec& spec, const fs::path& directory)
+{
+    if (spec.width < MIN_STRESS_MAP_SIZE || spec.width > MAX_STRESS_MAP_SIZE ||
+        spec.height < MIN_STRESS_MAP_SIZE || spec.height > MAX_STRESS_MAP_SIZE) {
+        throw(runtime_error("Stress map size must be between " + to_string(MIN_STRESS_MAP_SIZE) + " and " + to_string(MAX_STRESS_MAP_SIZE) + " tiles"));
+    }
+
+    pugi::xml_document doc;
+    Generator generator(spec);
+    generator.generate(doc);
+
+    fs::create_directories(directory);
+    fs::path path = directory / OS::utf8Path(spec.name + ".tmx");
+    ofstream file(path);
+    if (!file) {
+        throw(runtime_error("Failed to open '" + OS::utf8String(path) + "' for writing"));
+    }
+    doc.save(file, " ");
+    return path;
+}
@@ -0,0 +1,29 @@
+#ifndef ILMENDUR_BENCH_STRESS_MAP_HPP
+#define ILMENDUR_BENCH_STRESS_MAP_HPP
+#include <filesystem>
+#include <string>
+
+namespace Bench {
+
+    /// Parameters for generateStressMap().
+    struct StressMapSpec
+    {
+        std::string name = "Stress Map";
+        int width = 200;              ///< Width in tiles, at most MAX_STRESS_MAP_SIZE
+        int height = 200;             ///< Height in tiles, at most MAX_STRESS_MAP_SIZE
+        unsigned int tile_layers = 3;
+        unsigned int object_layers = 1;
+        unsigned int collboxes = 500;
+        unsigned int npcs = 200;
+        unsigned int statics = 200;
+        unsigned int teleports = 20;
+        unsigned int seed = 1;
+    };
+
+    /// Maximum width and height of a generated map, in tiles.
+    const int MAX_STRESS_MAP_SIZE = 1000;
+
+    std::filesystem::path generateStressMap(const StressMapSpec& spec, const std::filesystem::path& directory);
+}
+
+#endif /* ILMENDUR_BENCH_STRESS_MAP_HPP */
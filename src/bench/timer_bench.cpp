@@ -0,0 +1,93 @@
+#include "bench.hpp"
+#include "../timer.hpp"
+#include "../clock.hpp"
+#include "../ilmendur.hpp"
+#include <memory>
+#include <random>
+
+using namespace std;
+
+/**
+ * Starts `count` timers with random intervals of up to a minute on
+ * the virtual clock, a third of them repeating, and advances the
+ * timing wheel for `options.frames` frames. Times starting the timers,
+ * each frame's Timer::updateAll(), and destroying the timers, and
+ * compares the updates with polling every timer once per frame as
+ * owners had to before. Returns false if a callback ran earlier than
+ * its deadline or later than the frame reaching it, or if
+ * Timer::nextDeadline() missed a deadline.
+ */
+bool Bench::runTimerBenchmark(size_t count, const Options& options, ostream& report)
+{
+    Clock::setVirtual(true);
+
+    mt19937 rng(options.seed);
+    uniform_int_distribution<int> interval(1, 60000);
+    uniform_int_distribution<int> repeating(0, 2);
+
+    vector<uint64_t> deadlines(count);
+    vector<int> intervals(count);
+    vector<unique_ptr<Timer>> timers(count);
+    bool in_time = true;
+    uint64_t fired = 0;
+    uint64_t now = Clock::ticks();
+
+    auto start = clock::now();
+    for(size_t i=0; i < count; i++) {
+        intervals[i] = interval(rng);
+        deadlines[i] = now + intervals[i];
+        bool repeat  = repeating(rng) == 0;
+        timers[i].reset(new Timer(static_cast<float>(intervals[i]), repeat, [&, i, repeat] {
+            uint64_t ticks = Clock::ticks();
+            in_time = in_time && ticks >= deadlines[i] && ticks - deadlines[i] < 1000 / ILMENDUR_TARGET_FRAMERATE;
+            deadlines[i] = repeat ? deadlines[i] + intervals[i] : UINT64_MAX;
+            fired++;
+        }));
+    }
+    double insert_us = elapsedUs(start);
+
+    Phase wheel, polling;
+    uint64_t polled = 0;
+    for(unsigned int frame=0; frame < options.frames; frame++) {
+        uint64_t next = Timer::nextDeadline();
+        Clock::advanceFrame();
+        now = Clock::ticks();
+
+        start = clock::now();
+        for(size_t i=0; i < count; i++) {
+            if (deadlines[i] <= now) {
+                polled++;
+            }
+        }
+        polling.add(elapsedUs(start));
+
+        uint64_t fired_before = fired;
+        start = clock::now();
+        Timer::updateAll();
+        wheel.add(elapsedUs(start));
+
+        // Nothing may fire before the deadline the main loop sleeps to.
+        in_time = in_time && (fired == fired_before || next <= now);
+    }
+
+    start = clock::now();
+    timers.clear();
+    double cancel_us = elapsedUs(start);
+    bool empty = Timer::nextDeadline() == UINT64_MAX;
+
+    Clock::setVirtual(false);
+
+    report << "{\"timers\":" << count
+           << ",\"fired\":" << fired
+           << ",\"polled\":" << polled
+           << ",\"in_time\":" << (in_time && empty ? "true" : "false")
+           << ",\"insert_ns\":" << insert_us * 1000.0 / count
+           << ",\"cancel_ns\":" << cancel_us * 1000.0 / count
+           << ",\"wheel\":";
+    wheel.writeJson(report);
+    report << ",\"polling\":";
+    polling.writeJson(report);
+    report << "}";
+
+    return in_time && empty;
+}
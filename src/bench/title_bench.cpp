@@ -0,0 +1,59 @@
+#include "bench.hpp"
+#include "../ilmendur.hpp"
+#include "../render_list.hpp"
+#include "../scenes/title_scene.hpp"
+#include "../imgui/imgui.h"
+
+using namespace std;
+
+/**
+ * Times the main thread's work for one frame of the title screen:
+ * ImGui::NewFrame(), TitleScene::update(), ImGui::Render() and
+ * recording the draw data into a RenderList, as Ilmendur::run() does.
+ * Polling SDL events and executing the list on the render thread are
+ * not included, as there is no window. Uses its own ImGui context
+ * with the default font. Always returns true.
+ *
+ * Multiplied by the frame rate, this is the main thread's CPU load on
+ * the title screen: ILMENDUR_TARGET_FRAMERATE frames per second if
+ * the main loop does not wait while idle, one frame per
+ * Ilmendur::waitWhileIdle() timeout if it does.
+ */
+bool Bench::runTitleFrameBenchmark(const Options& options, ostream& report)
+{
+    ImGuiContext* p_context = ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+    io.DeltaTime   = 1.0f / ILMENDUR_TARGET_FRAMERATE;
+    unsigned char* p_pixels = nullptr;
+    int width  = 0;
+    int height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&p_pixels, &width, &height);
+
+    Phase frame;
+    int vertices = 0;
+    {
+        TitleScene scene;
+        RenderList list;
+        for(unsigned int i=0; i < options.frames; i++) {
+            auto start = clock::now();
+            list.reset();
+            ImGui::NewFrame();
+            scene.update();
+            ImGui::Render();
+            list.drawImGui(ImGui::GetDrawData());
+            list.present();
+            frame.add(elapsedUs(start));
+            vertices = ImGui::GetDrawData()->TotalVtxCount;
+        }
+    }
+    ImGui::DestroyContext(p_context);
+
+    report << "{\"vertices\":" << vertices
+           << ",\"frame\":";
+    frame.writeJson(report);
+    report << "}";
+
+    return true;
+}
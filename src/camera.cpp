@@ -1,10 +1,14 @@
 #include "camera.hpp"
+#include "render_list.hpp"
 #include <cassert>
+#include <cmath>
 
 using namespace std;
 
 Camera::Camera(Scene& m_scene, const SDL_Rect& initial_view)
-    : mr_scene(m_scene)
+    : mr_scene(m_scene),
+      m_zoom(1.0f),
+      mp_hero(nullptr)
 {
     m_view = initial_view;
     assert(initial_view.w != 0);
@@ -46,6 +50,26 @@ void Camera::setViewport(const SDL_Rect& r)
     assert(m_cliprect.x == 0 && m_cliprect.y == 0); // See comments in draw() for explanation
 }
 
+/**
+ * Zooms the camera by `zoom`, which may be fractional: 2 shows
+ * everything twice as large, 0.5 half as large. The view is resized
+ * to the viewport divided by `zoom` around its current centre; the
+ * scaling itself is done by the renderer (see draw()) and the choice
+ * of tileset textures (see Tileset::atlasLevel()). A viewport must
+ * have been set.
+ */
+void Camera::setZoom(float zoom)
+{
+    assert(zoom > 0.0f);
+    assert(m_viewport.w > 0 && m_viewport.h > 0);
+
+    Vector2f centre(m_view.x + m_view.w / 2.0f, m_view.y + m_view.h / 2.0f);
+    m_zoom   = zoom;
+    m_view.w = lround(m_viewport.w / zoom);
+    m_view.h = lround(m_viewport.h / zoom);
+    setPosition(centre);
+}
+
 /**
  * Sets the maximum camera bounds. The camera may not show anything
  * outside the given rectangle, which is in world coordinates. Any
@@ -86,11 +110,19 @@ void Camera::setPosition(const Vector2f& pos)
     }
 }
 
-void Camera::draw(SDL_Renderer* p_renderer)
+/**
+ * Sets up the renderer for drawing this camera's view, which is then
+ * drawn in view coordinates: the viewport and clip rectangle in screen
+ * pixels, and the renderer scale to the camera's zoom.
+ */
+void Camera::draw(RenderList* p_renderer)
 {
     if (m_viewport.w > 0) {
-        SDL_RenderSetClipRect(p_renderer, nullptr); // Do not remove this. Without it the below RendetSetClipRect will not work.
-        SDL_RenderSetViewport(p_renderer, &m_viewport);
+        // SDL scales the viewport and clip rectangle by the scale in
+        // effect when they are set, so set them unscaled
+        p_renderer->setScale(1.0f, 1.0f);
+        p_renderer->setClipRect(nullptr); // Do not remove this. Without it the below RendetSetClipRect will not work.
+        p_renderer->setViewport(&m_viewport);
         /* SDL_RenderSetViewport() does not guarantee that spurious
          * material outside the viewport is cut off. It appearently
          * (on Linux) does such cutting off if the viewport is /not/
@@ -99,6 +131,7 @@ void Camera::draw(SDL_Renderer* p_renderer)
          * notice that cliprects are always relative to the viewport,
          * so that the cliprect is required to start at (0|0) and have
          * the width and height equal to those of the viewport. */
-        SDL_RenderSetClipRect(p_renderer, &m_cliprect);
+        p_renderer->setClipRect(&m_cliprect);
+        p_renderer->setScale(m_zoom, m_zoom);
     }
 }
@@ -4,6 +4,8 @@
 #include <SDL2/SDL.h>
 
 class Scene;
+class RenderList;
+class Hero;
 
 class Camera
 {
@@ -15,17 +17,27 @@ public:
     inline const SDL_Rect& view() { return m_view; }
     inline const SDL_Rect& viewport() { return m_viewport; }
 
-    void draw(SDL_Renderer* p_renderer);
+    void draw(RenderList* p_renderer);
 
     void setPosition(const Vector2f& pos);
     void setBounds(const SDL_Rect& r);
     void setViewport(const SDL_Rect& viewport);
+    void setZoom(float zoom);
+    /// Pixels on screen per pixel of the world.
+    inline float zoom() const { return m_zoom; }
+
+    /// The hero this camera follows, whose look direction decides
+    /// which layers are drawn; see Map::drawLayers(). May be nullptr.
+    inline void setHero(Hero* p_hero) { mp_hero = p_hero; }
+    inline Hero* hero() const { return mp_hero; }
 private:
     Scene& mr_scene;
     SDL_Rect m_view;
     SDL_Rect m_bounds;
     SDL_Rect m_viewport;
     SDL_Rect m_cliprect;
+    float m_zoom;
+    Hero* mp_hero;
 };
 
 #endif /* ILMENDUR_CAMERA_HPP */
@@ -0,0 +1,47 @@
+#include "clock.hpp"
+#include "ilmendur.hpp"
+#include <SDL2/SDL.h>
+
+using namespace std;
+
+static bool s_virtual = false;
+static uint64_t s_frames = 0;
+
+/**
+ * Returns the current game time in milliseconds. The virtual clock
+ * starts at one frame length rather than at zero, as some callers
+ * use a zero timestamp to mean "unset".
+ */
+uint64_t Clock::ticks()
+{
+    if (s_virtual) {
+        return ((s_frames + 1) * 1000) / ILMENDUR_TARGET_FRAMERATE;
+    } else {
+        return SDL_GetTicks64();
+    }
+}
+
+/**
+ * Switch between wall-clock time and virtual time. Switching to
+ * virtual time resets the virtual clock; do this before the first
+ * frame only.
+ */
+void Clock::setVirtual(bool enable)
+{
+    s_virtual = enable;
+    s_frames  = 0;
+}
+
+bool Clock::isVirtual()
+{
+    return s_virtual;
+}
+
+/**
+ * Advances the virtual clock by one frame. Call this exactly once
+ * at the end of each frame from the main loop.
+ */
+void Clock::advanceFrame()
+{
+    s_frames++;
+}
@@ -0,0 +1,25 @@
+#ifndef ILMENDUR_CLOCK_HPP
+#define ILMENDUR_CLOCK_HPP
+#include <cstdint>
+
+/**
+ * Game time. Code that needs to know the current time, e.g. to
+ * calculate movement, should ask this module instead of calling
+ * SDL_GetTicks64() directly.
+ *
+ * By default, ticks() is the wall-clock time as returned by SDL.
+ * When input is recorded or replayed (see the Input module), the
+ * clock is switched to virtual time, which only advances by exactly
+ * one frame length on each call to advanceFrame() from the main loop.
+ * This makes the game state a pure function of the input sequence,
+ * regardless of how long the individual frames took.
+ */
+namespace Clock {
+    uint64_t ticks();
+
+    void setVirtual(bool enable);
+    bool isVirtual();
+    void advanceFrame();
+}
+
+#endif /* ILMENDUR_CLOCK_HPP */
@@ -0,0 +1,42 @@
+#include "dirty_region.hpp"
+
+using namespace std;
+
+/**
+ * Adds `rect` to the region. Empty rectangles are ignored.
+ */
+void DirtyRegion::add(const SDL_Rect& rect)
+{
+    if (SDL_RectEmpty(&rect)) {
+        return;
+    }
+
+    // Join with all rectangles overlapping it. The union may overlap
+    // further rectangles, so start over until none is left.
+    SDL_Rect joined = rect;
+    size_t i = 0;
+    while (i < m_rects.size()) {
+        if (SDL_HasIntersection(&m_rects[i], &joined)) {
+            SDL_UnionRect(&m_rects[i], &joined, &joined);
+            m_rects[i] = m_rects.back();
+            m_rects.pop_back();
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    m_rects.push_back(joined);
+
+    if (m_rects.size() > MAX_RECTS) {
+        for(size_t j=1; j < m_rects.size(); j++) {
+            SDL_UnionRect(&m_rects[0], &m_rects[j], &m_rects[0]);
+        }
+        m_rects.resize(1);
+    }
+}
+
+/// Empties the region.
+void DirtyRegion::clear()
+{
+    m_rects.clear();
+}
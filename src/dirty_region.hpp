@@ -0,0 +1,28 @@
+#ifndef ILMENDUR_DIRTY_REGION_HPP
+#define ILMENDUR_DIRTY_REGION_HPP
+#include <vector>
+#include <SDL2/SDL.h>
+
+/**
+ * The part of a view that changed since it was last drawn, as a short
+ * list of disjoint rectangles. Rectangles that overlap when added are
+ * joined into their union; once there are more than MAX_RECTS of them,
+ * the region degrades to their bounding box, as many small redraws
+ * then cost more than one large one. See Map::draw().
+ */
+class DirtyRegion
+{
+public:
+    /// Rectangles kept before degrading to the bounding box.
+    static const size_t MAX_RECTS = 16;
+
+    void add(const SDL_Rect& rect);
+    void clear();
+
+    inline bool empty() const { return m_rects.empty(); }
+    inline const std::vector<SDL_Rect>& rects() const { return m_rects; }
+private:
+    std::vector<SDL_Rect> m_rects;
+};
+
+#endif /* ILMENDUR_DIRTY_REGION_HPP */
@@ -80,7 +80,9 @@ namespace {
 
             if (m_textvel != 0.0f) {
                 mp_timer = std::unique_ptr<Timer>(new Timer(m_textvel, true, [&]{
-                    m_displayed_text_range++;
+                    if (++m_displayed_text_range >= m_texts[m_current_text].size()) {
+                        mp_timer->stop();
+                    }
                 }));
             }
 
@@ -101,12 +103,6 @@ namespace {
 
         void update() {
             assert(m_current_text < m_texts.size());
-            if (mp_timer) {
-                mp_timer->update();
-                if (m_displayed_text_range > m_texts[m_current_text].size()) {
-                    mp_timer->stop();
-                }
-            }
 
             // Ensure that the pointer arithmetic further below remains in the string's boundaries
             if (m_displayed_text_range > m_texts[m_current_text].size()) {
@@ -153,17 +149,22 @@ namespace {
 
             // Display the continuation marker and play the talk ending sound on the last text
             if (m_displayed_text_range >= m_texts[m_current_text].length()) {
-                string terminator;
+                static const StringId s_talkfin1  = StringId::find("ui/talkfin1.ogg"_hs);
+                static const StringId s_talkfin2  = StringId::find("ui/talkfin2.ogg"_hs);
+                static const StringId s_square    = StringId::find("ui/square.png"_hs);
+                static const StringId s_arrowdown = StringId::find("ui/arrowdown.png"_hs);
+
+                StringId terminator;
                 if (m_current_text == m_texts.size() - 1) {
                     if (!m_endmark_sound_played) {
-                        Ilmendur::instance().audioSystem().playSound(m_herono == 2 ? "ui/talkfin2.ogg" : "ui/talkfin1.ogg", AudioSystem::channel::ui);
+                        Ilmendur::instance().audioSystem().playSound(m_herono == 2 ? s_talkfin2 : s_talkfin1, AudioSystem::channel::ui);
                         m_endmark_sound_played = true;
                     }
 
-                    terminator = "ui/square.png";
+                    terminator = s_square;
                 } else {
                     // No sound for continuing texts.
-                    terminator = "ui/arrowdown.png";
+                    terminator = s_arrowdown;
                 }
 
                 ImGui::SetNextWindowPos(ImVec2(boxarea.x + boxarea.w - 52, boxarea.y + boxarea.h - 28));
@@ -175,6 +176,10 @@ namespace {
         }
 
         bool next() {
+            static const StringId s_talkendmark1 = StringId::find("ui/talkendmark1.ogg"_hs);
+            static const StringId s_continue1    = StringId::find("ui/continue1.ogg"_hs);
+            static const StringId s_continue2    = StringId::find("ui/continue2.ogg"_hs);
+
             // The user wants to click through if this triggers (text
             // display not finished).
             if (m_displayed_text_range < m_texts[m_current_text].length()) {
@@ -191,16 +196,16 @@ namespace {
 
                 if (m_herono == 2) {
                     // TODO: Create a higher-pitch version of talkendmark1 for hero 2 and play that one based on `m_herono'.
-                    Ilmendur::instance().audioSystem().playSound("ui/talkendmark1.ogg", AudioSystem::channel::ui);
+                    Ilmendur::instance().audioSystem().playSound(s_talkendmark1, AudioSystem::channel::ui);
                 } else { // Hero 1 or full-screen dialogue
-                    Ilmendur::instance().audioSystem().playSound("ui/talkendmark1.ogg", AudioSystem::channel::ui);
+                    Ilmendur::instance().audioSystem().playSound(s_talkendmark1, AudioSystem::channel::ui);
                 }
                 return false;
             } else { // Another text to display
                 if (m_herono == 2) {
-                    Ilmendur::instance().audioSystem().playSound("ui/continue2.ogg", AudioSystem::channel::ui);
+                    Ilmendur::instance().audioSystem().playSound(s_continue2, AudioSystem::channel::ui);
                 } else { // Hero 1 or full-screen dialogue
-                    Ilmendur::instance().audioSystem().playSound("ui/continue1.ogg", AudioSystem::channel::ui);
+                    Ilmendur::instance().audioSystem().playSound(s_continue1, AudioSystem::channel::ui);
                 }
             }
 
@@ -210,7 +215,9 @@ namespace {
             } else {
                 m_displayed_text_range = 0;
                 mp_timer = std::unique_ptr<Timer>(new Timer(m_textvel, true, [&]{
-                    m_displayed_text_range++;
+                    if (++m_displayed_text_range >= m_texts[m_current_text].size()) {
+                        mp_timer->stop();
+                    }
                 }));
             }
 
@@ -283,7 +290,7 @@ void GUISystem::loadFonts()
     namespace fs = std::filesystem;
 
     ImGuiIO& io = ImGui::GetIO();
-    fs::path fontpath(OS::gameDataDir() / fs::u8path("fonts") / fs::u8path("LinLibertine_R.otf"));
+    fs::path fontpath(OS::gameDataDir() / OS::utf8Path("fonts") / OS::utf8Path("LinLibertine_R.otf"));
     ifstream file(fontpath, ifstream::in | ifstream::binary);
     string binary(READ_FILE(file));
 
@@ -15,11 +15,11 @@ void I18n::setup()
     fs::path transdir;
 #ifdef ILMENDUR_DEBUG_BUILD
     // Support running from the build directory in debug mode
-    if (fs::exists(OS::exePath().parent_path() / fs::u8path("CMakeCache.txt"))) {
-        transdir = fs::current_path() / fs::u8path("translations");
+    if (fs::exists(OS::exePath().parent_path() / OS::utf8Path("CMakeCache.txt"))) {
+        transdir = fs::current_path() / OS::utf8Path("translations");
     } else {
 #endif
-        transdir = OS::gameDataDir() / fs::u8path("translations");
+        transdir = OS::gameDataDir() / OS::utf8Path("translations");
 #ifdef ILMENDUR_DEBUG_BUILD
     }
 #endif
@@ -12,19 +12,28 @@
 #include "imgui/imgui_impl_sdlrenderer.h"
 #include "i18n.hpp"
 #include "map_controllers/map_controller.hpp"
+#include "profiler.hpp"
+#include "clock.hpp"
+#include "input.hpp"
+#include "jobs.hpp"
+#include "render_thread.hpp"
+#include "timer.hpp"
+#include "script.hpp"
+#include "os.hpp"
 #include <chrono>
+#include <cstdint>
+#include <algorithm>
 #include <thread>
+#include <filesystem>
 #include <stdexcept>
 #include <cassert>
+#include <iostream>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 
-#ifdef ILMENDUR_DEBUG_BUILD
-#include <iostream>
-#endif
-
 using namespace std;
+namespace fs = std::filesystem;
 
 /* Window dimensions. Do not occupy the full HD space by default,
  * so that window decorations do not cause the window to become
@@ -36,23 +45,53 @@ using namespace std;
 // The maximum length of one frame, calculated from the desired frame rate.
 const chrono::milliseconds TARGET_FRAMETIME{1000 / ILMENDUR_TARGET_FRAMERATE};
 
+/* Frames drawn at full rate after input or a scene change before the
+ * main loop may wait for input; ImGui needs a few frames to settle,
+ * e.g. to move the hover highlight. */
+#define IDLE_GRACE_FRAMES 4
+
+/* Longest wait for input in milliseconds, so that changes nobody
+ * reports as a deadline are still shown eventually. */
+#define MAX_IDLE_WAIT 1000
+
 static Ilmendur* sp_ilmendur = nullptr;
 
-Ilmendur::Ilmendur()
+/**
+ * Sets up the game. `args` are the command line arguments without
+ * the programme name; see parseCommandLine() for the recognised
+ * options.
+ */
+Ilmendur::Ilmendur(const vector<string>& args)
     : mp_window(nullptr),
-      mp_renderer(nullptr),
+      mp_render_thread(nullptr),
       mp_texture_pool(nullptr),
       mp_audio_system(nullptr),
+      mp_job_system(nullptr),
       mp_next_scene(nullptr),
-      m_pop_scene(false)
+      m_pop_scene(false),
+      m_busy_frames(IDLE_GRACE_FRAMES),
+      m_headless(false),
+      m_trace_frames(0),
+      m_threads(0)
 {
     if (sp_ilmendur) {
         throw(runtime_error("Ilmendur is a singleton!"));
     }
     sp_ilmendur = this;
 
+    parseCommandLine(args);
+
+    mp_job_system = new JobSystem(m_threads);
+
     I18n::setup();
 
+    // Headless mode uses SDL's dummy drivers, which need no display
+    // and no sound card. Rendering then happens in software.
+    if (m_headless) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    }
+
     if (SDL_Init(SDL_INIT_EVERYTHING) < 0) {
         throw(runtime_error(string("SDL_Init() failed: ") + SDL_GetError()));
     }
@@ -64,26 +103,39 @@ Ilmendur::Ilmendur()
     }
     assert(Mix_OpenAudio(MIX_DEFAULT_FREQUENCY, MIX_DEFAULT_FORMAT, 4, 4096) == 0);
 
-    // TODO: add flag SDL_WINDOW_ALLOW_HIGHDPI
-    if (SDL_CreateWindowAndRenderer(NORMAL_WINDOW_WIDTH, NORMAL_WINDOW_HEIGHT, SDL_WINDOW_OPENGL, &mp_window, &mp_renderer) < 0) {
-        throw(runtime_error(string("SDL_CreateWindowAndRenderer() failed: ") + SDL_GetError()));
+    // The window belongs to the main thread, which handles its
+    // events; the renderer is created by the render thread.
+    if (m_headless) {
+        mp_window = SDL_CreateWindow("Ilmendur", 0, 0, NORMAL_WINDOW_WIDTH, NORMAL_WINDOW_HEIGHT, SDL_WINDOW_HIDDEN);
+    } else {
+        // TODO: add flag SDL_WINDOW_ALLOW_HIGHDPI
+        mp_window = SDL_CreateWindow("Ilmendur", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, NORMAL_WINDOW_WIDTH, NORMAL_WINDOW_HEIGHT, SDL_WINDOW_OPENGL);
+    }
+    if (!mp_window) {
+        throw(runtime_error(string("SDL_CreateWindow() failed: ") + SDL_GetError()));
     }
 
-    assert(mp_window);
-    assert(mp_renderer);
+    mp_render_thread = new RenderThread(mp_window, m_headless ? SDL_RENDERER_SOFTWARE : 0);
 
+    // The platform backend gets no renderer, so that it does not query
+    // it from the main thread; it falls back to the window's size then.
     ImGui::CreateContext();
-    ImGui_ImplSDL2_InitForSDLRenderer(mp_window, mp_renderer);
-    ImGui_ImplSDLRenderer_Init(mp_renderer);
+    ImGui_ImplSDL2_InitForSDLRenderer(mp_window, nullptr);
 
     m_render_area.x = 0;
     m_render_area.y = 0;
-    SDL_GetRendererOutputSize(mp_renderer, &m_render_area.w, &m_render_area.h);
-
 #ifdef ILMENDUR_DEBUG_BUILD
     SDL_RendererInfo ri;
-    SDL_GetRendererInfo(mp_renderer, &ri);
+#endif
+    mp_render_thread->invoke([&](SDL_Renderer* p_renderer){
+        ImGui_ImplSDLRenderer_Init(p_renderer);
+        SDL_GetRendererOutputSize(p_renderer, &m_render_area.w, &m_render_area.h);
+#ifdef ILMENDUR_DEBUG_BUILD
+        SDL_GetRendererInfo(p_renderer, &ri);
+#endif
+    });
 
+#ifdef ILMENDUR_DEBUG_BUILD
     cout << "Renderer information: " << endl
          << "    Name:             " << ri.name << endl
          << "    Supported flags:  " << ri.flags << endl
@@ -112,7 +164,7 @@ Ilmendur::~Ilmendur()
         m_scene_stack.pop();
     }
 
-    ImGui_ImplSDLRenderer_Shutdown();
+    mp_render_thread->invoke([](SDL_Renderer*){ ImGui_ImplSDLRenderer_Shutdown(); });
     ImGui_ImplSDL2_Shutdown();
     ImGui::DestroyContext();
 
@@ -124,7 +176,9 @@ Ilmendur::~Ilmendur()
         delete mp_texture_pool;
     }
 
-    SDL_DestroyRenderer(mp_renderer);
+    delete mp_job_system;
+
+    delete mp_render_thread;
     SDL_DestroyWindow(mp_window);
 
     Mix_Quit();
@@ -133,6 +187,60 @@ Ilmendur::~Ilmendur()
     sp_ilmendur = nullptr;
 }
 
+/**
+ * Evaluates the command line arguments. Recognised options:
+ *
+ * --headless::
+ *   Use SDL's dummy video and audio drivers with the software renderer.
+ *   Nothing is shown on screen and no sound is played.
+ * --record FILE::
+ *   Record all input into FILE for later replay with --replay.
+ * --replay FILE::
+ *   Replay the input recorded with --record instead of reading live
+ *   input, as fast as possible, and exit when the recording ends.
+ *   Together with --headless, this is meant for comparing the
+ *   performance of different builds.
+ * --trace FILE::
+ *   Record a Chrome trace (loadable in Perfetto) into FILE, starting
+ *   before assets are loaded. Requires ENABLE_PROFILER.
+ * --trace-frames N::
+ *   Stop the trace requested with --trace after N frames. Without
+ *   this option, the trace is written on exit or when pressing F4.
+ * --threads N::
+ *   Use N threads for updating the map (see JobSystem), including
+ *   the main thread. Defaults to one per CPU core.
+ */
+void Ilmendur::parseCommandLine(const vector<string>& args)
+{
+    for(size_t i=0; i < args.size(); i++) {
+        if (args[i] == "--headless") {
+            m_headless = true;
+        } else if (args[i] == "--record" && i + 1 < args.size()) {
+            m_record_path = args[++i];
+        } else if (args[i] == "--replay" && i + 1 < args.size()) {
+            m_replay_path = args[++i];
+        } else if (args[i] == "--trace" && i + 1 < args.size()) {
+            m_trace_path = args[++i];
+        } else if (args[i] == "--trace-frames" && i + 1 < args.size()) {
+            m_trace_frames = stoul(args[++i]);
+        } else if (args[i] == "--threads" && i + 1 < args.size()) {
+            m_threads = stoul(args[++i]);
+        } else {
+            throw(runtime_error("Invalid command line argument `" + args[i] + "'"));
+        }
+    }
+
+    if (!m_record_path.empty() && !m_replay_path.empty()) {
+        throw(runtime_error("--record and --replay cannot be combined"));
+    }
+
+#ifndef ENABLE_PROFILER
+    if (!m_trace_path.empty()) {
+        throw(runtime_error("--trace requires a build with ENABLE_PROFILER"));
+    }
+#endif
+}
+
 Ilmendur& Ilmendur::instance()
 {
     return *sp_ilmendur;
@@ -159,72 +267,155 @@ SDL_Rect Ilmendur::viewportPlayer2() const
     return SDL_Rect{m_render_area.w/2+1,0,m_render_area.w/2-1,m_render_area.h};
 }
 
-int Ilmendur::run()
+/**
+ * Loads textures, sounds, and fonts from disk. This is called by
+ * run(); only call it yourself if you use the game's subsystems
+ * without the main loop, as the benchmark runner does.
+ */
+void Ilmendur::loadAssets()
 {
-    using namespace std::chrono;
-
+    assert(!mp_texture_pool);
     mp_texture_pool = new TexturePool();
     mp_audio_system = new AudioSystem();
 
     GUISystem::loadFonts();
+
+    // Creates ImGui's font texture, which the renderer backend would
+    // otherwise do in the first ImGui_ImplSDLRenderer_NewFrame() --
+    // on the main thread.
+    mp_render_thread->invoke([](SDL_Renderer*){ ImGui_ImplSDLRenderer_NewFrame(); });
+}
+
+int Ilmendur::run()
+{
+    using namespace std::chrono;
+
+#ifdef ENABLE_PROFILER
+    if (!m_trace_path.empty()) {
+        Profiler::startTrace(OS::utf8Path(m_trace_path), m_trace_frames);
+    }
+#endif
+
+    loadAssets();
     MapControllers::MapController::createAllMapControllers();
 
     m_scene_stack.push(new TitleScene());
     m_scene_stack.top()->setup();
 
+    if (!m_record_path.empty()) {
+        Input::startRecording(OS::utf8Path(m_record_path));
+    } else if (!m_replay_path.empty()) {
+        Input::startReplay(OS::utf8Path(m_replay_path));
+    }
+
     ImGuiIO& io = ImGui::GetIO();
+    high_resolution_clock::time_point run_start_time = high_resolution_clock::now();
     high_resolution_clock::time_point start_time;
     milliseconds passed_time;
     bool run = true;
     while (run) {
         start_time = high_resolution_clock::now();
+#ifdef ENABLE_PROFILER
+        Profiler::beginFrame();
+#endif
 
-        SDL_Event ev;
-        while (SDL_PollEvent(&ev)) {
-            ImGui_ImplSDL2_ProcessEvent(&ev);
-            if (GUISystem::handleEvent(ev)) {
-                continue;
-            }
-
-            switch (ev.type) {
-            case SDL_QUIT:
-                run = false;
-                break;
-            case SDL_KEYDOWN:
-                // Ignore event if ImGui has focus
-                if (!io.WantCaptureKeyboard) {
-                    m_scene_stack.top()->handleKeyDown(ev);
+        {
+            PROFILE_SCOPE("Event polling");
+            SDL_Event ev;
+            while (Input::pollEvent(&ev)) {
+                m_busy_frames = IDLE_GRACE_FRAMES;
+                ImGui_ImplSDL2_ProcessEvent(&ev);
+                if (GUISystem::handleEvent(ev)) {
+                    continue;
                 }
-                break;
-            case SDL_KEYUP:
-                // Ignore event if ImGui has focus
-                if (!io.WantCaptureKeyboard) {
-                    m_scene_stack.top()->handleKeyUp(ev);
+
+                switch (ev.type) {
+                case SDL_QUIT:
+                    run = false;
+                    break;
+                case SDL_KEYDOWN:
+                    // Ignore event if ImGui has focus
+                    if (!io.WantCaptureKeyboard) {
+                        m_scene_stack.top()->handleKeyDown(ev);
+                    }
+                    break;
+                case SDL_KEYUP:
+#ifdef ENABLE_PROFILER
+                    if (ev.key.keysym.sym == SDLK_F3) {
+                        Profiler::toggleOverlay();
+                        break;
+                    } else if (ev.key.keysym.sym == SDLK_F4) {
+                        Profiler::toggleTrace();
+                        break;
+                    }
+#endif
+                    // Ignore event if ImGui has focus
+                    if (!io.WantCaptureKeyboard) {
+                        m_scene_stack.top()->handleKeyUp(ev);
+                    }
+                    break;
+                default:
+                    // Ignore
+                    break;
                 }
-                break;
-            default:
-                // Ignore
-                break;
             }
         }
 
         ImGui_ImplSDL2_NewFrame();
-        ImGui_ImplSDLRenderer_NewFrame();
+        if (Clock::isVirtual()) {
+            io.DeltaTime = 1.0f / ILMENDUR_TARGET_FRAMERATE;
+        }
         ImGui::NewFrame();
 
-        m_scene_stack.top()->update();
-        GUISystem::update();
+        {
+            PROFILE_SCOPE("Timer::updateAll");
+            Timer::updateAll();
+        }
+        {
+            PROFILE_SCOPE("Scripts::update");
+            Scripts::update();
+        }
+        {
+            PROFILE_SCOPE("Scene::update");
+            m_scene_stack.top()->update();
+        }
+        {
+            PROFILE_SCOPE("GUISystem::update");
+            GUISystem::update();
+        }
+#ifdef ENABLE_PROFILER
+        Profiler::drawOverlay();
+#endif
 
-        SDL_RenderSetViewport(mp_renderer, nullptr);
-        SDL_RenderSetClipRect(mp_renderer, nullptr);
-        SDL_SetRenderDrawColor(mp_renderer, 0, 0, 0, 255);
-        SDL_RenderClear(mp_renderer);
-        m_scene_stack.top()->draw(mp_renderer);
-        ImGui::Render();
-        ImGui_ImplSDLRenderer_RenderDrawData(ImGui::GetDrawData());
-        SDL_RenderPresent(mp_renderer);
+        // Record the frame; the render thread draws it while the
+        // next frame is being simulated.
+        RenderList& frame = mp_render_thread->beginFrame();
+        frame.setScale(1.0f, 1.0f);
+        frame.setViewport(nullptr);
+        frame.setClipRect(nullptr);
+        frame.setDrawColor(0, 0, 0, 255);
+        frame.clear();
+        {
+            PROFILE_SCOPE("Scene::draw");
+            m_scene_stack.top()->draw(&frame);
+        }
+        {
+            PROFILE_SCOPE("ImGui render");
+            ImGui::Render();
+            frame.setScale(1.0f, 1.0f); // Undo camera zoom, which SDL would apply to ImGui as well
+            frame.drawImGui(ImGui::GetDrawData());
+        }
+        frame.present();
+        {
+            PROFILE_SCOPE("Submit frame");
+            mp_render_thread->submitFrame();
+        }
 
+        if (m_pop_scene || mp_next_scene) {
+            m_busy_frames = IDLE_GRACE_FRAMES;
+        }
         if (m_pop_scene) {
+            PROFILE_SCOPE("Ilmendur::popScene");
             Scene* p_scene = m_scene_stack.top();
             m_scene_stack.pop();
             m_pop_scene = false;
@@ -235,6 +426,7 @@ int Ilmendur::run()
             }
         }
         if (mp_next_scene) {
+            PROFILE_SCOPE("Ilmendur::pushScene");
             m_scene_stack.push(mp_next_scene);
             mp_next_scene = nullptr;
 
@@ -243,9 +435,17 @@ int Ilmendur::run()
             }
         }
 
+        Input::endFrame();
+        Clock::advanceFrame();
+#ifdef ENABLE_PROFILER
+        Profiler::endFrame();
+#endif
+
         // Throttle framerate to a fixed one (fixed frame rate)
         passed_time = duration_cast<milliseconds>(high_resolution_clock::now() - start_time);
-        if (passed_time < TARGET_FRAMETIME) {
+        if (Input::isReplaying()) {
+            // Replays run as fast as possible
+        } else if (passed_time < TARGET_FRAMETIME) {
             this_thread::sleep_for(TARGET_FRAMETIME - passed_time);
         }
 #ifdef ILMENDUR_DEBUG_BUILD
@@ -253,13 +453,62 @@ int Ilmendur::run()
             cout << "Warning: Framerate below " << ILMENDUR_TARGET_FRAMERATE << "!" << endl;
         }
 #endif
+
+        if (run && !Clock::isVirtual()) {
+            waitWhileIdle();
+        }
     }
 
+    if (Input::isReplaying()) {
+        double secs = duration<double>(high_resolution_clock::now() - run_start_time).count();
+        cout << "Replayed " << Input::frame() << " frames in " << secs << " s ("
+             << (Input::frame() > 0 ? secs * 1000.0 / Input::frame() : 0.0) << " ms per frame)" << endl;
+    }
+    mp_render_thread->finish();
+    Input::stop();
+
     MapControllers::MapController::freeAllMapControllers();
 
+#ifdef ENABLE_PROFILER
+    Profiler::stopTrace();
+#endif
+
     return 0;
 }
 
+/**
+ * Blocks until input arrives if nothing would change in the next frame
+ * otherwise: the current scene reports to be idle, no script waits
+ * for the next frame, and there was no input for IDLE_GRACE_FRAMES
+ * frames. The wait ends early at the deadline the scene reports, e.g.
+ * the next frame of an animated tile, or when the next Timer is due,
+ * and after MAX_IDLE_WAIT at most. The screen keeps showing the last
+ * frame meanwhile. Not used with the virtual clock of input
+ * recording and replay, where frames and not time drive the game.
+ * The time spent waiting shows up as "Wait for input" in the profiler
+ * overlay and trace.
+ */
+void Ilmendur::waitWhileIdle()
+{
+    if (m_busy_frames > 0) {
+        m_busy_frames--;
+        return;
+    }
+
+    uint64_t wakeup = Timer::nextDeadline();
+    if (m_scene_stack.empty() || !m_scene_stack.top()->isIdle(&wakeup) || !Scripts::isIdle()) {
+        return;
+    }
+
+    uint64_t now = Clock::ticks();
+    if (wakeup <= now) {
+        return;
+    }
+
+    PROFILE_SCOPE("Wait for input");
+    SDL_WaitEventTimeout(nullptr, static_cast<int>(min<uint64_t>(wakeup - now, MAX_IDLE_WAIT)));
+}
+
 Scene& Ilmendur::currentScene()
 {
     return *m_scene_stack.top();
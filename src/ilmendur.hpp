@@ -2,29 +2,36 @@
 #define ILMENDUR_ILMENDUR_HPP
 #include <SDL2/SDL.h>
 #include <stack>
+#include <string>
+#include <vector>
 
 /// Target framerate in frames per second (fps).
 const unsigned int ILMENDUR_TARGET_FRAMERATE = 40;
 
 class TexturePool;
 class AudioSystem;
+class JobSystem;
+class RenderThread;
 class Scene;
 class DebugMapScene;
 
 class Ilmendur
 {
 public:
-    Ilmendur();
+    Ilmendur(const std::vector<std::string>& args = std::vector<std::string>());
     ~Ilmendur();
 
     static Ilmendur& instance();
 
+    void loadAssets();
     int run();
 
     inline SDL_Window*   sdlWindow()   { return mp_window; }
-    inline SDL_Renderer* sdlRenderer() { return mp_renderer; }
+    inline RenderThread& renderThread() { return *mp_render_thread; }
     inline TexturePool&  texturePool() { return *mp_texture_pool; }
     inline AudioSystem&  audioSystem() { return *mp_audio_system; }
+    inline JobSystem&    jobSystem()   { return *mp_job_system; }
+    inline bool          isHeadless() const { return m_headless; }
 
     const SDL_Rect& renderArea() const;
     SDL_Rect viewportPlayer1() const;
@@ -36,15 +43,27 @@ public:
 
 private:
     void playAudio();
+    void parseCommandLine(const std::vector<std::string>& args);
+    void waitWhileIdle();
+
     SDL_Rect m_render_area;
     SDL_Window*   mp_window;
-    SDL_Renderer* mp_renderer;
+    RenderThread* mp_render_thread;
     TexturePool*  mp_texture_pool;
     AudioSystem*  mp_audio_system;
+    JobSystem*    mp_job_system;
 
     std::stack<Scene*> m_scene_stack;
     Scene* mp_next_scene;
     bool m_pop_scene;
+    unsigned int m_busy_frames; ///< Frames to draw before waitWhileIdle() may wait
+
+    bool m_headless;
+    std::string m_record_path;
+    std::string m_replay_path;
+    std::string m_trace_path;
+    unsigned int m_trace_frames;
+    unsigned int m_threads;
 };
 
 #endif /* ILMENDUR_ILMENDUR_HPP */
@@ -0,0 +1,470 @@
+#include "input.hpp"
+#include "clock.hpp"
+#include "ilmendur.hpp"
+#include "os.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+/* Recording file format. All multi-byte integers are LEB128 varints,
+ * signed ones zigzag-encoded first, so that the common small values
+ * take a single byte.
+ *
+ *   header:  "ILMINPUT" version:u8 framerate:u8
+ *   records: frame_delta:varint type:u8 payload
+ *
+ * frame_delta is the number of frames since the previous record (or
+ * since the start of the recording). The payload depends on the type:
+ *
+ *   key down/up:        scancode:varint keycode:varint mod:varint repeat:u8
+ *   text input:         length:u8 utf8_bytes
+ *   mouse motion:       state:varint x:svarint y:svarint xrel:svarint yrel:svarint
+ *   mouse button down/up: button:u8 clicks:u8 x:svarint y:svarint
+ *   mouse wheel:        x:svarint y:svarint direction:varint
+ *   quit:               (none)
+ *   end:                (none)
+ *
+ * The end record's frame delta leads to the last frame of the
+ * recording. Events the game does not care about (window events,
+ * text editing, controllers, ...) are not recorded. */
+
+static const char RECORDING_MAGIC[8] = {'I', 'L', 'M', 'I', 'N', 'P', 'U', 'T'};
+static const uint8_t RECORDING_VERSION = 1;
+
+enum class record_type: uint8_t { end = 0, key_down, key_up, text_input, mouse_motion, mouse_button_down, mouse_button_up, mouse_wheel, quit };
+enum class input_mode { live, record, replay };
+
+static input_mode s_mode = input_mode::live;
+static uint64_t s_frame = 0;
+static uint8_t s_keys[SDL_NUM_SCANCODES];
+static fs::path s_path;
+
+// Recording state
+static ofstream s_outfile;
+static uint64_t s_last_record_frame = 0;
+
+// Replay state
+static ifstream s_infile;
+static bool s_has_pending = false;
+static uint64_t s_pending_frame = 0;
+static SDL_Event s_pending;
+static bool s_end_reached = false;
+static uint64_t s_end_frame = 0;
+static uint64_t s_quit_frame = UINT64_MAX;
+
+static void writeByte(uint8_t byte)
+{
+    s_outfile.put(static_cast<char>(byte));
+}
+
+static void writeVarint(uint64_t val)
+{
+    while (val >= 0x80) {
+        writeByte(static_cast<uint8_t>(val) | 0x80);
+        val >>= 7;
+    }
+    writeByte(static_cast<uint8_t>(val));
+}
+
+static void writeSigned(int64_t val)
+{
+    writeVarint((static_cast<uint64_t>(val) << 1) ^ static_cast<uint64_t>(val >> 63));
+}
+
+static uint8_t readByte()
+{
+    int c = s_infile.get();
+    if (c == char_traits<char>::eof()) {
+        throw(runtime_error("Unexpected end of input recording '" + OS::utf8String(s_path) + "'"));
+    }
+    return static_cast<uint8_t>(c);
+}
+
+static uint64_t readVarint()
+{
+    uint64_t val = 0;
+    for(int shift=0; shift < 64; shift += 7) {
+        uint8_t byte = readByte();
+        val |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return val;
+        }
+    }
+    throw(runtime_error("Corrupt varint in input recording '" + OS::utf8String(s_path) + "'"));
+}
+
+static int64_t readSigned()
+{
+    uint64_t val = readVarint();
+    return static_cast<int64_t>(val >> 1) ^ -static_cast<int64_t>(val & 1);
+}
+
+/// Keeps the event-derived keyboard state in sync.
+static void trackKeys(const SDL_Event& event)
+{
+    if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && event.key.keysym.scancode < SDL_NUM_SCANCODES) {
+        s_keys[event.key.keysym.scancode] = event.type == SDL_KEYDOWN;
+    }
+}
+
+/// Writes `event` into the recording. Returns false if the event type is not recorded.
+static bool recordEvent(const SDL_Event& event)
+{
+    record_type type;
+    switch (event.type) {
+    case SDL_KEYDOWN:
+        type = record_type::key_down;
+        break;
+    case SDL_KEYUP:
+        type = record_type::key_up;
+        break;
+    case SDL_TEXTINPUT:
+        type = record_type::text_input;
+        break;
+    case SDL_MOUSEMOTION:
+        type = record_type::mouse_motion;
+        break;
+    case SDL_MOUSEBUTTONDOWN:
+        type = record_type::mouse_button_down;
+        break;
+    case SDL_MOUSEBUTTONUP:
+        type = record_type::mouse_button_up;
+        break;
+    case SDL_MOUSEWHEEL:
+        type = record_type::mouse_wheel;
+        break;
+    case SDL_QUIT:
+        type = record_type::quit;
+        break;
+    default:
+        return false;
+    }
+
+    writeVarint(s_frame - s_last_record_frame);
+    writeByte(static_cast<uint8_t>(type));
+    s_last_record_frame = s_frame;
+
+    switch (type) {
+    case record_type::key_down:
+    case record_type::key_up: // fall-through
+        writeVarint(event.key.keysym.scancode);
+        writeVarint(static_cast<uint32_t>(event.key.keysym.sym));
+        writeVarint(event.key.keysym.mod);
+        writeByte(event.key.repeat);
+        break;
+    case record_type::text_input: {
+        size_t len = strnlen(event.text.text, SDL_TEXTINPUTEVENT_TEXT_SIZE - 1);
+        writeByte(static_cast<uint8_t>(len));
+        s_outfile.write(event.text.text, len);
+        break;
+    }
+    case record_type::mouse_motion:
+        writeVarint(event.motion.state);
+        writeSigned(event.motion.x);
+        writeSigned(event.motion.y);
+        writeSigned(event.motion.xrel);
+        writeSigned(event.motion.yrel);
+        break;
+    case record_type::mouse_button_down:
+    case record_type::mouse_button_up: // fall-through
+        writeByte(event.button.button);
+        writeByte(event.button.clicks);
+        writeSigned(event.button.x);
+        writeSigned(event.button.y);
+        break;
+    case record_type::mouse_wheel:
+        writeSigned(event.wheel.x);
+        writeSigned(event.wheel.y);
+        writeVarint(event.wheel.direction);
+        break;
+    case record_type::quit:
+    case record_type::end: // fall-through
+        break;
+    } // No default to provoke compiler warnings on missing elements
+
+    if (!s_outfile) {
+        throw(runtime_error("Failed to write input recording '" + OS::utf8String(s_path) + "'"));
+    }
+
+    return true;
+}
+
+/// Reads the next record into s_pending, or sets s_end_reached.
+static void readNextEvent()
+{
+    s_has_pending = false;
+    uint64_t frame = s_pending_frame + readVarint();
+    record_type type = static_cast<record_type>(readByte());
+
+    SDL_Event& event = s_pending;
+    memset(&event, 0, sizeof(SDL_Event));
+    switch (type) {
+    case record_type::end:
+        s_end_reached = true;
+        s_end_frame = frame;
+        return;
+    case record_type::key_down:
+    case record_type::key_up: // fall-through
+        event.type = type == record_type::key_down ? SDL_KEYDOWN : SDL_KEYUP;
+        event.key.state = type == record_type::key_down ? SDL_PRESSED : SDL_RELEASED;
+        event.key.keysym.scancode = static_cast<SDL_Scancode>(readVarint());
+        event.key.keysym.sym = static_cast<SDL_Keycode>(readVarint());
+        event.key.keysym.mod = static_cast<Uint16>(readVarint());
+        event.key.repeat = readByte();
+        break;
+    case record_type::text_input: {
+        size_t len = readByte();
+        if (len >= SDL_TEXTINPUTEVENT_TEXT_SIZE) {
+            throw(runtime_error("Corrupt text input record in input recording '" + OS::utf8String(s_path) + "'"));
+        }
+        event.type = SDL_TEXTINPUT;
+        for(size_t i=0; i < len; i++) {
+            event.text.text[i] = static_cast<char>(readByte());
+        }
+        break;
+    }
+    case record_type::mouse_motion:
+        event.type = SDL_MOUSEMOTION;
+        event.motion.state = static_cast<Uint32>(readVarint());
+        event.motion.x = static_cast<Sint32>(readSigned());
+        event.motion.y = static_cast<Sint32>(readSigned());
+        event.motion.xrel = static_cast<Sint32>(readSigned());
+        event.motion.yrel = static_cast<Sint32>(readSigned());
+        break;
+    case record_type::mouse_button_down:
+    case record_type::mouse_button_up: // fall-through
+        event.type = type == record_type::mouse_button_down ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+        event.button.state = type == record_type::mouse_button_down ? SDL_PRESSED : SDL_RELEASED;
+        event.button.button = readByte();
+        event.button.clicks = readByte();
+        event.button.x = static_cast<Sint32>(readSigned());
+        event.button.y = static_cast<Sint32>(readSigned());
+        break;
+    case record_type::mouse_wheel:
+        event.type = SDL_MOUSEWHEEL;
+        event.wheel.x = static_cast<Sint32>(readSigned());
+        event.wheel.y = static_cast<Sint32>(readSigned());
+        event.wheel.direction = static_cast<Uint32>(readVarint());
+        event.wheel.preciseX = static_cast<float>(event.wheel.x);
+        event.wheel.preciseY = static_cast<float>(event.wheel.y);
+        break;
+    case record_type::quit:
+        event.type = SDL_QUIT;
+        break;
+    default:
+        throw(runtime_error("Unknown record type " + to_string(static_cast<int>(type)) + " in input recording '" + OS::utf8String(s_path) + "'"));
+    }
+
+    s_pending_frame = frame;
+    s_has_pending = true;
+}
+
+/**
+ * Starts recording all input into the file at `path`, which is
+ * overwritten. Call this before the first frame.
+ */
+void Input::startRecording(const fs::path& path)
+{
+    if (s_mode != input_mode::live) {
+        throw(runtime_error("Input recording or replay already active"));
+    }
+
+    s_outfile.open(path, ios::out | ios::binary | ios::trunc);
+    if (!s_outfile) {
+        throw(runtime_error("Failed to open '" + OS::utf8String(path) + "' for writing"));
+    }
+
+    s_path = path;
+    s_outfile.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    writeByte(RECORDING_VERSION);
+    writeByte(ILMENDUR_TARGET_FRAMERATE);
+
+    s_mode = input_mode::record;
+    s_frame = 0;
+    s_last_record_frame = 0;
+    memset(s_keys, 0, sizeof(s_keys));
+    Clock::setVirtual(true);
+}
+
+/**
+ * Starts replaying the input recording at `path`. From now on,
+ * pollEvent() returns the recorded events only. Call this before
+ * the first frame.
+ */
+void Input::startReplay(const fs::path& path)
+{
+    if (s_mode != input_mode::live) {
+        throw(runtime_error("Input recording or replay already active"));
+    }
+
+    s_infile.open(path, ios::in | ios::binary);
+    if (!s_infile) {
+        throw(runtime_error("Failed to open input recording '" + OS::utf8String(path) + "'"));
+    }
+    s_path = path;
+
+    char magic[sizeof(RECORDING_MAGIC)];
+    s_infile.read(magic, sizeof(magic));
+    if (!s_infile || memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0) {
+        throw(runtime_error("'" + OS::utf8String(path) + "' is not an input recording"));
+    }
+    if (readByte() != RECORDING_VERSION) {
+        throw(runtime_error("Unsupported version of input recording '" + OS::utf8String(path) + "'"));
+    }
+    if (readByte() != ILMENDUR_TARGET_FRAMERATE) {
+        throw(runtime_error("Input recording '" + OS::utf8String(path) + "' was made with a different frame rate"));
+    }
+
+    s_mode = input_mode::replay;
+    s_frame = 0;
+    s_pending_frame = 0;
+    s_end_reached = false;
+    s_quit_frame = UINT64_MAX;
+    memset(s_keys, 0, sizeof(s_keys));
+    Clock::setVirtual(true);
+
+    readNextEvent();
+}
+
+/**
+ * Finishes the current recording or replay, if any.
+ */
+void Input::stop()
+{
+    switch (s_mode) {
+    case input_mode::record:
+        writeVarint(s_frame - s_last_record_frame);
+        writeByte(static_cast<uint8_t>(record_type::end));
+        s_outfile.close();
+        cout << "Recorded " << s_frame << " frames of input to " << OS::utf8String(s_path) << endl;
+        break;
+    case input_mode::replay:
+        s_infile.close();
+        break;
+    case input_mode::live:
+        break;
+    }
+
+    s_mode = input_mode::live;
+    s_has_pending = false;
+    Clock::setVirtual(false);
+}
+
+bool Input::isRecording()
+{
+    return s_mode == input_mode::record;
+}
+
+bool Input::isReplaying()
+{
+    return s_mode == input_mode::replay;
+}
+
+/// True if the replay has gone past the last frame of the recording.
+bool Input::replayFinished()
+{
+    return s_mode == input_mode::replay && s_end_reached && s_frame > s_end_frame;
+}
+
+/// Number of frames since recording or replay started.
+uint64_t Input::frame()
+{
+    return s_frame;
+}
+
+/**
+ * Replacement for SDL_PollEvent() to be used by the main loop.
+ * Fetches the next event of the current frame into `p_event` and
+ * returns true, or returns false if there are no more events in
+ * this frame.
+ *
+ * During a replay, live events are discarded except for SDL_QUIT,
+ * so that a visible replay can be aborted by closing the window.
+ * Once the recording is exhausted, SDL_QUIT is returned once
+ * per frame.
+ */
+bool Input::pollEvent(SDL_Event* p_event)
+{
+    switch (s_mode) {
+    case input_mode::live:
+        return SDL_PollEvent(p_event);
+    case input_mode::record:
+        if (SDL_PollEvent(p_event)) {
+            if (recordEvent(*p_event)) {
+                trackKeys(*p_event);
+            }
+            return true;
+        }
+        return false;
+    case input_mode::replay:
+        while (SDL_PollEvent(p_event)) {
+            if (p_event->type == SDL_QUIT) {
+                return true;
+            }
+        }
+
+        if (s_has_pending && s_pending_frame == s_frame) {
+            *p_event = s_pending;
+            p_event->common.timestamp = static_cast<Uint32>(Clock::ticks());
+            switch (p_event->type) {
+            case SDL_KEYDOWN:
+            case SDL_KEYUP: // fall-through
+                p_event->key.windowID = SDL_GetWindowID(Ilmendur::instance().sdlWindow());
+                break;
+            case SDL_TEXTINPUT:
+                p_event->text.windowID = SDL_GetWindowID(Ilmendur::instance().sdlWindow());
+                break;
+            case SDL_MOUSEMOTION:
+                p_event->motion.windowID = SDL_GetWindowID(Ilmendur::instance().sdlWindow());
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP: // fall-through
+                p_event->button.windowID = SDL_GetWindowID(Ilmendur::instance().sdlWindow());
+                break;
+            case SDL_MOUSEWHEEL:
+                p_event->wheel.windowID = SDL_GetWindowID(Ilmendur::instance().sdlWindow());
+                break;
+            default:
+                break;
+            }
+
+            trackKeys(*p_event);
+            readNextEvent();
+            return true;
+        }
+
+        if (replayFinished() && s_quit_frame != s_frame) {
+            s_quit_frame = s_frame;
+            memset(p_event, 0, sizeof(SDL_Event));
+            p_event->type = SDL_QUIT;
+            return true;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+/// Call once at the end of each frame from the main loop.
+void Input::endFrame()
+{
+    s_frame++;
+}
+
+/**
+ * Replacement for SDL_GetKeyboardState(). While recording or
+ * replaying, the state is derived from the key events returned
+ * by pollEvent() so far, which makes it reproducible.
+ */
+const uint8_t* Input::keyboardState()
+{
+    if (s_mode == input_mode::live) {
+        return SDL_GetKeyboardState(nullptr);
+    } else {
+        return s_keys;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef ILMENDUR_INPUT_HPP
+#define ILMENDUR_INPUT_HPP
+#include <cstdint>
+#include <filesystem>
+#include <SDL2/SDL.h>
+
+/**
+ * Input event source of the main loop, with the ability to record
+ * all input into a file and to replay such a recording later.
+ *
+ * The main loop fetches events with pollEvent() instead of
+ * SDL_PollEvent() and calls endFrame() once per frame. Code that
+ * needs the keyboard state asks keyboardState() rather than
+ * SDL_GetKeyboardState(). In recording mode, events are taken from
+ * SDL and written to the recording file together with the number of
+ * the frame they occured in. In replay mode, SDL's events are
+ * discarded and the recorded ones are returned in the very same
+ * frames instead. In both modes, the keyboard state is derived from
+ * the key events alone, and the Clock is switched to virtual time,
+ * so that a replay re-executes the recorded session identically.
+ */
+namespace Input {
+    void startRecording(const std::filesystem::path& path);
+    void startReplay(const std::filesystem::path& path);
+    void stop();
+
+    bool isRecording();
+    bool isReplaying();
+    bool replayFinished();
+    uint64_t frame();
+
+    bool pollEvent(SDL_Event* p_event);
+    void endFrame();
+
+    const uint8_t* keyboardState();
+}
+
+#endif /* ILMENDUR_INPUT_HPP */
@@ -0,0 +1,155 @@
+#include "jobs.hpp"
+#include <cassert>
+
+using namespace std;
+
+// Index of the calling thread's queue. Zero for all threads that are
+// not workers of the job system, most notably the main thread.
+static thread_local size_t s_queue_index = 0;
+
+/**
+ * Creates the job system with `threads` threads in total, counting
+ * the thread(s) that submit jobs. 0 means one thread per CPU core.
+ */
+JobSystem::JobSystem(unsigned int threads)
+    : m_queued(0),
+      m_stop(false)
+{
+    startWorkers(threads);
+}
+
+JobSystem::~JobSystem()
+{
+    stopWorkers();
+}
+
+/**
+ * Changes the number of threads; see the constructor. Must not be
+ * called while jobs are running.
+ */
+void JobSystem::setThreadCount(unsigned int threads)
+{
+    stopWorkers();
+    startWorkers(threads);
+}
+
+void JobSystem::startWorkers(unsigned int threads)
+{
+    if (threads == 0) {
+        threads = max(thread::hardware_concurrency(), 1u);
+    }
+
+    m_stop = false;
+    for(unsigned int i=0; i < threads; i++) {
+        m_queues.emplace_back(new Queue);
+    }
+    for(unsigned int i=1; i < threads; i++) {
+        m_workers.emplace_back(&JobSystem::workerMain, this, i);
+    }
+}
+
+void JobSystem::stopWorkers()
+{
+    assert(m_queued == 0);
+
+    {
+        lock_guard<mutex> lock(m_sleep_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_all();
+
+    for(thread& worker: m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    m_queues.clear();
+}
+
+/**
+ * Queues the job `func(p_data, begin, end)` and increments `counter`,
+ * which must stay alive until wait() has returned for it.
+ */
+void JobSystem::submit(job_function func, void* p_data, size_t begin, size_t end, Counter& counter)
+{
+    counter.pending.fetch_add(1, memory_order_relaxed);
+
+    Queue& queue = *m_queues[s_queue_index];
+    {
+        lock_guard<mutex> lock(queue.mutex);
+        queue.jobs.push_back(Job{func, p_data, begin, end, &counter});
+    }
+    m_queued.fetch_add(1);
+
+    // Taking the lock ensures no worker is between checking m_queued
+    // and going to sleep, which would lose the wakeup.
+    {
+        lock_guard<mutex> lock(m_sleep_mutex);
+    }
+    m_wakeup.notify_one();
+}
+
+/**
+ * Runs jobs until all jobs counted on `counter` have finished.
+ */
+void JobSystem::wait(Counter& counter)
+{
+    while (counter.pending.load(memory_order_acquire) > 0) {
+        if (!runOne(s_queue_index)) {
+            this_thread::yield();
+        }
+    }
+}
+
+/**
+ * Runs one job: the newest one of the queue `index` if there is one,
+ * otherwise the oldest one of another queue. Returns false if there
+ * was no job to run.
+ */
+bool JobSystem::runOne(size_t index)
+{
+    Job job;
+    bool found = false;
+    const size_t count = m_queues.size();
+    for(size_t i=0; i < count && !found; i++) {
+        Queue& queue = *m_queues[(index + i) % count];
+        lock_guard<mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            continue;
+        }
+
+        if (i == 0) {
+            job = queue.jobs.back();
+            queue.jobs.pop_back();
+        } else {
+            job = queue.jobs.front();
+            queue.jobs.pop_front();
+        }
+        found = true;
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    m_queued.fetch_sub(1);
+    job.func(job.p_data, job.begin, job.end);
+    job.p_counter->pending.fetch_sub(1, memory_order_release);
+    return true;
+}
+
+void JobSystem::workerMain(size_t index)
+{
+    s_queue_index = index;
+
+    while (true) {
+        if (runOne(index)) {
+            continue;
+        }
+
+        unique_lock<mutex> lock(m_sleep_mutex);
+        m_wakeup.wait(lock, [this]{ return m_stop || m_queued.load() > 0; });
+        if (m_stop) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef ILMENDUR_JOBS_HPP
+#define ILMENDUR_JOBS_HPP
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing job system. There is one instance of it, owned by
+ * the Ilmendur singleton; see Ilmendur::jobSystem().
+ *
+ * A job is a plain function pointer with a data pointer and a range
+ * of indices to work on; it must only touch data no other job of the
+ * same batch touches. Jobs are submitted into the queue of the
+ * submitting thread and counted on a Counter; wait() then works on
+ * jobs itself until the counter drops to zero, so that the thread
+ * count includes the waiting thread, and waiting from within a job
+ * (nested parallelism) does not deadlock. Idle worker threads steal
+ * jobs from the front of the other threads' queues.
+ *
+ * Usually, parallelFor() is all you need.
+ *
+ * Nothing in here makes the game code thread-safe. Only hand work to
+ * the job system that is known to be independent, like the per-row
+ * passes over an ActorStore; see Map::advanceActors().
+ */
+class JobSystem
+{
+public:
+    typedef void (*job_function)(void* p_data, size_t begin, size_t end);
+
+    /// Number of submitted, but not yet finished jobs.
+    struct Counter
+    {
+        std::atomic<size_t> pending{0};
+    };
+
+    JobSystem(unsigned int threads = 0);
+    ~JobSystem();
+
+    void setThreadCount(unsigned int threads);
+    inline unsigned int threadCount() const { return m_queues.size(); }
+
+    void submit(job_function func, void* p_data, size_t begin, size_t end, Counter& counter);
+    void wait(Counter& counter);
+
+    template<typename F>
+    void parallelFor(size_t count, size_t chunk, const F& func);
+
+private:
+    struct Job
+    {
+        job_function func;
+        void* p_data;
+        size_t begin;
+        size_t end;
+        Counter* p_counter;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void startWorkers(unsigned int threads);
+    void stopWorkers();
+    void workerMain(size_t index);
+    bool runOne(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues; ///< One per thread; 0 is for all non-worker threads
+    std::vector<std::thread> m_workers;
+    std::atomic<size_t> m_queued;
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_wakeup;
+    bool m_stop;
+};
+
+/**
+ * Calls `func(begin, end)` for consecutive ranges of at most `chunk`
+ * indices covering [0; `count`), in parallel, and returns when all
+ * calls have finished. `func` is called directly if there is only
+ * one chunk.
+ */
+template<typename F>
+void JobSystem::parallelFor(size_t count, size_t chunk, const F& func)
+{
+    if (count <= chunk || m_queues.size() == 1) {
+        if (count > 0) {
+            func(0, count);
+        }
+        return;
+    }
+
+    Counter counter;
+    for(size_t begin=0; begin < count; begin += chunk) {
+        submit([](void* p_data, size_t begin, size_t end) { (*static_cast<const F*>(p_data))(begin, end); },
+               const_cast<F*>(&func), begin, std::min(begin + chunk, count), counter);
+    }
+    wait(counter);
+}
+
+#endif /* ILMENDUR_JOBS_HPP */
@@ -1,7 +1,9 @@
 #include "ilmendur.hpp"
+#include <vector>
+#include <string>
 
-int main()
+int main(int argc, char* argv[])
 {
-    Ilmendur app;
+    Ilmendur app(std::vector<std::string>(argv + 1, argv + argc));
     return app.run();
 }
@@ -9,6 +9,15 @@
 #include "actors/hero.hpp"
 #include "actors/teleport.hpp"
 #include "map_controllers/map_controller.hpp"
+#include "profiler.hpp"
+#include "clock.hpp"
+#include "aabb.hpp"
+#include "jobs.hpp"
+#include "actors/draw_order.hpp"
+#include "render_list.hpp"
+#include "camera.hpp"
+#include "render_thread.hpp"
+#include "script.hpp"
 #include <fstream>
 #include <algorithm>
 #include <cstdlib>
@@ -23,7 +32,8 @@ namespace fs = std::filesystem;
 MapLayer::MapLayer(Map& map, std::string name, Properties props)
     : mr_map(map),
       m_name(name),
-      m_props(props)
+      m_name_id(m_name),
+      m_props(move(props))
 {
 }
 
@@ -32,47 +42,169 @@ MapLayer::~MapLayer()
 }
 
 ObjectLayer::ObjectLayer(Map& map, std::string name, Properties props)
-    : MapLayer(map, name, props)
+    : MapLayer(map, name, move(props)),
+      m_store(map.arena().resource()),
+      m_depth_sorted(false),
+      m_rows_changed(true)
 {
 }
 
+/**
+ * The actors on this layer live in the map's arena and are
+ * destroyed together with it, not here.
+ */
 ObjectLayer::~ObjectLayer()
 {
-    for(Actor* p_actor: m_actors) {
-        delete p_actor;
-    }
-
-    m_actors.clear();
 }
 
+/**
+ * Runs the update() hooks of all actors and checks collisions. The
+ * actors' movement and animation has already been advanced by
+ * Map::advanceActors() at this point.
+ */
 void ObjectLayer::update()
 {
-    for(Actor* p_actor: m_actors) {
-        p_actor->update();
-    }
+    updateActors();
 
     // After everyone has moved, check collisions and reset positions
     // appropriately.
+    PROFILE_SCOPE("Collision checks");
     checkCollisions();
 }
 
-void ObjectLayer::draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview)
+/**
+ * Advances movement and animation of all actors on this layer. The
+ * per-row passes are split into chunks of ROW_CHUNK rows that are
+ * worked on in parallel by `jobs`; the passes in between, including
+ * the custom velocity functions of evaluateCurves(), run on the
+ * calling thread.
+ *
+ * Do not call this for several layers at once: the ActorStores of
+ * all layers allocate from the map's arena, which is not
+ * synchronised.
+ */
+void ObjectLayer::advanceActors(JobSystem& jobs)
+{
+    static const size_t ROW_CHUNK = 2048;
+
+    m_depth_sorted = false;
+    m_store.evaluateCurves(Clock::ticks());
+    jobs.parallelFor(m_store.size(), ROW_CHUNK, [this](size_t begin, size_t end) {
+        m_store.integrate(begin, end);
+    });
+    m_store.finishMovement();
+    jobs.parallelFor(m_store.size(), ROW_CHUNK, [this](size_t begin, size_t end) {
+        m_store.advanceAnimation(begin, end);
+    });
+}
+
+/**
+ * Runs the update() hooks of all actors on this layer, but does not
+ * check collisions.
+ */
+void ObjectLayer::updateActors()
+{
+    m_depth_sorted = false;
+    for(size_t i=0; i < m_store.size(); i++) {
+        m_store.actors[i]->update();
+    }
+}
+
+/**
+ * Draws the actors within `p_camview` in depth order; see DrawOrder.
+ * All calls in a frame share the order of sortDepth(), so that drawing
+ * several views and patches only filters it.
+ */
+void ObjectLayer::draw(RenderList* p_stage, const SDL_Rect* p_camview, float)
 {
-    for(Actor* p_actor: m_actors) {
-        p_actor->draw(p_stage, p_camview);
+    sortDepth();
+
+    for(uint32_t row: m_depth_order) {
+        SDL_Rect rect = m_store.actors[row]->drawRect();
+        if (SDL_HasIntersection(&rect, p_camview)) {
+            m_store.actors[row]->draw(p_stage, p_camview);
+        }
     }
 }
 
-TileLayer::TileLayer(Map& map, std::string name, Properties props, int width, int height, vector<int> gids)
-    : MapLayer(map, name, props),
+/**
+ * Brings all rows of the layer into depth order, unless they have not
+ * moved since the last call. Last call's order is kept in
+ * `m_depth_order`, so this is mostly an insertion sort once per frame.
+ */
+void ObjectLayer::sortDepth()
+{
+    if (m_depth_sorted) {
+        return;
+    }
+
+    // Drop the rows that no longer exist and add the new ones
+    const size_t count = m_store.size();
+    m_depth_present.assign(count, false);
+    size_t kept = 0;
+    for(uint32_t row: m_depth_order) {
+        if (row < count) {
+            m_depth_order[kept++] = row;
+            m_depth_present[row] = true;
+        }
+    }
+    m_depth_order.resize(kept);
+    for(size_t i=0; i < count; i++) {
+        if (!m_depth_present[i]) {
+            m_depth_order.push_back(i);
+        }
+    }
+
+    DrawOrder::sort(m_depth_order.data(), count, kept, m_store.pos.data());
+    m_depth_sorted = true;
+}
+
+/**
+ * Appends the old and the new draw rectangle of every actor that
+ * moved or changed its sprite since the last call. If actors were
+ * added or removed meanwhile, the rectangles of all actors are
+ * appended.
+ */
+void ObjectLayer::changedRects(vector<SDL_Rect>& rects)
+{
+    const size_t count = m_store.size();
+    assert(m_rows_changed || m_drawn.size() == count);
+    if (m_rows_changed) {
+        for(const DrawState& state: m_drawn) {
+            rects.push_back(state.rect);
+        }
+        m_drawn.resize(count);
+    }
+
+    for(size_t i=0; i < count; i++) {
+        DrawState state;
+        state.rect      = m_store.actors[i]->drawRect();
+        state.p_texinfo = m_store.texinfo[i];
+        state.frame     = m_store.frame[i];
+        state.lookdir   = m_store.lookdir[i];
+
+        DrawState& drawn = m_drawn[i];
+        if (m_rows_changed) {
+            rects.push_back(state.rect);
+        } else if (!SDL_RectEquals(&state.rect, &drawn.rect) || state.p_texinfo != drawn.p_texinfo || state.frame != drawn.frame || state.lookdir != drawn.lookdir) {
+            rects.push_back(drawn.rect);
+            rects.push_back(state.rect);
+        }
+        drawn = state;
+    }
+    m_rows_changed = false;
+}
+
+TileLayer::TileLayer(Map& map, std::string name, Properties props, int width, int height, pmr::vector<int> gids)
+    : MapLayer(map, name, move(props)),
       m_width(width),
       m_height(height),
-      m_gids(gids)
+      m_gids(move(gids))
 {
-    string facedir = m_props.get("facedir");
-    if (facedir == string("down")) {
+    string_view facedir = m_props.get("facedir");
+    if (facedir == "down") {
         m_dir = TileLayer::layer_direction::down;
-    } else if (facedir == string("both")) {
+    } else if (facedir == "both") {
         m_dir = TileLayer::layer_direction::both;
     } else {
         m_dir = TileLayer::layer_direction::up;
@@ -84,44 +216,82 @@ void TileLayer::update()
     // Nothing
 }
 
-void TileLayer::draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview)
+/**
+ * Draws the tiles within `p_camview`. The destination rectangles are
+ * in view coordinates whatever the zoom, as the renderer scales them
+ * (see Camera::draw()); the zoom only selects the tileset texture
+ * level to take them from.
+ */
+void TileLayer::draw(RenderList* p_stage, const SDL_Rect* p_camview, float zoom)
 {
     SDL_Rect srcrect;
     SDL_Rect destrect;
     SDL_Texture* p_tilesettexture = nullptr;
+    const int level = Tileset::atlasLevel(zoom);
 
-    // TODO: Honor p_camview width and height for scaling purposes.
     destrect.w = TILEWIDTH;
     destrect.h = TILEWIDTH;
 
-    if (m_dir == TileLayer::layer_direction::up) {
-        for(size_t i=0; i < m_gids.size(); i++) {
-            int gid = m_gids[i];
-            if (readTile(p_tilesettexture, srcrect, gid)) {
-                destrect.x = (i % m_width * TILEWIDTH) - p_camview->x;
-                destrect.y = (i / m_width * TILEWIDTH) - p_camview->y;
-                SDL_RenderCopy(p_stage, p_tilesettexture, &srcrect, &destrect);
+    // Only the tiles intersecting the camera view
+    int col0 = max(p_camview->x / TILEWIDTH, 0);
+    int row0 = max(p_camview->y / TILEWIDTH, 0);
+    int col1 = min((p_camview->x + p_camview->w - 1) / TILEWIDTH, m_width - 1);
+    int row1 = min((p_camview->y + p_camview->h - 1) / TILEWIDTH, m_height - 1);
+
+    // Whether to draw this layer at all for the hero's look direction
+    // was decided by Map::drawLayers().
+    for(int row=row0; row <= row1; row++) {
+        for(int col=col0; col <= col1; col++) {
+            int gid = mr_map.drawnGid(m_gids[row * m_width + col]);
+            if (readTile(p_tilesettexture, srcrect, gid, level)) {
+                destrect.x = col * TILEWIDTH - p_camview->x;
+                destrect.y = row * TILEWIDTH - p_camview->y;
+                p_stage->copy(p_tilesettexture, &srcrect, &destrect);
             }
         }
     }
-    // TODO: Handle "down" and "both" direction depending on the hero view direction.
+}
 
+/**
+ * Appends the cells of the animated tiles that switched to another
+ * frame since the last call; see Map::gidChanged().
+ */
+void TileLayer::changedRects(vector<SDL_Rect>& rects)
+{
+    for(int cell: m_animated_cells) {
+        if (mr_map.gidChanged(m_gids[cell])) {
+            rects.push_back(SDL_Rect{cell % m_width * TILEWIDTH, cell / m_width * TILEWIDTH, TILEWIDTH, TILEWIDTH});
+        }
+    }
+}
+
+/// Collects the cells of the animated tiles for changedRects().
+void TileLayer::findAnimatedCells()
+{
+    m_animated_cells.clear();
+    for(size_t cell=0; cell < m_gids.size(); cell++) {
+        if (mr_map.gidAnimated(m_gids[cell])) {
+            m_animated_cells.push_back(cell);
+        }
+    }
 }
 
 static MapLayer* readLayer(const pugi::xml_node& node, Map& map)
 {
     if (node.name() == string("layer")) {
-        TileLayer* p_layer = new TileLayer(map,
-                                           node.attribute("name").value(),
-                                           TMX::readProperties(node),
-                                           node.attribute("width").as_int(),
-                                           node.attribute("height").as_int(),
-                                           TMX::parseGidCsv(node.child("data").text().get()));
+        Arena& arena = map.arena();
+        TileLayer* p_layer = arena.create<TileLayer>(map,
+                                                     node.attribute("name").value(),
+                                                     TMX::readProperties(node, arena.resource()),
+                                                     node.attribute("width").as_int(),
+                                                     node.attribute("height").as_int(),
+                                                     TMX::parseGidCsv(node.child("data").text().get(), arena.resource()));
         return p_layer;
     } else if (node.name() == string("objectgroup")) {
-        ObjectLayer* p_layer = new ObjectLayer(map,
-                                               node.attribute("name").value(),
-                                               TMX::readProperties(node));
+        Arena& arena = map.arena();
+        ObjectLayer* p_layer = arena.create<ObjectLayer>(map,
+                                                         node.attribute("name").value(),
+                                                         TMX::readProperties(node, arena.resource()));
         TMX::readTmxObjects(node, p_layer); // Modifies `p_layer`!
         return p_layer;
     // TODO: Remaining TMX layer types
@@ -130,20 +300,55 @@ static MapLayer* readLayer(const pugi::xml_node& node, Map& map)
     }
 }
 
+/**
+ * Locates the map file for the map called `name`, without directory
+ * and without the trailing ".tmx".
+ */
+fs::path Map::findMapFile(const std::string& name)
+{
+    // DEBUG: Try user-provided map of the name first, and only if it
+    // does not exist try shipped map. This is only for debugging!
+    fs::path abs_path(OS::userDataDir() / OS::utf8Path("maps") / OS::utf8Path(name + ".tmx"));
+    if (!fs::exists(abs_path)) {
+        abs_path = OS::gameDataDir() / OS::utf8Path("maps") / OS::utf8Path(name + ".tmx");
+    }
+    return abs_path;
+}
+
+/**
+ * Loads the map called `name` from the user data directory or,
+ * if it is not there, from the game data directory.
+ */
 Map::Map(const std::string& name)
+    : Map(name, findMapFile(name))
+{
+}
+
+/**
+ * Loads the map called `name` from the TMX file at `abs_path`.
+ * Tilesets referenced by the map are always read from the game
+ * data directory.
+ */
+Map::Map(const std::string& name, const fs::path& abs_path)
     : m_name(name),
       m_width(0),
       m_height(0),
       mp_freya(nullptr),
       mp_benjamin(nullptr),
-      mp_controller(nullptr)
+      mp_controller(nullptr),
+      m_merge_views(false),
+      m_merged_group(0),
+      mp_merge_target(nullptr),
+      m_merge_ticket(0),
+      m_merge_w(0),
+      m_merge_h(0),
+      m_merge_supported(true),
+      m_cache_views(false),
+      m_cache_supported(true),
+      m_cached_views(0)
 {
-    // DEBUG: Try user-provided map of the name first, and only if it
-    // does not exist try shipped map. This is only for debugging!
-    fs::path abs_path(OS::userDataDir() / fs::u8path("maps") / fs::u8path(m_name + ".tmx"));
-    if (!fs::exists(abs_path)) {
-        abs_path = OS::gameDataDir() / fs::u8path("maps") / fs::u8path(m_name + ".tmx");
-    }
+    PROFILE_SCOPE_DYNAMIC("Map::Map " + m_name);
+
     ifstream file(abs_path);
     assert(fs::exists(abs_path));
 
@@ -174,15 +379,21 @@ Map::Map(const std::string& name)
             m_bg_music = props.get("background_music");
         } else if (node.name() == string("tileset")) {
             int firstgid    = node.attribute("firstgid").as_int();
-            fs::path source = fs::u8path(node.attribute("source").value()).filename(); // Discard directory information as it's irrelevant
+            fs::path source = OS::utf8Path(node.attribute("source").value()).filename(); // Discard directory information as it's irrelevant
             assert(firstgid > 0);
 
-            m_tilesets[firstgid] = new Tileset(source);
+            m_tilesets[firstgid] = m_arena.create<Tileset>(source);
         } else {
             m_layers.push_back(readLayer(node, *this));
+            if (ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(m_layers.back())) {
+                m_object_layers.push_back(p_obj_layer);
+            }
         }
     }
 
+    setupDrawLayers();
+    setupAnimations();
+
     MapControllers::MapController* p_ctrl = nullptr;
     if (MapControllers::MapController::findMapController(m_name, &p_ctrl)) {
         mp_controller = p_ctrl;
@@ -191,18 +402,134 @@ Map::Map(const std::string& name)
 
 Map::~Map()
 {
+    Scripts::stop(this);
     mp_controller = nullptr; // Now owned by Map
 
-    for (MapLayer* p_layer: m_layers) {
-        delete p_layer;
+    // invoke() runs after the posted texture creations, if any
+    if (mp_merge_target || m_merge_ticket) {
+        Ilmendur::instance().renderThread().invoke([this](SDL_Renderer*){
+            if (mp_merge_target) {
+                SDL_DestroyTexture(mp_merge_target);
+            }
+        });
     }
+    if (!m_view_caches.empty()) {
+        Ilmendur::instance().renderThread().invoke([this](SDL_Renderer*){
+            for(const ViewCache& cache: m_view_caches) {
+                if (cache.p_texture) {
+                    SDL_DestroyTexture(cache.p_texture);
+                }
+            }
+        });
+    }
+
+    // Destroys all layers, actors, and tilesets in one go.
+    m_draw_layers.clear();
+    m_draw_layers_down.clear();
     m_layers.clear();
+    m_object_layers.clear();
+    m_tilesets.clear();
+    m_arena.release();
+}
 
-    for(auto iter = m_tilesets.begin(); iter != m_tilesets.end(); iter++) {
-        delete iter->second;
+/**
+ * Builds the gid remap table from the tile animations of all tilesets
+ * and sets it up for the current time.
+ */
+void Map::setupAnimations()
+{
+    int gid_count = 1; // gid 0 is no tile
+    for(const auto& [firstgid, p_tileset]: m_tilesets) {
+        gid_count = max(gid_count, firstgid + p_tileset->tileCount());
     }
 
-    m_tilesets.clear();
+    m_gid_remap.resize(gid_count);
+    for(int gid=0; gid < gid_count; gid++) {
+        m_gid_remap[gid] = gid;
+    }
+    m_gid_animated.assign(gid_count, false);
+    m_gid_changed.assign(gid_count, false);
+
+    for(const auto& [firstgid, p_tileset]: m_tilesets) {
+        for(const TileAnimation& anim: p_tileset->animations()) {
+            AnimatedGid animated;
+            animated.gid            = firstgid + anim.lid;
+            animated.first_frame    = m_animation_frames.size();
+            animated.frame_count    = anim.frames.size();
+            animated.total_duration = anim.total_duration;
+
+            int end_time = 0;
+            for(const TileAnimation::Frame& frame: anim.frames) {
+                end_time += frame.duration;
+                m_animation_frames.push_back(AnimationFrame{firstgid + frame.lid, end_time});
+            }
+            m_animated_gids.push_back(animated);
+            m_gid_animated[animated.gid] = true;
+        }
+    }
+
+    for(MapLayer* p_layer: m_layers) {
+        if (TileLayer* p_tile_layer = dynamic_cast<TileLayer*>(p_layer)) {
+            p_tile_layer->findAnimatedCells();
+        }
+    }
+
+    updateAnimations();
+}
+
+/**
+ * Points the animated gids in the remap table to the frames to show
+ * now. All animations run on the game clock, so all instances of an
+ * animated tile show the same frame, and cost nothing extra to draw.
+ * Called once per frame from update().
+ */
+void Map::updateAnimations()
+{
+    uint64_t now = Clock::ticks();
+    for(const AnimatedGid& animated: m_animated_gids) {
+        int time = now % animated.total_duration;
+        const AnimationFrame* p_frame = &m_animation_frames[animated.first_frame];
+        while (p_frame->end_time <= time) {
+            p_frame++;
+        }
+        if (m_gid_remap[animated.gid] != p_frame->gid) {
+            m_gid_remap[animated.gid]   = p_frame->gid;
+            m_gid_changed[animated.gid] = true;
+        }
+    }
+}
+
+/**
+ * Checks whether update() changes nothing until Clock::ticks() reaches
+ * `*p_wakeup`, provided there is no input: no actor moves or plays an
+ * animation, which count frames rather than time; see
+ * ActorStore::advanceAnimation(). Lowers `*p_wakeup` to the time the
+ * next animated tile switches frames.
+ */
+bool Map::isIdle(uint64_t* p_wakeup) const
+{
+    for(const ObjectLayer* p_layer: m_object_layers) {
+        const ActorStore& store = p_layer->actorStore();
+        for(size_t i=0; i < store.size(); i++) {
+            if (store.isMoving(i)) {
+                return false;
+            }
+            if (store.ani_mode[i] == animation_mode::always && store.texinfo[i] && store.texinfo[i]->frames > 1) {
+                return false;
+            }
+        }
+    }
+
+    uint64_t now = Clock::ticks();
+    for(const AnimatedGid& animated: m_animated_gids) {
+        int time = now % animated.total_duration;
+        const AnimationFrame* p_frame = &m_animation_frames[animated.first_frame];
+        while (p_frame->end_time <= time) {
+            p_frame++;
+        }
+        *p_wakeup = min(*p_wakeup, now + (p_frame->end_time - time));
+    }
+    return true;
 }
 
 /**
@@ -217,11 +544,392 @@ void Map::setup()
     }
 }
 
-void Map::draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview)
+/**
+ * Sorts the layers into the lists returned by drawLayers(). The
+ * `facedir` property of a tile layer (TileLayer::layer_direction)
+ * says for which look direction of the hero it is drawn: `down`
+ * layers only while the hero looks down, `up` layers (the default)
+ * and `both` layers always. Object layers are always drawn.
+ */
+void Map::setupDrawLayers()
 {
-    for (MapLayer* p_layer: m_layers) {
-        p_layer->draw(p_stage, p_camview);
+    for(MapLayer* p_layer: m_layers) {
+        TileLayer::layer_direction dir = TileLayer::layer_direction::both;
+        if (TileLayer* p_tile_layer = dynamic_cast<TileLayer*>(p_layer)) {
+            dir = p_tile_layer->layerDirection();
+        }
+
+        switch (dir) {
+        case TileLayer::layer_direction::up:
+        case TileLayer::layer_direction::both: // fall-through
+            m_draw_layers.push_back(p_layer);
+            m_draw_layers_down.push_back(p_layer);
+            break;
+        case TileLayer::layer_direction::down:
+            m_draw_layers_down.push_back(p_layer);
+            break;
+        } // No default to provoke compiler warnings on missing elements
+    }
+}
+
+/**
+ * The layers to draw for `p_camera`, depending on the look direction
+ * of the hero it follows, if any; see setupDrawLayers(). Both lists
+ * are built when the map is loaded, so switching between them when
+ * the hero turns costs nothing, and the layers themselves do not need
+ * to check the direction while drawing.
+ */
+const std::vector<MapLayer*>& Map::drawLayers(Camera* p_camera) const
+{
+    Hero* p_hero = p_camera->hero();
+    if (p_hero && p_hero->lookDirection() == direction::down) {
+        return m_draw_layers_down;
+    } else {
+        return m_draw_layers;
+    }
+}
+
+/**
+ * Draws the layers within `p_camview`, as seen by an unzoomed camera
+ * not following a hero.
+ */
+void Map::draw(RenderList* p_stage, const SDL_Rect* p_camview)
+{
+    drawLayers(p_stage, p_camview, m_draw_layers, 1.0f);
+}
+
+void Map::drawLayers(RenderList* p_stage, const SDL_Rect* p_camview, const std::vector<MapLayer*>& layers, float zoom)
+{
+    for (MapLayer* p_layer: layers) {
+        p_layer->draw(p_stage, p_camview, zoom);
+    }
+}
+
+/**
+ * Draws the map once for each of the `count` cameras in `pp_cameras`
+ * into their viewports.
+ *
+ * With setCacheViews(), the view of each camera is kept in a target
+ * texture, and as long as the camera does not move, only the parts
+ * of it that changed are drawn again: the rectangles of the actors
+ * that moved or changed their sprite, and of the animated tiles that
+ * switched frames (see MapLayer::changedRects()). The camera's
+ * viewport is then a single copy from the texture. On a menu or in a
+ * dialog with nothing moving, recording the map costs next to nothing
+ * and the renderer only copies the viewports. A camera that moves is
+ * drawn the usual way (see drawViews()), and its texture is drawn in
+ * full again in the first frame it stands still.
+ */
+void Map::draw(RenderList* p_stage, Camera* const* pp_cameras, size_t count)
+{
+    m_cached_views = 0;
+    if (!m_cache_views) {
+        drawViews(p_stage, pp_cameras, count);
+        return;
+    }
+
+    m_changed_rects.clear();
+    for(MapLayer* p_layer: m_layers) {
+        p_layer->changedRects(m_changed_rects);
+    }
+    m_gid_changed.assign(m_gid_changed.size(), false);
+
+    m_moving_cameras.clear();
+    for(size_t i=0; i < count; i++) {
+        if (drawCachedView(p_stage, pp_cameras[i])) {
+            m_cached_views++;
+        } else {
+            m_moving_cameras.push_back(pp_cameras[i]);
+        }
+    }
+    drawViews(p_stage, m_moving_cameras.data(), m_moving_cameras.size());
+}
+
+/**
+ * Enables or disables view caching; see draw(). Either way the
+ * caches are redrawn in full when next used.
+ */
+void Map::setCacheViews(bool cache)
+{
+    m_cache_views = cache;
+    for(ViewCache& view_cache: m_view_caches) {
+        view_cache.valid = false;
+    }
+}
+
+/**
+ * Draws the view of `p_camera` from its cache texture, after drawing
+ * the changed rectangles of the map (`m_changed_rects`) into it, or
+ * all of it if it is not valid. Returns false without drawing anything
+ * if the camera moved since the last frame, while the cache texture is
+ * being created, or if the renderer does not support target textures.
+ */
+bool Map::drawCachedView(RenderList* p_stage, Camera* p_camera)
+{
+    if (!m_cache_supported) {
+        return false;
+    }
+
+    const SDL_Rect& view = p_camera->view();
+    const SDL_Rect& viewport = p_camera->viewport();
+    const vector<MapLayer*>* p_layers = &drawLayers(p_camera);
+    assert(viewport.w > 0 && viewport.h > 0);
+
+    ViewCache* p_cache = nullptr;
+    for(ViewCache& cache: m_view_caches) {
+        if (cache.p_camera == p_camera) {
+            p_cache = &cache;
+        }
+    }
+    if (!p_cache) {
+        m_view_caches.push_back(ViewCache{p_camera, nullptr, 0, 0, 0, view, p_camera->zoom(), p_layers, false});
+        p_cache = &m_view_caches.back();
+    }
+
+    // Only draw through the cache once the camera stands still
+    if (!SDL_RectEquals(&p_cache->view, &view) || p_cache->zoom != p_camera->zoom() || p_cache->p_layers != p_layers) {
+        p_cache->view     = view;
+        p_cache->zoom     = p_camera->zoom();
+        p_cache->p_layers = p_layers;
+        p_cache->valid    = false;
+        return false;
+    }
+
+    // Create the texture without waiting for the frame in flight, and
+    // draw without the cache until it exists
+    RenderThread& render_thread = Ilmendur::instance().renderThread();
+    if (p_cache->ticket) {
+        if (!render_thread.isDone(p_cache->ticket)) {
+            return false;
+        }
+        p_cache->ticket = 0;
+        if (!p_cache->p_texture) {
+            m_cache_supported = false;
+            return false;
+        }
+    }
+    if (!p_cache->p_texture || p_cache->w != viewport.w || p_cache->h != viewport.h) {
+        SDL_Texture** pp_texture = &p_cache->p_texture;
+        int w = viewport.w;
+        int h = viewport.h;
+        p_cache->ticket = render_thread.post([pp_texture, w, h](SDL_Renderer* p_renderer){
+            if (*pp_texture) {
+                SDL_DestroyTexture(*pp_texture);
+                *pp_texture = nullptr;
+            }
+            if (SDL_RenderTargetSupported(p_renderer)) {
+                *pp_texture = SDL_CreateTexture(p_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+            }
+        });
+        p_cache->w     = w;
+        p_cache->h     = h;
+        p_cache->valid = false;
+        return false;
+    }
+
+    m_dirty.clear();
+    if (p_cache->valid) {
+        for(const SDL_Rect& rect: m_changed_rects) {
+            SDL_Rect visible;
+            if (SDL_IntersectRect(&rect, &view, &visible)) {
+                m_dirty.add(visible);
+            }
+        }
+    } else {
+        m_dirty.add(view);
+        p_cache->valid = true;
+    }
+
+    // Redraw the dirty rectangles in view coordinates, scaled like
+    // Camera::draw() does, and clipped so that the tiles and actors
+    // only partly inside them do not draw over what is still valid
+    if (!m_dirty.empty()) {
+        if (!mp_patch) {
+            mp_patch.reset(new RenderList);
+        }
+        p_stage->setTarget(p_cache->p_texture);
+        p_stage->setScale(p_camera->zoom(), p_camera->zoom());
+        p_stage->setDrawColor(0, 0, 0, 255);
+        for(const SDL_Rect& rect: m_dirty.rects()) {
+            SDL_Rect local{rect.x - view.x, rect.y - view.y, rect.w, rect.h};
+            mp_patch->reset();
+            drawLayers(mp_patch.get(), &rect, *p_layers, p_camera->zoom());
+            p_stage->setClipRect(&local);
+            p_stage->fillRect(&local);
+            p_stage->append(*mp_patch, local.x, local.y, local);
+        }
+        p_stage->setTarget(nullptr);
+    }
+
+    SDL_Rect destrect{0, 0, viewport.w, viewport.h};
+    p_camera->draw(p_stage);
+    p_stage->setScale(1.0f, 1.0f);
+    p_stage->copy(p_cache->p_texture, nullptr, &destrect);
+    return true;
+}
+
+/**
+ * Draws the map once for each of the `count` cameras in `pp_cameras`
+ * into their viewports, with one visibility pass for all of them:
+ * cameras whose views overlap share one list of the tiles and actors
+ * visible in the union of their views, which is recorded once and then
+ * replayed for each of them. In split screen mode with the heroes
+ * close to each other, this saves up to half the work of walking the
+ * layers.
+ * The result is the same as calling Camera::draw() and drawing the
+ * camera's drawLayers() at the camera's zoom per camera. Cameras with
+ * different layers or tileset texture levels never share a group.
+ *
+ * With setMergeViews(), cameras whose views are at most MERGE_THRESHOLD
+ * of their size apart are not even rasterised separately: the union
+ * of their views is drawn once into an offscreen target texture, and
+ * each camera's viewport becomes a single copy from it.
+ */
+void Map::drawViews(RenderList* p_stage, Camera* const* pp_cameras, size_t count)
+{
+    // Group the cameras by overlapping views and equal layers
+    m_view_groups.resize(count);
+    m_view_rects.clear();
+    m_view_layers.clear();
+    m_view_zooms.clear();
+    for(size_t i=0; i < count; i++) {
+        const SDL_Rect& view = pp_cameras[i]->view();
+        const vector<MapLayer*>* p_layers = &drawLayers(pp_cameras[i]);
+        const int level = Tileset::atlasLevel(pp_cameras[i]->zoom());
+        size_t group = 0;
+        while (group < m_view_rects.size()
+               && (m_view_layers[group] != p_layers
+                   || Tileset::atlasLevel(m_view_zooms[group]) != level
+                   || !SDL_HasIntersection(&m_view_rects[group], &view))) {
+            group++;
+        }
+        if (group < m_view_rects.size()) {
+            SDL_UnionRect(&m_view_rects[group], &view, &m_view_rects[group]);
+        } else {
+            m_view_rects.push_back(view);
+            m_view_layers.push_back(p_layers);
+            m_view_zooms.push_back(pp_cameras[i]->zoom());
+        }
+        m_view_groups[i] = group;
+    }
+
+    // Record the visible tiles and actors once per group
+    while (m_visible.size() < m_view_rects.size()) {
+        m_visible.emplace_back(new RenderList);
+    }
+    for(size_t group=0; group < m_view_rects.size(); group++) {
+        PROFILE_SCOPE("Map visibility pass");
+        m_visible[group]->reset();
+        drawLayers(m_visible[group].get(), &m_view_rects[group], *m_view_layers[group], m_view_zooms[group]);
+    }
+
+    // Draw at most one group into the merge target
+    m_merged_group = m_view_rects.size();
+    if (m_merge_views) {
+        for(size_t group=0; group < m_view_rects.size(); group++) {
+            if (canMergeViews(group, pp_cameras, count)) {
+                m_merged_group = group;
+                break;
+            }
+        }
+    }
+    if (m_merged_group < m_view_rects.size()) {
+        const SDL_Rect& union_rect = m_view_rects[m_merged_group];
+        SDL_Rect target_rect{0, 0, union_rect.w, union_rect.h};
+        p_stage->setTarget(mp_merge_target);
+        p_stage->setClipRect(&target_rect);
+        p_stage->setDrawColor(0, 0, 0, 255);
+        p_stage->clear();
+        p_stage->append(*m_visible[m_merged_group], 0, 0, target_rect);
+        p_stage->setTarget(nullptr);
+    }
+
+    // Replay them per camera
+    for(size_t i=0; i < count; i++) {
+        const SDL_Rect& view       = pp_cameras[i]->view();
+        const SDL_Rect& union_rect = m_view_rects[m_view_groups[i]];
+        pp_cameras[i]->draw(p_stage);
+        if (m_view_groups[i] == m_merged_group) {
+            SDL_Rect srcrect{view.x - union_rect.x, view.y - union_rect.y, view.w, view.h};
+            SDL_Rect destrect{0, 0, view.w, view.h};
+            p_stage->copy(mp_merge_target, &srcrect, &destrect);
+        } else {
+            p_stage->append(*m_visible[m_view_groups[i]],
+                            union_rect.x - view.x,
+                            union_rect.y - view.y,
+                            SDL_Rect{0, 0, view.w, view.h});
+        }
+    }
+}
+
+/**
+ * Checks whether the views of the cameras in `group` (see drawViews()) are
+ * close enough to each other to be drawn through the merge target,
+ * and creates that if necessary. Returns false while the merge target
+ * is being created, or if the renderer does not support target
+ * textures.
+ */
+bool Map::canMergeViews(size_t group, Camera* const* pp_cameras, size_t count)
+{
+    int cameras = 0;
+    int max_w   = 0;
+    int max_h   = 0;
+    for(size_t i=0; i < count; i++) {
+        if (m_view_groups[i] == group) {
+            // The target holds the views unscaled, which at zoom < 1
+            // are more pixels than the viewports
+            if (pp_cameras[i]->zoom() < 1.0f) {
+                return false;
+            }
+            cameras++;
+            max_w = max(max_w, pp_cameras[i]->view().w);
+            max_h = max(max_h, pp_cameras[i]->view().h);
+        }
+    }
+    if (cameras < 2) {
+        return false;
+    }
+
+    // Views that diverge too much are cheaper to draw separately
+    int target_w = max_w + max_w * MERGE_THRESHOLD;
+    int target_h = max_h + max_h * MERGE_THRESHOLD;
+    const SDL_Rect& union_rect = m_view_rects[group];
+    if (union_rect.w > target_w || union_rect.h > target_h) {
+        return false;
     }
+
+    // Like the view caches, draw the views separately until the
+    // merge target exists
+    RenderThread& render_thread = Ilmendur::instance().renderThread();
+    if (m_merge_ticket) {
+        if (!render_thread.isDone(m_merge_ticket)) {
+            return false;
+        }
+        m_merge_ticket = 0;
+        if (!mp_merge_target) {
+            m_merge_supported = false;
+        }
+    }
+    if (!m_merge_supported) {
+        return false;
+    }
+    if (mp_merge_target && union_rect.w <= m_merge_w && union_rect.h <= m_merge_h) {
+        return true;
+    }
+
+    // Only happens when the view size changes
+    m_merge_ticket = render_thread.post([this, target_w, target_h](SDL_Renderer* p_renderer){
+        if (mp_merge_target) {
+            SDL_DestroyTexture(mp_merge_target);
+            mp_merge_target = nullptr;
+        }
+        if (SDL_RenderTargetSupported(p_renderer)) {
+            mp_merge_target = SDL_CreateTexture(p_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, target_w, target_h);
+        }
+    });
+    m_merge_w = target_w;
+    m_merge_h = target_h;
+    return false;
 }
 
 /**
@@ -233,7 +941,7 @@ SDL_Rect Map::drawRect() const
     return SDL_Rect{0, 0, m_width * TILEWIDTH, m_height * TILEWIDTH};
 }
 
-bool TileLayer::readTile(SDL_Texture*& p_texid, SDL_Rect& rect, int gid)
+bool TileLayer::readTile(SDL_Texture*& p_texid, SDL_Rect& rect, int gid, int level)
 {
     static std::map<int,Tileset*>::iterator iter;
     if (gid == 0) {
@@ -245,8 +953,8 @@ bool TileLayer::readTile(SDL_Texture*& p_texid, SDL_Rect& rect, int gid)
             ++iter;
             if (iter == mr_map.tilesets().end() || gid < iter->first) {
                 --iter;
-                p_texid = iter->second->sdlTexture();
-                iter->second->readTile(rect, gid - iter->first);
+                p_texid = iter->second->sdlTexture(level);
+                iter->second->readTile(rect, gid - iter->first, level);
                 return true;
             } else {
                 --iter;
@@ -263,110 +971,253 @@ void Map::update()
     /* Note: This is not the place to optimise by trying to only update
      * actors within the camera range. That would cause rather unnatural
      * behaviour. Always update all actors on the stage, and optimise by
-     * not drawing them all in draw(). */
+     * not drawing them all in draw(). Instead, the per-row work is spread
+     * over all cores by advanceActors(). */
+    updateAnimations();
+
+    {
+        PROFILE_SCOPE("Advance actors");
+        advanceActors();
+    }
+
+    /* The actors' update() hooks and the collision handlers run serially
+     * and in layer order, as they may touch anything. This keeps the
+     * game state independent of the number of threads. */
     for(MapLayer* p_layer: m_layers) {
+        PROFILE_SCOPE_DYNAMIC(p_layer->name());
         p_layer->update();
     }
 }
 
+/**
+ * Advances movement and animation of the actors on all object layers,
+ * one layer after the other; each layer spreads its per-row passes
+ * over the job system, see ObjectLayer::advanceActors(). This is the
+ * first step of update().
+ */
+void Map::advanceActors()
+{
+    JobSystem& jobs = Ilmendur::instance().jobSystem();
+    for(ObjectLayer* p_layer: m_object_layers) {
+        p_layer->advanceActors(jobs);
+    }
+}
+
 /**
  * Checks for collisions, rectifying impossible result positions.
  * Note that apart from collision with the map boundary, collisions
  * can only occur between actors on the same layer.
+ *
+ * This runs in three steps: first, all actors are kept inside the
+ * map boundary. Then, all pairs of intersecting actors are collected,
+ * in parallel over the cells of a uniform grid (see binCollisionBoxes()
+ * and findCollisions()). Finally, the collision events
+ * are dispatched serially, in the order of the actor IDs, so that the
+ * outcome does not depend on the number of threads.
  */
 void ObjectLayer::checkCollisions()
 {
-    for(Actor* p_actor: m_actors) {
-        checkCollideMapBoundary(p_actor);
-        checkCollideActors(p_actor);
+    m_depth_sorted = false;
+    // Also refreshes the store's cached collision boxes.
+    for(size_t i=0; i < m_store.size(); i++) {
+        checkCollideMapBoundary(i);
     }
+
+    binCollisionBoxes();
+    findCollisions(Ilmendur::instance().jobSystem());
+    dispatchCollisions();
 }
 
-void ObjectLayer::checkCollideMapBoundary(Actor* p_actor)
+void ObjectLayer::checkCollideMapBoundary(size_t index)
 {
     /* Do not walk off the map. It is allowed to have the drawing rectangle
      * hang into the void, but not the collision box, i.e., the map's edge
      * counts as a wall. */
     SDL_Rect maprect = mr_map.drawRect();
-    if (p_actor->isInvisible()) {
-        if (p_actor->m_pos.x < 0.0f) {
-            p_actor->m_pos.x = 0.0f;
+    Vector2f& pos = m_store.pos[index];
+    const TextureInfo* p_texinfo = m_store.texinfo[index];
+    if (!p_texinfo) {
+        if (pos.x < 0.0f) {
+            pos.x = 0.0f;
         }
-        if (p_actor->m_pos.x >= maprect.w) {
-            p_actor->m_pos.x = maprect.w - 1.0f;
+        if (pos.x >= maprect.w) {
+            pos.x = maprect.w - 1.0f;
         }
-        if (p_actor->m_pos.y < 0.0f) {
-            p_actor->m_pos.y = 0.0f;
+        if (pos.y < 0.0f) {
+            pos.y = 0.0f;
         }
-        if (p_actor->m_pos.y >= maprect.h) {
-            p_actor->m_pos.y = maprect.h - 1.0f;
+        if (pos.y >= maprect.h) {
+            pos.y = maprect.h - 1.0f;
         }
     } else {
-        SDL_Rect collrect = p_actor->collisionBox();
+        SDL_Rect collrect = m_store.collisionBox(index);
         if (collrect.x < maprect.x) {
-            p_actor->m_pos.x = maprect.x + p_actor->mp_texinfo->origx - p_actor->mp_texinfo->collx;
-            p_actor->stopMoving();
+            pos.x = maprect.x + p_texinfo->origx - p_texinfo->collx;
+            m_store.stopMoving(index);
         }
         if (collrect.x + collrect.w > maprect.x + maprect.w) {
-            p_actor->m_pos.x = maprect.x + maprect.w - p_actor->mp_texinfo->origx - p_actor->mp_texinfo->collx;
-            p_actor->stopMoving();
+            pos.x = maprect.x + maprect.w - p_texinfo->origx - p_texinfo->collx;
+            m_store.stopMoving(index);
         }
         if (collrect.y < maprect.y) {
-            p_actor->m_pos.y = maprect.y + p_actor->mp_texinfo->origy - p_actor->mp_texinfo->colly;
-            p_actor->stopMoving();
+            pos.y = maprect.y + p_texinfo->origy - p_texinfo->colly;
+            m_store.stopMoving(index);
         }
         if (collrect.y + collrect.h > maprect.y + maprect.h) {
-            p_actor->m_pos.y = maprect.y + maprect.h - p_actor->mp_texinfo->origy - p_actor->mp_texinfo->colly;
-            p_actor->stopMoving();
+            pos.y = maprect.y + maprect.h - p_texinfo->origy - p_texinfo->colly;
+            m_store.stopMoving(index);
         }
     }
 
+    m_store.updateBox(index);
+
     // TODO: Fire event on p_actor
 }
 
 /**
- * Checks collisions with other actors. Only actors on the same
- * layer can collide, hence it is possible to have this as a
- * member function of ObjectLayer rather than Map.
+ * Sorts the rows with a non-empty cached collision box into the cells
+ * of `m_collision_grid` they touch, by counting sort, so that the rows
+ * of each cell stay in ascending order. Boxes reaching beyond the map
+ * are put into the border cells.
  */
-void ObjectLayer::checkCollideActors(Actor* p_actor)
+void ObjectLayer::binCollisionBoxes()
 {
-    using Collision = pair<Actor*,Actor*>;
+    CollisionGrid& grid = m_collision_grid;
+    const SDL_Rect maprect = mr_map.drawRect();
+    grid.width  = max(1, (maprect.w + COLLISION_CELL - 1) / COLLISION_CELL);
+    grid.height = max(1, (maprect.h + COLLISION_CELL - 1) / COLLISION_CELL);
+    const size_t cells = static_cast<size_t>(grid.width) * grid.height;
+
+    // Cells touched by the box of `row`; false for empty boxes.
+    auto cellRange = [&](size_t row, int& cx0, int& cy0, int& cx1, int& cy1) {
+        if (m_store.box_x0[row] >= m_store.box_x1[row] || m_store.box_y0[row] >= m_store.box_y1[row]) {
+            return false;
+        }
+        cx0 = clamp((m_store.box_x0[row] - maprect.x) / COLLISION_CELL, 0, grid.width - 1);
+        cy0 = clamp((m_store.box_y0[row] - maprect.y) / COLLISION_CELL, 0, grid.height - 1);
+        cx1 = clamp((m_store.box_x1[row] - 1 - maprect.x) / COLLISION_CELL, 0, grid.width - 1);
+        cy1 = clamp((m_store.box_y1[row] - 1 - maprect.y) / COLLISION_CELL, 0, grid.height - 1);
+        return true;
+    };
+
+    int cx0, cy0, cx1, cy1;
+    const size_t count = m_store.size();
+    grid.start.assign(cells + 1, 0);
+    for(size_t i=0; i < count; i++) {
+        if (cellRange(i, cx0, cy0, cx1, cy1)) {
+            for(int cy=cy0; cy <= cy1; cy++) {
+                for(int cx=cx0; cx <= cx1; cx++) {
+                    grid.start[cy * grid.width + cx + 1]++;
+                }
+            }
+        }
+    }
+    for(size_t c=0; c < cells; c++) {
+        grid.start[c + 1] += grid.start[c];
+    }
 
-    // First, collect all intersecting actors.
-    vector<Collision> collisions;
-    SDL_Rect collrect = p_actor->collisionBox();
-    SDL_Rect other_collbox;
-    for(Actor* p_other: m_actors) {
-        // Collision of an actor with itself is not possible.
-        if (p_actor->m_id == p_other->m_id) {
-            continue;
+    const size_t entries = grid.start[cells];
+    grid.rows.resize(entries);
+    grid.x0.resize(entries);
+    grid.y0.resize(entries);
+    grid.x1.resize(entries);
+    grid.y1.resize(entries);
+
+    grid.fill.assign(grid.start.begin(), grid.start.end() - 1);
+    for(size_t i=0; i < count; i++) {
+        if (cellRange(i, cx0, cy0, cx1, cy1)) {
+            for(int cy=cy0; cy <= cy1; cy++) {
+                for(int cx=cx0; cx <= cx1; cx++) {
+                    uint32_t entry = grid.fill[cy * grid.width + cx]++;
+                    grid.rows[entry] = static_cast<uint32_t>(i);
+                    grid.x0[entry]   = m_store.box_x0[i];
+                    grid.y0[entry]   = m_store.box_y0[i];
+                    grid.x1[entry]   = m_store.box_x1[i];
+                    grid.y1[entry]   = m_store.box_y1[i];
+                }
+            }
         }
+    }
+}
 
-        other_collbox = p_other->collisionBox();
-        if (SDL_HasIntersection(&collrect, &other_collbox)) {
-            // Ensure the actor with the smaller ID always comes first.
-            if (p_actor->m_id < p_other->m_id) {
-                collisions.push_back(make_pair(p_actor, p_other));
-            } else {
-                collisions.push_back(make_pair(p_other, p_actor));
+/**
+ * Collects the pairs of rows whose collision boxes intersect into the
+ * chunks of `m_collision_chunks`. Within each cell of the grid built
+ * by binCollisionBoxes(), every row is tested against the rows behind
+ * it, so that the lower row of a pair comes first. Pairs whose boxes
+ * share several cells are found once per shared cell; dispatchCollisions()
+ * removes the duplicates. Each job works on COLLISION_CELLS_PER_JOB
+ * cells, and the jobs are worked on in parallel by `jobs`; this only
+ * reads the store and the grid.
+ */
+void ObjectLayer::findCollisions(JobSystem& jobs)
+{
+    const CollisionGrid& grid = m_collision_grid;
+    const size_t cells = grid.start.size() - 1;
+    m_collision_chunks.resize((cells + COLLISION_CELLS_PER_JOB - 1) / COLLISION_CELLS_PER_JOB);
+
+    jobs.parallelFor(m_collision_chunks.size(), 1, [this, &grid, cells](size_t begin, size_t end) {
+        for(size_t c=begin; c < end; c++) {
+            CollisionChunk& chunk = m_collision_chunks[c];
+            chunk.pairs.clear();
+
+            const size_t last_cell = min(cells, (c + 1) * COLLISION_CELLS_PER_JOB);
+            for(size_t cell=c * COLLISION_CELLS_PER_JOB; cell < last_cell; cell++) {
+                const size_t cell_end = grid.start[cell + 1];
+                for(size_t e=grid.start[cell]; e + 1 < cell_end; e++) {
+                    const size_t first = e + 1;
+                    const size_t candidates = cell_end - first;
+                    chunk.hitmask.resize(AABB::maskWords(candidates));
+                    AABB::overlapMask(m_store.collisionBox(grid.rows[e]), candidates,
+                                      grid.x0.data() + first, grid.y0.data() + first,
+                                      grid.x1.data() + first, grid.y1.data() + first,
+                                      chunk.hitmask.data());
+
+                    for(size_t w=0; w < chunk.hitmask.size(); w++) {
+                        for(uint32_t bits=chunk.hitmask[w]; bits != 0; bits &= bits - 1) {
+                            chunk.pairs.emplace_back(grid.rows[e], grid.rows[first + w * 32 + __builtin_ctz(bits)]);
+                        }
+                    }
+                }
             }
         }
+    });
+}
+
+/**
+ * Dispatches the collision events for the pairs found by
+ * findCollisions(). Only actors on the same layer can collide,
+ * hence it is possible to have this as a member function of
+ * ObjectLayer rather than Map.
+ */
+void ObjectLayer::dispatchCollisions()
+{
+    /* Merge the chunks' pairs, sort them, and drop the duplicates of
+     * pairs found in several cells. As rows are sorted by ID, this
+     * yields the pairs sorted by (first ID, second ID), regardless of
+     * how many threads found them and in which cells. The actor with
+     * the smaller ID always comes first. The handlers may move actors
+     * to other layers, so resolve the rows now. */
+    m_collision_pairs.clear();
+    for(const CollisionChunk& chunk: m_collision_chunks) {
+        m_collision_pairs.insert(m_collision_pairs.end(), chunk.pairs.begin(), chunk.pairs.end());
     }
+    sort(m_collision_pairs.begin(), m_collision_pairs.end());
+    m_collision_pairs.erase(unique(m_collision_pairs.begin(), m_collision_pairs.end()), m_collision_pairs.end());
 
-    /* The above code will yield duplicates: each actor colliding with
-     * another actor will be included twice. The above code ensures
-     * that the pairs are equal, as the actor with the lower ID always
-     * comes first. */
-    unique(collisions.begin(),
-           collisions.end(),
-           [](Collision& coll1, Collision& coll2) { return coll1.first->m_id == coll2.first->m_id && coll1.second->m_id == coll2.second->m_id; });
+    m_collisions.clear();
+    for(const pair<uint32_t,uint32_t>& rows: m_collision_pairs) {
+        m_collisions.push_back(make_pair(m_store.actors[rows.first], m_store.actors[rows.second]));
+    }
+    assert(is_sorted(m_collisions.begin(), m_collisions.end(), [](const Collision& coll1, const Collision& coll2) {
+        return make_pair(coll1.first->m_id, coll1.second->m_id) < make_pair(coll2.first->m_id, coll2.second->m_id);
+    }));
 
     // Now execute all the collisions.
     SDL_Rect collrect1;
     SDL_Rect collrect2;
     SDL_Rect intersect;
-    for(Collision& coll: collisions) {
+    for(Collision& coll: m_collisions) {
         collrect1 = coll.first->collisionBox();
         collrect2 = coll.second->collisionBox();
 
@@ -393,56 +1244,54 @@ void ObjectLayer::checkCollideActors(Actor* p_actor)
             coll.second->handleEvent(collev);
         }
     }
+
+    // The handlers may have displaced actors.
+    if (!m_collisions.empty()) {
+        m_store.updateBoxes();
+    }
 }
 
 /**
- * Release ownership of `p_actor` from this layer, leaving the Actor
- * instance dangling. This function is only intended to be used
- * in Map::changeActorLayer() and nowhere else! It is an implementation
- * detail! `p_actor` is in an inconsistent state after this method
- * returns!
+ * Remove `p_actor` from this layer, leaving the Actor instance
+ * dangling, and return its row from the ActorStore. This
+ * function is only intended to be used in Map::changeActorLayer()
+ * and nowhere else! It is an implementation detail! `p_actor` is in
+ * an inconsistent state after this method returns!
  *
  * \internal
  */
-void ObjectLayer::releaseActor(Actor* p_actor)
+ActorStore::Row ObjectLayer::releaseActor(Actor* p_actor)
 {
-    for(auto iter=m_actors.begin(); iter != m_actors.end(); iter++) {
-        if ((*iter)->m_id == p_actor->m_id) {
-            m_actors.erase(iter);
-            return;
-        }
-    }
-
     /* If this assert triggers, then the actor requested to be released
      * was not on the layer. This indicates that p_actor's mr_layer
      * got out of sync with it's layer's member information -- which
      * in turn is most likely the result of not using Map::changeActorLayer()
      * for changing an actor's layer. ONLY EVER USE changeActorLayer() to
      * change an actor's layer! */
-    assert(false);
+    assert(p_actor->mp_store == &m_store && m_store.actors[p_actor->m_index] == p_actor);
+
+    m_depth_sorted = false; // Row numbers change
+    m_rows_changed = true;
+    return m_store.erase(p_actor->m_index);
 }
 
 /**
- * Adds `p_actor` to the actors owned by this layer. This is
- * an internal API only meant to be used during actor construction.
- * It leaves `p_actor` itself untouched!
+ * Adds `p_actor` to the actors owned by this layer, with its data
+ * initialised from `row`, at the position corresponding to its ID.
+ * This is an internal API only meant to be used during actor
+ * construction and by Map::changeActorLayer().
  *
  * \internal
  */
-void ObjectLayer::addActor(Actor* p_actor)
+void ObjectLayer::addActor(Actor* p_actor, const ActorStore::Row& row)
 {
-    assert(p_actor->mapLayer() == this);
-
-    // Insert the actor at the position corresponding to its ID.
-    for(auto iter=m_actors.begin(); iter != m_actors.end(); iter++) {
-        if ((*iter)->id() > p_actor->id()) {
-            m_actors.insert(iter, p_actor);
-            return;
-        }
-    }
+    assert(row.id == p_actor->m_id);
 
-    // If this is reached, the actor has a higher ID than all existing actors.
-    m_actors.push_back(p_actor);
+    p_actor->mp_layer = this;
+    p_actor->mp_store = &m_store;
+    p_actor->m_index  = m_store.insert(p_actor, row);
+    m_depth_sorted = false; // Row numbers change
+    m_rows_changed = true;
 }
 
 vector<Actor*> Map::findAdjascentActors(Actor* p_actor, direction dir)
@@ -507,10 +1356,13 @@ vector<Actor*> Map::findActorsInArea(const SDL_Rect& area, ObjectLayer* p_layer)
 {
     if (p_layer) {
         vector<Actor*> results;
-        for (Actor* p_actor: p_layer->m_actors) {
-            SDL_Rect collrect = p_actor->collisionBox();
-            if (SDL_HasIntersection(&area, &collrect)) {
-                results.push_back(p_actor);
+        ActorStore& store = p_layer->m_store;
+        store.updateBoxes();
+        p_layer->m_hitmask.resize(AABB::maskWords(store.size()));
+        AABB::overlapMask(area, store.size(), store.box_x0.data(), store.box_y0.data(), store.box_x1.data(), store.box_y1.data(), p_layer->m_hitmask.data());
+        for(size_t w=0; w < p_layer->m_hitmask.size(); w++) {
+            for(uint32_t bits=p_layer->m_hitmask[w]; bits != 0; bits &= bits - 1) {
+                results.push_back(store.actors[w * 32 + __builtin_ctz(bits)]);
             }
         }
 
@@ -549,31 +1401,36 @@ void Map::heroes(Hero** p_freya, Hero** p_benjamin)
  */
 void Map::makeHeroes()
 {
+    // Collect the start positions first; creating the heroes
+    // inserts them into the layer's actor list.
+    vector<StartPosition*> startpositions;
     for(MapLayer* p_layer: m_layers) {
         ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(p_layer);
         if (p_obj_layer) {
             for(Actor* p_actor: p_obj_layer->actors()) {
                 StartPosition* p_startpos = dynamic_cast<StartPosition*>(p_actor);
                 if (p_startpos) {
-                    if (p_startpos->herono == 1) {
-                        mp_freya = new Hero(p_obj_layer, 1);
-                        mp_freya->warp(p_startpos->startpos);
-                        mp_freya->turn(direction::up);
-                        p_obj_layer->addActor(mp_freya);
-                    } else if (p_startpos->herono == 2) {
-                        mp_benjamin = new Hero(p_obj_layer, 2);
-                        mp_benjamin->warp(p_startpos->startpos);
-                        mp_benjamin->turn(direction::up);
-                        p_obj_layer->addActor(mp_benjamin);
-                    } else {
-                        // This is a two-player game.
-                        assert(false);
-                    }
+                    startpositions.push_back(p_startpos);
                 }
             }
         }
     }
 
+    for(StartPosition* p_startpos: startpositions) {
+        if (p_startpos->herono == 1) {
+            mp_freya = m_arena.create<Hero>(p_startpos->mapLayer(), 1);
+            mp_freya->warp(p_startpos->startpos);
+            mp_freya->turn(direction::up);
+        } else if (p_startpos->herono == 2) {
+            mp_benjamin = m_arena.create<Hero>(p_startpos->mapLayer(), 2);
+            mp_benjamin->warp(p_startpos->startpos);
+            mp_benjamin->turn(direction::up);
+        } else {
+            // This is a two-player game.
+            assert(false);
+        }
+    }
+
     // If at least one hero was placed, it is ok.
     if (mp_freya || mp_benjamin) {
         return;
@@ -583,15 +1440,13 @@ void Map::makeHeroes()
     for(MapLayer* p_layer: m_layers) {
         ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(p_layer);
         if (p_obj_layer) {
-            mp_freya = new Hero(p_obj_layer, 1);
+            mp_freya = m_arena.create<Hero>(p_obj_layer, 1);
             mp_freya->warp(Vector2f(100.0f, 100.0f));
             mp_freya->turn(direction::up);
-            p_obj_layer->addActor(mp_freya);
 
-            mp_benjamin = new Hero(p_obj_layer, 2);
+            mp_benjamin = m_arena.create<Hero>(p_obj_layer, 2);
             mp_benjamin->warp(Vector2f(200.0f, 200.0f));
             mp_benjamin->turn(direction::up);
-            p_obj_layer->addActor(mp_benjamin);
             return;
         }
     }
@@ -613,15 +1468,13 @@ void Map::makeHeroesTeleport(int entry_id)
     assert(p_entry);
 
     ObjectLayer* p_obj_layer = p_entry->mp_layer;
-    mp_freya    = new Hero(p_obj_layer, 1);
-    mp_benjamin = new Hero(p_obj_layer, 2);
+    mp_freya    = m_arena.create<Hero>(p_obj_layer, 1);
+    mp_benjamin = m_arena.create<Hero>(p_obj_layer, 2);
 
     mp_freya->warp(p_entry->position());
     mp_freya->turn(p_entry->enterDirection());
     mp_benjamin->warp(p_entry->position());
     mp_benjamin->turn(p_entry->enterDirection());
-    p_obj_layer->addActor(mp_freya);
-    p_obj_layer->addActor(mp_benjamin);
 }
 
 /**
@@ -641,11 +1494,10 @@ bool Map::findActor(int id, Actor** pp_actor)
     for (MapLayer* p_layer: m_layers) {
         ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(p_layer);
         if (p_obj_layer) {
-            for (auto iter=p_obj_layer->actors().begin();
-                 iter != p_obj_layer->actors().end();
-                 iter++) {
-                if (id == (*iter)->id()) {
-                    *pp_actor = *iter;
+            const ActorStore& store = p_obj_layer->m_store;
+            for (size_t i=0; i < store.size(); i++) {
+                if (id == store.ids[i]) {
+                    *pp_actor = store.actors[i];
                     return true;
                 }
             }
@@ -656,24 +1508,23 @@ bool Map::findActor(int id, Actor** pp_actor)
 }
 
 /**
- * Changes the layer `p_actor' is on to the layer with the given name.
+ * Changes the layer `p_actor' is on to the layer with the given (interned) name.
  * The method will crash with an assertion failure if `p_actor' is not
  * on this map or the requested target layer does not exist.
  */
-void Map::changeActorLayer(Actor* p_actor, const string& target_layer_name)
+void Map::changeActorLayer(Actor* p_actor, StringId target_layer)
 {
     assert(&p_actor->mapLayer()->map() == this);
 
-    // Find the layer the actor is on, remove it from there,
-    // and move it to the target layer.
+    // Find the layer the actor is on, remove its row from there,
+    // and move the row to the target layer.
     ObjectLayer* p_layer = p_actor->mapLayer();
-    p_layer->releaseActor(p_actor); // p_actor's mp_layer is now out of sync!!
 
     for(auto iter=m_layers.begin(); iter != m_layers.end(); iter++) {
         ObjectLayer* p_obj_layer = dynamic_cast<ObjectLayer*>(*iter);
-        if (p_obj_layer && p_obj_layer->name() == target_layer_name) {
-            p_actor->mp_layer = p_obj_layer; // Now p_obj_layer's actor list is broken
-            p_obj_layer->addActor(p_actor);  // Fix it
+        if (p_obj_layer && p_obj_layer->nameId() == target_layer) {
+            ActorStore::Row row = p_layer->releaseActor(p_actor); // p_actor is now out of sync!!
+            p_obj_layer->addActor(p_actor, row);                  // Fix it
             return;
         }
     }
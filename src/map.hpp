@@ -2,22 +2,29 @@
 #define ILMENDUR_MAP_HPP
 #include "tileset.hpp"
 #include "globals.hpp"
+#include "properties.hpp"
+#include "arena.hpp"
+#include "actors/actor_store.hpp"
+#include "dirty_region.hpp"
 #include <vector>
+#include <deque>
 #include <map>
+#include <memory>
+#include <filesystem>
+#include <cassert>
 
 class Actor;
 class Hero;
 class Map;
 class ObjectLayer;
+class JobSystem;
+class RenderList;
+class Camera;
 
 namespace MapControllers {
     class MapController;
 }
 
-namespace TMX {
-    void tmxAddActor(ObjectLayer* p_target_layer, Actor* p_actor);
-}
-
 class MapLayer
 {
 public:
@@ -25,14 +32,19 @@ public:
     virtual ~MapLayer();
 
     virtual void update() = 0;
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview) = 0;
+    /// Draws the layer within `p_camview`, for a camera zoomed by `zoom`; see Camera::setZoom().
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview, float zoom) = 0;
+    /// Appends the world rectangles in which the layer looks different than at the last call.
+    virtual void changedRects(std::vector<SDL_Rect>& rects) = 0;
 
     inline const std::string& name() { return m_name; }
+    inline StringId nameId() const { return m_name_id; }
     inline const Properties& props() { return m_props; }
     inline Map& map() { return mr_map; }
 protected:
     Map& mr_map;
     std::string m_name;
+    StringId m_name_id;
     Properties m_props;
 };
 
@@ -41,16 +53,22 @@ class TileLayer: public MapLayer
 public:
     enum class layer_direction { up, down, both };
 
-    TileLayer(Map& map, std::string name, Properties props, int width, int height, std::vector<int> gids);
+    TileLayer(Map& map, std::string name, Properties props, int width, int height, std::pmr::vector<int> gids);
     virtual void update();
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview, float zoom);
+    virtual void changedRects(std::vector<SDL_Rect>& rects);
+    void findAnimatedCells();
+
+    /// The `facedir` property; see Map::drawLayers().
+    inline layer_direction layerDirection() const { return m_dir; }
 private:
-    bool readTile(SDL_Texture*& p_texid, SDL_Rect& rect, int gid);
+    bool readTile(SDL_Texture*& p_texid, SDL_Rect& rect, int gid, int level);
 
     int m_width;
     int m_height;
-    std::vector<int> m_gids;
+    std::pmr::vector<int> m_gids;
     layer_direction m_dir;
+    std::vector<int> m_animated_cells; ///< Indices into `m_gids` of the animated tiles
 };
 
 class ObjectLayer: public MapLayer
@@ -59,42 +77,128 @@ public:
     ObjectLayer(Map& map, std::string name, Properties props);
     virtual ~ObjectLayer();
     virtual void update();
-    virtual void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
-    inline const std::vector<Actor*>& actors() { return m_actors; }
+    virtual void draw(RenderList* p_stage, const SDL_Rect* p_camview, float zoom);
+    virtual void changedRects(std::vector<SDL_Rect>& rects);
+    inline const std::pmr::vector<Actor*>& actors() { return m_store.actors; }
+    inline const ActorStore& actorStore() const { return m_store; }
 
-private:
-    void addActor(Actor* p_actor);
-    void releaseActor(Actor* p_actor);
+    typedef std::pair<Actor*,Actor*> Collision;
+    /// Collisions dispatched by the last checkCollisions(), in dispatch order.
+    inline const std::vector<Collision>& collisions() const { return m_collisions; }
+
+    void advanceActors(JobSystem& jobs);
+    void updateActors();
     void checkCollisions();
-    void checkCollideMapBoundary(Actor* p_actor);
-    void checkCollideActors(Actor* p_actor);
+private:
+    void addActor(Actor* p_actor, const ActorStore::Row& row);
+    ActorStore::Row releaseActor(Actor* p_actor);
+    void checkCollideMapBoundary(size_t index);
+    void binCollisionBoxes();
+    void findCollisions(JobSystem& jobs);
+    void dispatchCollisions();
+    void sortDepth();
 
-    std::vector<Actor*> m_actors;
+    /// Edge length in pixels of the cells of the collision grid.
+    static const int COLLISION_CELL = 128;
+    /// Grid cells per job of findCollisions().
+    static const size_t COLLISION_CELLS_PER_JOB = 16;
 
-    // Allow Map::changeActorLayer() and Map::makeHeroes() to call
-    // the addActor() and releaseActor() internal functions.
+    /**
+     * The rows with a collision box, binned into a uniform grid over
+     * the map by binCollisionBoxes(). A row is in every cell its box
+     * touches. The rows of cell `c` are `rows[start[c]]` up to
+     * `rows[start[c + 1]]`, in ascending order; `x0` etc. hold copies
+     * of their cached boxes in the same order for AABB::overlapMask().
+     */
+    struct CollisionGrid
+    {
+        int width = 0;  ///< In cells
+        int height = 0; ///< In cells
+        std::vector<uint32_t> start;
+        std::vector<uint32_t> rows;
+        std::vector<int> x0;
+        std::vector<int> y0;
+        std::vector<int> x1;
+        std::vector<int> y1;
+        std::vector<uint32_t> fill; ///< Scratch space of binCollisionBoxes()
+    };
+
+    /// Result of one job of findCollisions().
+    struct CollisionChunk
+    {
+        std::vector<uint32_t> hitmask;
+        std::vector<std::pair<uint32_t,uint32_t>> pairs; ///< Rows, lower row first
+    };
+
+    ActorStore m_store;
+    std::vector<uint32_t> m_hitmask; ///< Scratch space for AABB::overlapMask()
+    CollisionGrid m_collision_grid;
+    std::vector<CollisionChunk> m_collision_chunks;
+    std::vector<std::pair<uint32_t,uint32_t>> m_collision_pairs; ///< Scratch space for dispatchCollisions()
+    std::vector<Collision> m_collisions;
+    std::vector<uint32_t> m_depth_order; ///< All rows in depth order as of the last sortDepth()
+    std::vector<bool> m_depth_present;   ///< Scratch space for sortDepth(), per row
+    bool m_depth_sorted;                 ///< False if rows moved or changed since the last sortDepth()
+
+    /// What a row looked like at the last changedRects().
+    struct DrawState
+    {
+        SDL_Rect rect;
+        const TextureInfo* p_texinfo;
+        int frame;
+        direction lookdir;
+    };
+    std::vector<DrawState> m_drawn; ///< Per row, unless `m_rows_changed`
+    bool m_rows_changed;
+
+    // Allow Map::changeActorLayer() to call the addActor() and
+    // releaseActor() internal functions.
     friend class Map;
-    // Allow the Actor TMX deserialiser to access addActor().
-    friend void TMX::tmxAddActor(ObjectLayer* p_target_layer, Actor* p_actor);
+    // New actors add themselves with addActor().
+    friend class Actor;
 };
 
 class Map
 {
 public:
     Map(const std::string& name);
+    Map(const std::string& name, const std::filesystem::path& abs_path);
     ~Map();
 
-    void draw(SDL_Renderer* p_stage, const SDL_Rect* p_camview);
+    static std::filesystem::path findMapFile(const std::string& name);
+
+    void draw(RenderList* p_stage, const SDL_Rect* p_camview);
+    void draw(RenderList* p_stage, Camera* const* pp_cameras, size_t count);
     void setup();
+    /// Enables drawing close camera views through one target texture; see drawViews().
+    inline void setMergeViews(bool merge) { m_merge_views = merge; }
+    /// Whether the last draw() for several cameras used the merge target.
+    inline bool viewsMerged() const { return m_merged_group < m_view_rects.size(); }
+    /// Enables keeping the views of cameras that do not move in target textures; see draw().
+    void setCacheViews(bool cache);
+    /// Number of cameras the last draw() took from their cache.
+    inline size_t cachedViews() const { return m_cached_views; }
     void update();
+    bool isIdle(uint64_t* p_wakeup) const;
+    void advanceActors();
     SDL_Rect drawRect() const;
 
+    inline const std::vector<MapLayer*>& layers() { return m_layers; }
+    const std::vector<MapLayer*>& drawLayers(Camera* p_camera) const;
+
+    /// The gid to draw for `gid`, which differs for animated tiles.
+    inline int drawnGid(int gid) const { assert(gid >= 0 && static_cast<size_t>(gid) < m_gid_remap.size()); return m_gid_remap[gid]; }
+    /// Whether `gid` is an animated tile.
+    inline bool gidAnimated(int gid) const { return m_gid_animated[gid]; }
+    /// Whether drawnGid() changed for `gid` since the last draw() with view caching.
+    inline bool gidChanged(int gid) const { return m_gid_changed[gid]; }
+
     void makeHeroes();
     void makeHeroesTeleport(int entry_id);
     void heroes(Hero** p_freya, Hero** p_benjamin);
 
     bool findActor(int id, Actor** pp_actor);
-    void changeActorLayer(Actor* p_actor, const std::string& target_layer_name);
+    void changeActorLayer(Actor* p_actor, StringId target_layer);
     std::vector<Actor*> findAdjascentActors(Actor* p_actor, direction dir);
     std::vector<Actor*> findActorsInArea(const SDL_Rect& area, ObjectLayer* p_layer);
 
@@ -103,6 +207,9 @@ public:
     const std::string& name() { return m_name; }
     std::map<int, Tileset*>& tilesets() { return m_tilesets; }
 
+    /// Memory for all objects that live as long as this map does.
+    inline Arena& arena() { return m_arena; }
+
     // Helper types for dealing with Tiled layers. Actually, only
     // Tile and Object are supported by the Layer struct.
     // enum class LayerType { Tile, Object, Image, Group };
@@ -115,15 +222,89 @@ public:
     // };
 
 private:
+    void setupDrawLayers();
+    void drawLayers(RenderList* p_stage, const SDL_Rect* p_camview, const std::vector<MapLayer*>& layers, float zoom);
+    void setupAnimations();
+    void updateAnimations();
+    void drawViews(RenderList* p_stage, Camera* const* pp_cameras, size_t count);
+    bool drawCachedView(RenderList* p_stage, Camera* p_camera);
+
+    /// An animated gid; its frames are `frame_count` consecutive entries of `m_animation_frames`.
+    struct AnimatedGid
+    {
+        int gid;
+        size_t first_frame;
+        size_t frame_count;
+        int total_duration; ///< Milliseconds
+    };
+
+    struct AnimationFrame
+    {
+        int gid;
+        int end_time; ///< Milliseconds since the start of the animation at which this frame ends
+    };
+
+    Arena m_arena;
     std::string m_name;
     std::map<int,Tileset*> m_tilesets;
     std::vector<MapLayer*> m_layers;
+    std::vector<ObjectLayer*> m_object_layers; ///< The ObjectLayer instances in `m_layers`
+    std::vector<MapLayer*> m_draw_layers;      ///< Layers drawn unless the hero looks down; see drawLayers()
+    std::vector<MapLayer*> m_draw_layers_down; ///< Layers drawn while the hero looks down
     int m_width;
     int m_height;
     std::string m_bg_music;
     Hero* mp_freya;
     Hero* mp_benjamin;
     MapControllers::MapController *mp_controller;
+
+    std::vector<int> m_gid_remap; ///< Gid to draw for each gid; see drawnGid()
+    std::vector<bool> m_gid_animated;
+    std::vector<bool> m_gid_changed;
+    std::vector<AnimatedGid> m_animated_gids;
+    std::vector<AnimationFrame> m_animation_frames;
+
+    // Scratch space of the visibility pass in draw()
+    std::vector<SDL_Rect> m_view_rects;   ///< Union of the views of each camera group
+    std::vector<const std::vector<MapLayer*>*> m_view_layers; ///< drawLayers() of each camera group
+    std::vector<float> m_view_zooms;      ///< Zoom of the first camera of each group
+    std::vector<size_t> m_view_groups;    ///< Group index of each camera
+    std::vector<std::unique_ptr<RenderList>> m_visible; ///< Visible tiles and actors of each group
+
+    /// Camera views are merged if their union is at most this fraction wider and taller than a view.
+    static constexpr float MERGE_THRESHOLD = 0.25f;
+    bool canMergeViews(size_t group, Camera* const* pp_cameras, size_t count);
+
+    bool m_merge_views;
+    size_t m_merged_group;        ///< Group drawn through `mp_merge_target`; no group if out of range
+    SDL_Texture* mp_merge_target; ///< Owned by the render thread
+    uint64_t m_merge_ticket;      ///< RenderThread::post() ticket of the `mp_merge_target` creation; 0 if none
+    int m_merge_w;
+    int m_merge_h;
+    bool m_merge_supported;
+
+    /// The view of a camera as it was drawn into `p_texture`.
+    struct ViewCache
+    {
+        const Camera* p_camera;
+        SDL_Texture* p_texture; ///< Owned by the render thread; viewport sized
+        uint64_t ticket;        ///< RenderThread::post() ticket of the `p_texture` creation; 0 if none
+        int w;
+        int h;
+        SDL_Rect view;
+        float zoom;
+        const std::vector<MapLayer*>* p_layers;
+        bool valid; ///< False if `p_texture` does not show `view` yet
+    };
+
+    bool m_cache_views;
+    bool m_cache_supported;
+    size_t m_cached_views;
+    std::deque<ViewCache> m_view_caches; ///< Not a vector, as posted texture creations write into the elements
+    std::vector<SDL_Rect> m_changed_rects; ///< Scratch space of draw(): changedRects() of all layers
+    std::vector<Camera*> m_moving_cameras; ///< Scratch space of draw()
+    DirtyRegion m_dirty;                   ///< Scratch space of drawCachedView()
+    std::unique_ptr<RenderList> mp_patch;  ///< Scratch space of drawCachedView()
 };
 
 #endif /* ILMENDUR_MAP_HPP */
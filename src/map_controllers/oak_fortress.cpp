@@ -1,6 +1,7 @@
 #include "oak_fortress.hpp"
 #include "../gui.hpp"
 #include "../actors/npc.hpp"
+#include "../map.hpp"
 #include <cassert>
 
 #define SOME_ACTOR_ID 39
@@ -22,19 +23,24 @@ void MapControllers::OakFortress::setup()
     // activateFunction runs when the NPC is "spoken to" (user presses RETURN).
 }
 
-void MapControllers::OakFortress::clownGuy(NonPlayableCharacter* p_npc, Hero* p_hero)
+void MapControllers::OakFortress::clownGuy(NonPlayableCharacter* p_npc, Hero*)
 {
     assert(p_npc->id() == SOME_ACTOR_ID);
+    Scripts::start(clownGuyScript(p_npc), &p_npc->mapLayer()->map());
+}
 
-    GUISystem::messageDialog(1, GUISystem::text_velocity::normal, "Test NPC",
-                             {"I am a test NPC, and I am now going to make a step to the right."},
-                             [p_npc] {p_npc->moveBackward();});
+Script MapControllers::OakFortress::clownGuyScript(NonPlayableCharacter* p_npc)
+{
+    co_await Scripts::dialog(1, GUISystem::text_velocity::normal, "Test NPC",
+                             "I am a test NPC, and I am now going to make a step to the right.");
+    p_npc->moveBackward();
+    co_await Scripts::movement(p_npc);
 
     // Some pseudo code for what the NPC could possibly do:
     // if (Ilmendur::instance().saveState.globals.archievments.bossAbcBeaten) {
-    //     p_npc->moveRelative(Vector2f(1.0f, 1.0f));
+    //     co_await Scripts::moveTo(p_npc, p_npc->position() + Vector2f(32.0f, 32.0f), 32.0f);
     // } else {
     //     p_npc->turn(direction::down);
-    //     displayMessage("No!");
+    //     co_await Scripts::dialog(1, GUISystem::text_velocity::normal, "Test NPC", "No!");
     // }
 }
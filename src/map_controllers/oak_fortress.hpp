@@ -1,6 +1,7 @@
 #ifndef ILMENDUR_OAK_FORTRESS_HPP
 #define ILMENDUR_OAK_FORTRESS_HPP
 #include "map_controller.hpp"
+#include "../script.hpp"
 
 namespace MapControllers
 {
@@ -14,6 +15,9 @@ namespace MapControllers
     private:
         // -- NPC Activation functions follow --
         static void clownGuy(NonPlayableCharacter* p_npc, Hero* p_hero);
+
+        // -- Scripts started by them --
+        static Script clownGuyScript(NonPlayableCharacter* p_npc);
     };
 }
 
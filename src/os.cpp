@@ -19,11 +19,11 @@ fs::path OS::gameDataDir()
 {
 #ifdef ILMENDUR_DEBUG_BUILD
     // Support running from the build directory in debug mode
-    if (fs::exists(OS::exePath().parent_path() / fs::u8path("CMakeCache.txt"))) {
-        return fs::u8path(ILMENDUR_SOURCE_DIR) / fs::u8path("data");
+    if (fs::exists(OS::exePath().parent_path() / OS::utf8Path("CMakeCache.txt"))) {
+        return OS::utf8Path(ILMENDUR_SOURCE_DIR) / OS::utf8Path("data");
     } else {
 #endif
-        return fs::u8path(ILMENDUR_DATADIR);
+        return OS::utf8Path(ILMENDUR_DATADIR);
 #ifdef ILMENDUR_DEBUG_BUILD
     }
 #endif
@@ -49,7 +49,7 @@ fs::path OS::userDataDir()
     }
 
     return fs::path(xdg_data_home) /* getenv() returns native encoding, not necessaryly UTF-8 */
-        / fs::u8path("ilmendur");
+        / OS::utf8Path("ilmendur");
 #else
 #error Unsupported system
 #endif
@@ -74,3 +74,23 @@ fs::path OS::exePath()
 #error Unsupported platform
 #endif
 }
+
+/**
+ * Converts the UTF-8 encoded `str` into a path. This is what
+ * std::filesystem::u8path() did before C++20 deprecated it in favour
+ * of a std::u8string constructor, which std::string does not fit.
+ */
+fs::path OS::utf8Path(const string& str)
+{
+    return fs::path(u8string(str.begin(), str.end()));
+}
+
+/**
+ * Returns `path` as a UTF-8 encoded std::string, as opposed to
+ * path::u8string(), which returns a std::u8string since C++20.
+ */
+string OS::utf8String(const fs::path& path)
+{
+    u8string str = path.u8string();
+    return string(str.begin(), str.end());
+}
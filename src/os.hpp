@@ -8,6 +8,9 @@ namespace OS {
 
     std::filesystem::path gameDataDir();
     std::filesystem::path userDataDir();
+
+    std::filesystem::path utf8Path(const std::string& str);
+    std::string utf8String(const std::filesystem::path& path);
 }
 
 #endif /* ILMENDUR_OS_HPP */
@@ -0,0 +1,416 @@
+#include "profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+#include "ilmendur.hpp"
+#include "os.hpp"
+#include "util.hpp"
+#include "imgui/imgui.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <ctime>
+#include <cassert>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    struct FrameRecord
+    {
+        uint64_t start;        // µs since the profiler epoch
+        uint32_t duration;     // µs
+        unsigned int nsamples;
+        Profiler::Sample samples[Profiler::MAX_SAMPLES];
+    };
+
+    struct TraceEvent
+    {
+        int marker;
+        uint64_t start;    // µs since the profiler epoch
+        uint64_t duration; // µs
+    };
+
+    struct MarkerStats
+    {
+        int marker;
+        float p50;
+        float p95;
+        float p99;
+        float max;
+    };
+}
+
+// Deque so that references returned by markerName() stay valid.
+static deque<string> s_marker_names;
+static unordered_map<string, int> s_marker_ids;
+static mutex s_marker_mutex; // Markers may be registered from job threads
+static const thread::id s_main_thread = this_thread::get_id();
+static FrameRecord s_frames[Profiler::HISTORY_FRAMES];
+static unsigned int s_current_frame   = 0;  // Index of the frame being recorded in s_frames
+static unsigned int s_recorded_frames = 0;  // Completed frames in s_frames, at most HISTORY_FRAMES
+static bool s_in_frame                = false;
+static uint16_t s_depth               = 0;
+static bool s_show_overlay            = false;
+
+// Upper bound for the number of recorded trace events (about 24 MiB).
+static const size_t MAX_TRACE_EVENTS = 1000000;
+static const int FRAME_MARKER = Profiler::registerMarker("Frame");
+static bool s_tracing                 = false;
+static unsigned int s_trace_frames    = 0; // Frames left to record; 0 = unlimited
+static std::filesystem::path s_trace_path;
+static vector<TraceEvent> s_trace_events;
+
+/// Microseconds since the first call of this function.
+static uint64_t now()
+{
+    using namespace std::chrono;
+    static const steady_clock::time_point epoch = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - epoch).count();
+}
+
+/// Returns the index of the `age`th last completed frame in s_frames (0 = last completed).
+static unsigned int completedFrame(unsigned int age)
+{
+    assert(age < s_recorded_frames);
+    return (s_current_frame + Profiler::HISTORY_FRAMES - 1 - age) % Profiler::HISTORY_FRAMES;
+}
+
+/// Value at the given percentile (0.0-1.0) of an ascendingly sorted vector.
+static float percentile(const vector<float>& sorted, float p)
+{
+    if (sorted.empty()) {
+        return 0.0f;
+    }
+    size_t i = static_cast<size_t>(p * (sorted.size() - 1) + 0.5f);
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+/// Appends the completed scope to the trace if a trace is being recorded.
+static void traceEvent(int marker, uint64_t start, uint64_t duration)
+{
+    if (s_tracing && s_trace_events.size() < MAX_TRACE_EVENTS) {
+        s_trace_events.push_back(TraceEvent{marker, start, duration});
+    }
+}
+
+/**
+ * Returns the marker index for the given marker name, registering
+ * it if it is not yet known. Marker names are kept for the entire
+ * program runtime.
+ */
+int Profiler::registerMarker(const std::string& name)
+{
+    lock_guard<mutex> lock(s_marker_mutex);
+    auto iter = s_marker_ids.find(name);
+    if (iter != s_marker_ids.end()) {
+        return iter->second;
+    }
+
+    int marker = s_marker_names.size();
+    assert(marker <= UINT16_MAX);
+    s_marker_names.push_back(name);
+    s_marker_ids[name] = marker;
+    return marker;
+}
+
+const std::string& Profiler::markerName(int marker)
+{
+    lock_guard<mutex> lock(s_marker_mutex);
+    return s_marker_names.at(marker);
+}
+
+/* Copies the names of all markers registered so far. Job threads may
+ * register markers at any time, so the overlay and the trace export
+ * work on a copy instead of reading `s_marker_names` unlocked. */
+static vector<string> copyMarkerNames()
+{
+    lock_guard<mutex> lock(s_marker_mutex);
+    return vector<string>(s_marker_names.begin(), s_marker_names.end());
+}
+
+/**
+ * Start recording a new frame. This overwrites the oldest frame
+ * in the history. Call from the main loop only.
+ */
+void Profiler::beginFrame()
+{
+    FrameRecord& frame = s_frames[s_current_frame];
+    frame.start    = now();
+    frame.duration = 0;
+    frame.nsamples = 0;
+    s_depth        = 0;
+    s_in_frame     = true;
+}
+
+/**
+ * Finish recording the current frame. Call from the main loop only.
+ */
+void Profiler::endFrame()
+{
+    FrameRecord& frame = s_frames[s_current_frame];
+    frame.duration = now() - frame.start;
+    s_in_frame = false;
+    traceEvent(FRAME_MARKER, frame.start, frame.duration);
+
+    if (s_tracing && s_trace_frames > 0 && --s_trace_frames == 0) {
+        stopTrace();
+    }
+
+    s_current_frame = (s_current_frame + 1) % HISTORY_FRAMES;
+    if (s_recorded_frames < HISTORY_FRAMES) {
+        s_recorded_frames++;
+    }
+}
+
+Profiler::ScopedMarker::ScopedMarker(int marker)
+    : m_marker(marker),
+      m_sample(-1),
+      m_start(now())
+{
+    // Only the main thread is recorded; see JobSystem.
+    if (this_thread::get_id() != s_main_thread) {
+        m_marker = -1;
+        return;
+    }
+
+    FrameRecord& frame = s_frames[s_current_frame];
+    if (s_in_frame && frame.nsamples < MAX_SAMPLES) {
+        m_sample = frame.nsamples++;
+        Sample& sample  = frame.samples[m_sample];
+        sample.marker   = marker;
+        sample.depth    = s_depth;
+        sample.start    = m_start - frame.start;
+        sample.duration = 0;
+    }
+
+    s_depth++;
+}
+
+Profiler::ScopedMarker::~ScopedMarker()
+{
+    if (m_marker < 0) {
+        return;
+    }
+
+    uint64_t duration = now() - m_start;
+    s_depth--;
+    if (m_sample >= 0) {
+        s_frames[s_current_frame].samples[m_sample].duration = duration;
+    }
+
+    traceEvent(m_marker, m_start, duration);
+}
+
+void Profiler::toggleOverlay()
+{
+    s_show_overlay = !s_show_overlay;
+}
+
+/**
+ * Emit the ImGui calls for the profiler overlay if it is enabled.
+ * Call once per frame between ImGui::NewFrame() and ImGui::Render().
+ *
+ * The overlay shows the frame time history, the scopes of the last
+ * completed frame as flame-style bars (the full width corresponds to
+ * the target frame time), and per-marker percentiles over the history.
+ */
+void Profiler::drawOverlay()
+{
+    if (!s_show_overlay || s_recorded_frames == 0) {
+        return;
+    }
+
+    const float target_us = 1000000.0f / ILMENDUR_TARGET_FRAMERATE;
+    const vector<string> names = copyMarkerNames();
+
+    ImGui::SetNextWindowPos(ImVec2(40.0f, 40.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(1000.0f, 700.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Profiler", &s_show_overlay)) {
+        ImGui::End();
+        return;
+    }
+
+    // Frame time history, oldest frame first
+    float frametimes[HISTORY_FRAMES];
+    for(unsigned int i=0; i < s_recorded_frames; i++) {
+        frametimes[i] = s_frames[completedFrame(s_recorded_frames - 1 - i)].duration / 1000.0f;
+    }
+    const FrameRecord& last = s_frames[completedFrame(0)];
+    string overlay = "Last frame: " + to_string(last.duration / 1000.0f) + " ms";
+    ImGui::PlotLines("Frame time (ms)", frametimes, s_recorded_frames, 0, overlay.c_str(), 0.0f, 2.0f * target_us / 1000.0f, ImVec2(0, 80.0f));
+
+    // Flame bars of the last completed frame
+    ImDrawList* p_drawlist = ImGui::GetWindowDrawList();
+    const ImVec2 origin    = ImGui::GetCursorScreenPos();
+    const float width      = ImGui::GetContentRegionAvail().x;
+    const float rowheight  = ImGui::GetTextLineHeight() + 4.0f;
+    const float scale      = width / target_us; // pixels per µs
+    int maxdepth = 0;
+    for(unsigned int i=0; i < last.nsamples; i++) {
+        const Sample& sample = last.samples[i];
+        maxdepth = max(maxdepth, static_cast<int>(sample.depth));
+
+        ImVec2 p0(origin.x + sample.start * scale, origin.y + sample.depth * rowheight);
+        ImVec2 p1(max(p0.x + 1.0f, origin.x + (sample.start + sample.duration) * scale), p0.y + rowheight - 1.0f);
+        ImU32 color = ImColor::HSV(fmodf(sample.marker * 0.137f, 1.0f), 0.6f, 0.75f);
+        p_drawlist->AddRectFilled(p0, p1, color);
+
+        p_drawlist->PushClipRect(p0, p1, true);
+        p_drawlist->AddText(ImVec2(p0.x + 2.0f, p0.y + 2.0f), IM_COL32_WHITE, names[sample.marker].c_str());
+        p_drawlist->PopClipRect();
+
+        if (ImGui::IsMouseHoveringRect(p0, p1)) {
+            ImGui::SetTooltip("%s: %.3f ms", names[sample.marker].c_str(), sample.duration / 1000.0f);
+        }
+    }
+    // Mark the target frame time
+    p_drawlist->AddLine(ImVec2(origin.x + width - 1.0f, origin.y),
+                        ImVec2(origin.x + width - 1.0f, origin.y + (maxdepth + 1) * rowheight),
+                        IM_COL32(255, 0, 0, 255));
+    ImGui::Dummy(ImVec2(width, (maxdepth + 1) * rowheight));
+
+    // Percentiles per marker over the history. A marker hit several
+    // times in a frame counts with the sum of its durations.
+    vector<vector<float>> durations(names.size());
+    vector<float> framesum(names.size());
+    for(unsigned int age=0; age < s_recorded_frames; age++) {
+        const FrameRecord& frame = s_frames[completedFrame(age)];
+        fill(framesum.begin(), framesum.end(), -1.0f);
+        for(unsigned int i=0; i < frame.nsamples; i++) {
+            float& sum = framesum[frame.samples[i].marker];
+            sum = max(sum, 0.0f) + frame.samples[i].duration / 1000.0f;
+        }
+        for(size_t marker=0; marker < framesum.size(); marker++) {
+            if (framesum[marker] >= 0.0f) {
+                durations[marker].push_back(framesum[marker]);
+            }
+        }
+    }
+
+    vector<MarkerStats> stats;
+    for(size_t marker=0; marker < durations.size(); marker++) {
+        if (durations[marker].empty()) {
+            continue;
+        }
+        sort(durations[marker].begin(), durations[marker].end());
+        stats.push_back(MarkerStats{static_cast<int>(marker),
+                                    percentile(durations[marker], 0.5f),
+                                    percentile(durations[marker], 0.95f),
+                                    percentile(durations[marker], 0.99f),
+                                    durations[marker].back()});
+    }
+    sort(stats.begin(), stats.end(), [](const MarkerStats& a, const MarkerStats& b) { return a.p95 > b.p95; });
+
+    if (ImGui::BeginTable("Percentiles", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Marker");
+        ImGui::TableSetupColumn("p50 (ms)");
+        ImGui::TableSetupColumn("p95 (ms)");
+        ImGui::TableSetupColumn("p99 (ms)");
+        ImGui::TableSetupColumn("max (ms)");
+        ImGui::TableHeadersRow();
+        for(const MarkerStats& s: stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(names[s.marker].c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.p50);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.p95);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.p99);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", s.max);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+/**
+ * Start recording all markers into a trace file at `path`. If
+ * `frames` is nonzero, the trace is stopped and written automatically
+ * after that many frames; otherwise it is recorded until stopTrace()
+ * is called. A trace that is already running is written out first.
+ */
+void Profiler::startTrace(const std::filesystem::path& path, unsigned int frames)
+{
+    if (s_tracing) {
+        stopTrace();
+    }
+
+    s_trace_path   = path;
+    s_trace_frames = frames;
+    s_trace_events.clear();
+    s_trace_events.reserve(frames > 0 ? frames * 32 : 65536);
+    s_tracing      = true;
+}
+
+/**
+ * Stop the current trace and write it to the file requested with
+ * startTrace(), in the Chrome Trace Event Format. Does nothing if
+ * no trace is being recorded.
+ */
+void Profiler::stopTrace()
+{
+    if (!s_tracing) {
+        return;
+    }
+    s_tracing = false;
+
+    if (s_trace_path.has_parent_path() && !std::filesystem::exists(s_trace_path.parent_path())) {
+        std::filesystem::create_directories(s_trace_path.parent_path());
+    }
+
+    ofstream file(s_trace_path, ofstream::out | ofstream::trunc);
+    if (!file) {
+        cerr << "Failed to open trace file `" << OS::utf8String(s_trace_path) << "' for writing" << endl;
+        return;
+    }
+
+    const vector<string> names = copyMarkerNames();
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"Ilmendur " ILMENDUR_VERSION "\"}}";
+    for(const TraceEvent& event: s_trace_events) {
+        file << ",\n{\"name\":";
+        writeJsonString(file, names[event.marker]);
+        file << ",\"cat\":\"ilmendur\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+    }
+    file << "\n]}\n";
+
+    cout << "Wrote " << s_trace_events.size() << " trace events to " << OS::utf8String(s_trace_path) << endl;
+    s_trace_events.clear();
+    s_trace_events.shrink_to_fit();
+}
+
+/**
+ * Start a trace into a timestamped file below the user data
+ * directory, or stop and write the current trace if one is running.
+ * Bound to F4 in the main loop.
+ */
+void Profiler::toggleTrace()
+{
+    if (s_tracing) {
+        stopTrace();
+        return;
+    }
+
+    char timestamp[32];
+    time_t t = time(nullptr);
+    strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", localtime(&t));
+    startTrace(OS::userDataDir() / OS::utf8Path("traces") / OS::utf8Path(string("trace-") + timestamp + ".json"));
+}
+
+bool Profiler::isTracing()
+{
+    return s_tracing;
+}
+
+#endif /* ENABLE_PROFILER */
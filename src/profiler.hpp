@@ -0,0 +1,99 @@
+#ifndef ILMENDUR_PROFILER_HPP
+#define ILMENDUR_PROFILER_HPP
+#include "buildconfig.hpp"
+
+/**
+ * Built-in frame profiler. Code to be measured is wrapped into
+ * scoped markers with the PROFILE_SCOPE() macro; the main loop
+ * brackets each frame with beginFrame() and endFrame(). The timings
+ * of the last HISTORY_FRAMES frames are kept in a ring buffer and
+ * can be inspected with an ImGui overlay (toggled with F3).
+ *
+ * Additionally, all markers (including those hit outside of frames,
+ * like asset loading on startup) can be recorded into a file in the
+ * Chrome Trace Event Format, which can be loaded into Perfetto or
+ * chrome://tracing. See startTrace().
+ *
+ * Only scopes on the main thread are recorded; scopes on the job
+ * threads (see JobSystem) are ignored, so it is safe, but useless,
+ * to use PROFILE_SCOPE() in jobs. Measure the surrounding scope on
+ * the main thread that waits for the jobs instead.
+ *
+ * The profiler is only compiled in if ENABLE_PROFILER was set at
+ * configuration time (the default for debug builds). Otherwise,
+ * the PROFILE_* macros expand to nothing and none of the functions
+ * below exist.
+ */
+#ifdef ENABLE_PROFILER
+#include <cstdint>
+#include <string>
+#include <filesystem>
+
+namespace Profiler {
+
+    /// Number of frames kept in the history ring buffer.
+    const unsigned int HISTORY_FRAMES = 240;
+    /// Maximum number of samples per frame. Excess samples are dropped.
+    const unsigned int MAX_SAMPLES = 512;
+
+    /**
+     * One measured scope. Times are in microseconds relative
+     * to the start of the frame the sample belongs to.
+     */
+    struct Sample
+    {
+        uint16_t marker;   ///< Marker index, see markerName()
+        uint16_t depth;    ///< Nesting depth, 0 for outmost scopes
+        uint32_t start;    ///< Start time in µs since frame start
+        uint32_t duration; ///< Duration in µs
+    };
+
+    int registerMarker(const std::string& name);
+    const std::string& markerName(int marker);
+
+    void beginFrame();
+    void endFrame();
+
+    void toggleOverlay();
+    void drawOverlay();
+
+    void startTrace(const std::filesystem::path& path, unsigned int frames = 0);
+    void stopTrace();
+    void toggleTrace();
+    bool isTracing();
+
+    /**
+     * Measures the time between its construction and its
+     * destruction. Do not use directly, use the PROFILE_SCOPE()
+     * macro instead.
+     */
+    class ScopedMarker
+    {
+    public:
+        ScopedMarker(int marker);
+        ~ScopedMarker();
+    private:
+        int m_marker;
+        int m_sample;
+        uint64_t m_start;
+    };
+}
+
+#define ILMENDUR_PROFILE_CONCAT2(a, b) a##b
+#define ILMENDUR_PROFILE_CONCAT(a, b) ILMENDUR_PROFILE_CONCAT2(a, b)
+
+/// Measure the remainder of the enclosing scope under the given name (a string literal).
+#define PROFILE_SCOPE(name) \
+    static const int ILMENDUR_PROFILE_CONCAT(profile_marker_, __LINE__) = Profiler::registerMarker(name); \
+    Profiler::ScopedMarker ILMENDUR_PROFILE_CONCAT(profile_scope_, __LINE__)(ILMENDUR_PROFILE_CONCAT(profile_marker_, __LINE__))
+
+/// Like PROFILE_SCOPE(), but for names only known at runtime (a std::string).
+#define PROFILE_SCOPE_DYNAMIC(name) \
+    Profiler::ScopedMarker ILMENDUR_PROFILE_CONCAT(profile_scope_, __LINE__)(Profiler::registerMarker(name))
+
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_SCOPE_DYNAMIC(name) ((void)0)
+#endif /* ENABLE_PROFILER */
+
+#endif /* ILMENDUR_PROFILER_HPP */
@@ -0,0 +1,111 @@
+#include "properties.hpp"
+#include <algorithm>
+
+using namespace std;
+
+Properties::Properties(pmr::memory_resource* p_res)
+    : m_entries(p_res)
+{
+}
+
+/// Inserts the property `key`, or replaces its value if it exists.
+void Properties::set(StringId key, Value&& value)
+{
+    auto iter = lower_bound(m_entries.begin(),
+                            m_entries.end(),
+                            key,
+                            [](const Entry& entry, const StringId& k) { return entry.first < k; });
+
+    if (iter != m_entries.end() && iter->first == key) {
+        iter->second = move(value);
+    } else {
+        m_entries.emplace(iter, key, move(value));
+    }
+}
+
+void Properties::setString(StringId key, string_view value)
+{
+    // Construct the string on this object's memory resource; moving
+    // the variant around keeps it there.
+    set(key, Value(in_place_type<pmr::string>, value, m_entries.get_allocator()));
+}
+
+void Properties::setInt(StringId key, int value)
+{
+    set(key, Value(in_place_type<int>, value));
+}
+
+void Properties::setFloat(StringId key, float value)
+{
+    set(key, Value(in_place_type<float>, value));
+}
+
+void Properties::setBool(StringId key, bool value)
+{
+    set(key, Value(in_place_type<bool>, value));
+}
+
+/// Returns the value of property `key`, or nullptr if it does not exist.
+const Properties::Value* Properties::find(StringId key) const
+{
+    auto iter = lower_bound(m_entries.begin(),
+                            m_entries.end(),
+                            key,
+                            [](const Entry& entry, const StringId& k) { return entry.first < k; });
+
+    if (iter != m_entries.end() && iter->first == key) {
+        return &iter->second;
+    } else {
+        return nullptr;
+    }
+}
+
+/**
+ * The string value of property `key`. The returned view is valid
+ * as long as this object is not modified.
+ */
+string_view Properties::get(StringId key) const
+{
+    const Value* p_value = find(key);
+    if (p_value && holds_alternative<pmr::string>(*p_value)) {
+        return std::get<pmr::string>(*p_value);
+    } else {
+        return string_view();
+    }
+}
+
+/**
+ * The integer value of property `key`. For backwards compatibility
+ * with maps that relied on it, this also returns bool properties
+ * as 0 and 1.
+ */
+int Properties::getInt(StringId key) const
+{
+    const Value* p_value = find(key);
+    if (p_value) {
+        if (const int* p_int = get_if<int>(p_value)) {
+            return *p_int;
+        } else if (const bool* p_bool = get_if<bool>(p_value)) {
+            return *p_bool ? 1 : 0;
+        }
+    }
+    return 0;
+}
+
+float Properties::getFloat(StringId key) const
+{
+    const Value* p_value = find(key);
+    if (p_value && holds_alternative<float>(*p_value)) {
+        return std::get<float>(*p_value);
+    }
+    return 0.0f;
+}
+
+bool Properties::getBool(StringId key) const
+{
+    const Value* p_value = find(key);
+    if (p_value && holds_alternative<bool>(*p_value)) {
+        return std::get<bool>(*p_value);
+    }
+    return false;
+}
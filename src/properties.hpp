@@ -0,0 +1,54 @@
+#ifndef ILMENDUR_PROPERTIES_HPP
+#define ILMENDUR_PROPERTIES_HPP
+#include "string_id.hpp"
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/**
+ * Typed key/value properties of TMX maps, layers, and objects.
+ *
+ * The properties are kept in one small vector sorted by key. Keys
+ * are interned (see StringId); values are a variant of the TMX
+ * property types. Looking up a property does not allocate memory,
+ * neither with a StringId nor with a plain string as the key. The
+ * getters return a zero value if the property does not exist or
+ * has a different type. All memory is allocated from the resource
+ * given on construction.
+ */
+class Properties
+{
+public:
+    typedef std::variant<std::pmr::string, int, float, bool> Value;
+
+    Properties(std::pmr::memory_resource* p_res = std::pmr::get_default_resource());
+
+    void setString(StringId key, std::string_view value);
+    void setInt(StringId key, int value);
+    void setFloat(StringId key, float value);
+    void setBool(StringId key, bool value);
+
+    const Value* find(StringId key) const;
+    std::string_view get(StringId key) const;
+    int getInt(StringId key) const;
+    float getFloat(StringId key) const;
+    bool getBool(StringId key) const;
+
+    inline std::string_view get(std::string_view name) const { return get(StringId::find(name)); }
+    inline int getInt(std::string_view name) const { return getInt(StringId::find(name)); }
+    inline float getFloat(std::string_view name) const { return getFloat(StringId::find(name)); }
+    inline bool getBool(std::string_view name) const { return getBool(StringId::find(name)); }
+
+    inline size_t size() const { return m_entries.size(); }
+private:
+    typedef std::pair<StringId, Value> Entry;
+
+    void set(StringId key, Value&& value);
+
+    std::pmr::vector<Entry> m_entries;
+};
+
+#endif /* ILMENDUR_PROPERTIES_HPP */
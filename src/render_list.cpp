@@ -0,0 +1,321 @@
+#include "render_list.hpp"
+#include "imgui/imgui_impl_sdlrenderer.h"
+#include <cassert>
+#include <cstring>
+#include <cmath>
+
+using namespace std;
+
+/* Copies `src` into `dst` without giving up the memory `dst` already
+ * has, unlike ImVector's assignment operator. */
+template<typename T>
+static void copyImVector(ImVector<T>& dst, const ImVector<T>& src)
+{
+    dst.resize(src.Size);
+    if (src.Size > 0) {
+        memcpy(dst.Data, src.Data, src.Size * sizeof(T));
+    }
+}
+
+RenderList::RenderList()
+{
+}
+
+RenderList::~RenderList()
+{
+    for(ImDrawList* p_list: m_imgui_lists) {
+        IM_DELETE(p_list);
+    }
+}
+
+void RenderList::add(command_type type, const SDL_Rect* p_rect)
+{
+    m_commands.emplace_back();
+    Command& cmd = m_commands.back();
+    cmd.type        = type;
+    cmd.has_rect    = p_rect != nullptr;
+    cmd.has_srcrect = false;
+    cmd.p_texture   = nullptr;
+    if (p_rect) {
+        cmd.rect = *p_rect;
+    }
+}
+
+/// Records SDL_RenderSetViewport().
+void RenderList::setViewport(const SDL_Rect* p_rect)
+{
+    add(command_type::viewport, p_rect);
+}
+
+/// Records SDL_RenderSetClipRect().
+void RenderList::setClipRect(const SDL_Rect* p_rect)
+{
+    add(command_type::cliprect, p_rect);
+}
+
+/// Records SDL_RenderSetScale().
+void RenderList::setScale(float scalex, float scaley)
+{
+    add(command_type::scale, nullptr);
+    m_commands.back().scalex = scalex;
+    m_commands.back().scaley = scaley;
+}
+
+/// Records SDL_SetRenderDrawColor().
+void RenderList::setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a)
+{
+    add(command_type::draw_color, nullptr);
+    m_commands.back().color = SDL_Color{r, g, b, a};
+}
+
+/// Records SDL_SetRenderTarget().
+void RenderList::setTarget(SDL_Texture* p_texture)
+{
+    add(command_type::target, nullptr);
+    m_commands.back().p_texture = p_texture;
+}
+
+/// Records SDL_RenderClear().
+void RenderList::clear()
+{
+    add(command_type::clear, nullptr);
+}
+
+/// Records SDL_RenderFillRect() with the draw color.
+void RenderList::fillRect(const SDL_Rect* p_rect)
+{
+    add(command_type::fill_rect, p_rect);
+}
+
+/// Records SDL_RenderCopy().
+void RenderList::copy(SDL_Texture* p_texture, const SDL_Rect* p_srcrect, const SDL_Rect* p_dstrect)
+{
+    add(command_type::copy, p_dstrect);
+    Command& cmd = m_commands.back();
+    cmd.p_texture = p_texture;
+    if (p_srcrect) {
+        cmd.has_srcrect = true;
+        cmd.srcrect     = *p_srcrect;
+    }
+}
+
+/**
+ * Records ImGui_ImplSDLRenderer_RenderDrawData() for what ImGui::Render()
+ * returned. Only one ImGui frame can be recorded per list.
+ */
+void RenderList::drawImGui(const ImDrawData* p_draw_data)
+{
+    assert(!m_imgui_data.Valid);
+    if (!p_draw_data || !p_draw_data->Valid) {
+        return;
+    }
+
+    while (m_imgui_lists.size() < static_cast<size_t>(p_draw_data->CmdListsCount)) {
+        m_imgui_lists.push_back(IM_NEW(ImDrawList)(nullptr));
+    }
+    for(int i=0; i < p_draw_data->CmdListsCount; i++) {
+        const ImDrawList* p_src = p_draw_data->CmdLists[i];
+        ImDrawList* p_dst = m_imgui_lists[i];
+        copyImVector(p_dst->CmdBuffer, p_src->CmdBuffer);
+        copyImVector(p_dst->IdxBuffer, p_src->IdxBuffer);
+        copyImVector(p_dst->VtxBuffer, p_src->VtxBuffer);
+        p_dst->Flags = p_src->Flags;
+    }
+
+    m_imgui_data = *p_draw_data;
+    m_imgui_data.CmdLists = m_imgui_lists.data();
+    add(command_type::imgui, nullptr);
+}
+
+/// Records SDL_RenderPresent().
+void RenderList::present()
+{
+    add(command_type::present, nullptr);
+}
+
+/**
+ * Records the commands of `list`, moving the destinations of its
+ * copies by (`dx`|`dy`) and leaving out those copies that then do not
+ * intersect `bounds`. This is for replaying something recorded once
+ * for several viewports; see Map::draw().
+ */
+void RenderList::append(const RenderList& list, int dx, int dy, const SDL_Rect& bounds)
+{
+    assert(!list.m_imgui_data.Valid);
+    for(const Command& cmd: list.m_commands) {
+        if (cmd.type == command_type::copy && cmd.has_rect) {
+            SDL_Rect rect = cmd.rect;
+            rect.x += dx;
+            rect.y += dy;
+            if (!SDL_HasIntersection(&rect, &bounds)) {
+                continue;
+            }
+            m_commands.push_back(cmd);
+            m_commands.back().rect = rect;
+        } else {
+            m_commands.push_back(cmd);
+        }
+    }
+}
+
+/**
+ * Compares the recorded commands of this list and `other`, but not
+ * their ImGui draw data.
+ */
+bool RenderList::operator==(const RenderList& other) const
+{
+    if (m_commands.size() != other.m_commands.size()) {
+        return false;
+    }
+
+    for(size_t i=0; i < m_commands.size(); i++) {
+        const Command& a = m_commands[i];
+        const Command& b = other.m_commands[i];
+        if (a.type != b.type || a.has_rect != b.has_rect || a.has_srcrect != b.has_srcrect || a.p_texture != b.p_texture) {
+            return false;
+        }
+        if (a.has_rect && !SDL_RectEquals(&a.rect, &b.rect)) {
+            return false;
+        }
+        if (a.has_srcrect && !SDL_RectEquals(&a.srcrect, &b.srcrect)) {
+            return false;
+        }
+        if (a.type == command_type::draw_color && memcmp(&a.color, &b.color, sizeof(SDL_Color)) != 0) {
+            return false;
+        }
+        if (a.type == command_type::scale && (a.scalex != b.scalex || a.scaley != b.scaley)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The rectangle `rect` in logical coordinates scaled by (`scalex`|`scaley`). */
+static SDL_Rect scaleRect(const SDL_Rect& rect, float scalex, float scaley)
+{
+    int x = lround(rect.x * scalex);
+    int y = lround(rect.y * scaley);
+    return SDL_Rect{x, y, static_cast<int>(lround((rect.x + rect.w) * scalex)) - x, static_cast<int>(lround((rect.y + rect.h) * scaley)) - y};
+}
+
+/**
+ * Counts the copies of this list and the pixels they fill. Pixels
+ * outside the clip rectangle in effect are not counted. Like SDL,
+ * this applies the scale in effect to the clip rectangles and copies,
+ * and resets scale and clip rectangle for target textures, restoring
+ * them when setTarget() switches back to the window.
+ */
+RenderList::Stats RenderList::stats() const
+{
+    Stats result{0, 0};
+    bool has_clip = false;
+    SDL_Rect clip;
+    float scalex = 1.0f;
+    float scaley = 1.0f;
+    bool window_has_clip = false;
+    SDL_Rect window_clip;
+    float window_scalex = 1.0f;
+    float window_scaley = 1.0f;
+    bool on_target = false;
+    for(const Command& cmd: m_commands) {
+        switch (cmd.type) {
+        case command_type::cliprect:
+            has_clip = cmd.has_rect;
+            if (has_clip) {
+                clip = scaleRect(cmd.rect, scalex, scaley);
+            }
+            break;
+        case command_type::scale:
+            scalex = cmd.scalex;
+            scaley = cmd.scaley;
+            break;
+        case command_type::target:
+            if (cmd.p_texture && !on_target) {
+                window_has_clip = has_clip;
+                window_clip     = clip;
+                window_scalex   = scalex;
+                window_scaley   = scaley;
+                has_clip = false;
+                scalex   = 1.0f;
+                scaley   = 1.0f;
+            } else if (!cmd.p_texture && on_target) {
+                has_clip = window_has_clip;
+                clip     = window_clip;
+                scalex   = window_scalex;
+                scaley   = window_scaley;
+            }
+            on_target = cmd.p_texture != nullptr;
+            break;
+        case command_type::copy:
+            result.copies++;
+            // fall-through
+        case command_type::fill_rect:
+            if (cmd.has_rect) { // Copies or fills of the full target are not used by the game
+                SDL_Rect dest = scaleRect(cmd.rect, scalex, scaley);
+                SDL_Rect area = dest;
+                if (!has_clip || SDL_IntersectRect(&dest, &clip, &area)) {
+                    result.pixels += static_cast<uint64_t>(area.w) * area.h;
+                }
+            }
+            break;
+        case command_type::viewport:
+        case command_type::draw_color:
+        case command_type::clear:
+        case command_type::imgui:
+        case command_type::present:
+            break;
+        } // No default to provoke compiler warnings on missing elements
+    }
+    return result;
+}
+
+/**
+ * Empties the list for recording the next frame.
+ */
+void RenderList::reset()
+{
+    m_commands.clear();
+    m_imgui_data.Clear();
+}
+
+/**
+ * Replays the recorded commands on `p_renderer`. Must only be called
+ * on the thread that owns the renderer.
+ */
+void RenderList::execute(SDL_Renderer* p_renderer)
+{
+    for(const Command& cmd: m_commands) {
+        switch (cmd.type) {
+        case command_type::viewport:
+            SDL_RenderSetViewport(p_renderer, cmd.has_rect ? &cmd.rect : nullptr);
+            break;
+        case command_type::cliprect:
+            SDL_RenderSetClipRect(p_renderer, cmd.has_rect ? &cmd.rect : nullptr);
+            break;
+        case command_type::scale:
+            SDL_RenderSetScale(p_renderer, cmd.scalex, cmd.scaley);
+            break;
+        case command_type::draw_color:
+            SDL_SetRenderDrawColor(p_renderer, cmd.color.r, cmd.color.g, cmd.color.b, cmd.color.a);
+            break;
+        case command_type::target:
+            SDL_SetRenderTarget(p_renderer, cmd.p_texture);
+            break;
+        case command_type::clear:
+            SDL_RenderClear(p_renderer);
+            break;
+        case command_type::fill_rect:
+            SDL_RenderFillRect(p_renderer, cmd.has_rect ? &cmd.rect : nullptr);
+            break;
+        case command_type::copy:
+            SDL_RenderCopy(p_renderer, cmd.p_texture, cmd.has_srcrect ? &cmd.srcrect : nullptr, cmd.has_rect ? &cmd.rect : nullptr);
+            break;
+        case command_type::imgui:
+            ImGui_ImplSDLRenderer_RenderDrawData(&m_imgui_data);
+            break;
+        case command_type::present:
+            SDL_RenderPresent(p_renderer);
+            break;
+        } // No default to provoke compiler warnings on missing elements
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef ILMENDUR_RENDER_LIST_HPP
+#define ILMENDUR_RENDER_LIST_HPP
+#include "imgui/imgui.h"
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <vector>
+
+/**
+ * A recorded frame. Drawing code does not talk to the SDL_Renderer,
+ * which is owned by the RenderThread, but records what it would have
+ * done into a RenderList with the functions of the same name; the
+ * RenderThread then replays the list with execute() while the next
+ * frame is simulated.
+ *
+ * A RenderList stores copies of everything it is given except the
+ * textures, so the caller may change or free its rectangles and its
+ * ImGui draw data immediately after recording. The textures must stay
+ * alive until the list has been executed; all of them belong to the
+ * TexturePool, which outlives the RenderThread.
+ */
+class RenderList
+{
+public:
+    RenderList();
+    ~RenderList();
+
+    void setViewport(const SDL_Rect* p_rect);
+    void setClipRect(const SDL_Rect* p_rect);
+    void setScale(float scalex, float scaley);
+    void setDrawColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+    void setTarget(SDL_Texture* p_texture);
+    void clear();
+    void fillRect(const SDL_Rect* p_rect);
+    void copy(SDL_Texture* p_texture, const SDL_Rect* p_srcrect, const SDL_Rect* p_dstrect);
+    void drawImGui(const ImDrawData* p_draw_data);
+    void present();
+    void append(const RenderList& list, int dx, int dy, const SDL_Rect& bounds);
+
+    void reset();
+    void execute(SDL_Renderer* p_renderer);
+
+    inline size_t size() const { return m_commands.size(); }
+    bool operator==(const RenderList& other) const;
+
+    /// What executing a list costs the renderer.
+    struct Stats
+    {
+        size_t copies;   ///< Number of SDL_RenderCopy() calls
+        uint64_t pixels; ///< Destination pixels of the copies and fills within their clip rectangles, after scaling
+    };
+    Stats stats() const;
+private:
+    enum class command_type { viewport, cliprect, scale, draw_color, target, clear, fill_rect, copy, imgui, present };
+
+    struct Command
+    {
+        command_type type;
+        bool has_rect;        ///< False if `rect` stands for a nullptr
+        bool has_srcrect;     ///< False if `srcrect` stands for a nullptr
+        SDL_Color color;
+        float scalex;
+        float scaley;
+        SDL_Rect rect;        ///< viewport/clip rectangle; destination of `copy` and `fill_rect`
+        SDL_Rect srcrect;
+        SDL_Texture* p_texture;
+    };
+
+    RenderList(const RenderList&) = delete;
+    RenderList& operator=(const RenderList&) = delete;
+
+    void add(command_type type, const SDL_Rect* p_rect);
+
+    std::vector<Command> m_commands;
+
+    // ImGui reuses its draw lists for the next frame, so the list
+    // keeps a snapshot of them. The ImDrawList objects are reused.
+    ImDrawData m_imgui_data;
+    std::vector<ImDrawList*> m_imgui_lists;
+};
+
+#endif /* ILMENDUR_RENDER_LIST_HPP */
@@ -0,0 +1,172 @@
+#include "render_thread.hpp"
+#include "profiler.hpp"
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+/**
+ * Starts the render thread, which creates the renderer for `p_window`
+ * with SDL_CreateRenderer() and `renderer_flags`. Throws if that fails.
+ */
+RenderThread::RenderThread(SDL_Window* p_window, Uint32 renderer_flags)
+    : mp_renderer(nullptr),
+      m_record_index(0),
+      mp_pending(nullptr),
+      mp_task(nullptr),
+      m_posted_count(0),
+      m_done_count(0),
+      m_started(false),
+      m_stop(false)
+{
+    m_thread = thread(&RenderThread::threadMain, this, p_window, renderer_flags);
+
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this]{ return m_started; });
+    if (!mp_renderer) {
+        lock.unlock();
+        m_thread.join();
+        throw(runtime_error(string("SDL_CreateRenderer() failed: ") + m_error));
+    }
+}
+
+/**
+ * Finishes the frame in flight, if any, destroys the renderer and
+ * ends the thread. Destroy all textures before.
+ */
+RenderThread::~RenderThread()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeup.notify_one();
+    m_thread.join();
+}
+
+/**
+ * Returns the empty list to record the next frame into.
+ */
+RenderList& RenderThread::beginFrame()
+{
+    RenderList& list = m_lists[m_record_index];
+    list.reset();
+    return list;
+}
+
+/**
+ * Hands the list returned by beginFrame() over to the render thread.
+ * Waits for the previous frame to finish first.
+ */
+void RenderThread::submitFrame()
+{
+    finish();
+
+    {
+        lock_guard<mutex> lock(m_mutex);
+        mp_pending = &m_lists[m_record_index];
+    }
+    m_wakeup.notify_one();
+    m_record_index = 1 - m_record_index;
+}
+
+/**
+ * Waits until the render thread has executed all submitted frames.
+ */
+void RenderThread::finish()
+{
+    PROFILE_SCOPE("Wait for render thread");
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this]{ return !mp_pending; });
+}
+
+/**
+ * Runs `func` with the renderer on the render thread after all
+ * submitted frames and post()ed functions, and waits for it to return.
+ */
+void RenderThread::invoke(const function<void(SDL_Renderer*)>& func)
+{
+    unique_lock<mutex> lock(m_mutex);
+    m_done.wait(lock, [this]{ return !mp_pending && m_done_count == m_posted_count; });
+    assert(!mp_task);
+    mp_task = &func;
+    m_wakeup.notify_one();
+    m_done.wait(lock, [this]{ return !mp_task; });
+}
+
+/**
+ * Queues `func` to run with the renderer on the render thread after
+ * all frames submitted so far, and returns at once. Returns the ticket
+ * to pass to isDone(). Until that returns true, the caller must not
+ * touch what `func` writes to, nor record commands that use it.
+ */
+uint64_t RenderThread::post(function<void(SDL_Renderer*)> func)
+{
+    uint64_t ticket;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_posted.push_back(move(func));
+        ticket = ++m_posted_count;
+    }
+    m_wakeup.notify_one();
+    return ticket;
+}
+
+/**
+ * Whether the function post() returned `ticket` for has run.
+ */
+bool RenderThread::isDone(uint64_t ticket)
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_done_count >= ticket;
+}
+
+void RenderThread::threadMain(SDL_Window* p_window, Uint32 renderer_flags)
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        mp_renderer = SDL_CreateRenderer(p_window, -1, renderer_flags);
+        if (!mp_renderer) {
+            m_error = SDL_GetError();
+        }
+        m_started = true;
+    }
+    m_done.notify_all();
+    if (!mp_renderer) {
+        return;
+    }
+
+    unique_lock<mutex> lock(m_mutex);
+    while (true) {
+        m_wakeup.wait(lock, [this]{ return m_stop || mp_pending || mp_task || !m_posted.empty(); });
+        if (mp_task) {
+            (*mp_task)(mp_renderer);
+            mp_task = nullptr;
+            m_done.notify_all();
+        } else if (mp_pending) {
+            // Execute without the lock, so that the main thread can
+            // go on recording into the other list.
+            RenderList* p_list = mp_pending;
+            lock.unlock();
+            p_list->execute(mp_renderer);
+            lock.lock();
+            mp_pending = nullptr;
+            m_done.notify_all();
+        } else if (!m_posted.empty()) {
+            // Frames submitted before the function was posted have
+            // run, so it may destroy textures they used.
+            function<void(SDL_Renderer*)> func = move(m_posted.front());
+            m_posted.pop_front();
+            lock.unlock();
+            func(mp_renderer);
+            lock.lock();
+            m_done_count++;
+            m_done.notify_all();
+        } else { // m_stop
+            break;
+        }
+    }
+
+    SDL_DestroyRenderer(mp_renderer);
+}
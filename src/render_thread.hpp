@@ -0,0 +1,71 @@
+#ifndef ILMENDUR_RENDER_THREAD_HPP
+#define ILMENDUR_RENDER_THREAD_HPP
+#include "render_list.hpp"
+#include <SDL2/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * The thread that owns the SDL_Renderer. There is one instance of
+ * it, owned by the Ilmendur singleton; see Ilmendur::renderThread().
+ *
+ * Each frame, the main thread records into the RenderList returned
+ * by beginFrame() and hands it over with submitFrame(). The render
+ * thread then executes that list while the main thread already
+ * simulates and records the next frame into the other of the two
+ * lists. submitFrame() only blocks if the render thread has not yet
+ * finished the previous frame, so there is never more than one frame
+ * in flight.
+ *
+ * No other thread may call SDL_Render*() functions or create or
+ * destroy textures. Code that needs to do that (loading textures,
+ * setting up ImGui's renderer backend) passes a function to invoke(),
+ * which runs it on the render thread and waits for it. As that also
+ * waits for the frame in flight, code that runs while a frame is
+ * recorded passes the function to post() instead, which returns at
+ * once, and checks with isDone() whether it has run.
+ */
+class RenderThread
+{
+public:
+    RenderThread(SDL_Window* p_window, Uint32 renderer_flags);
+    ~RenderThread();
+
+    RenderList& beginFrame();
+    void submitFrame();
+    void finish();
+    void invoke(const std::function<void(SDL_Renderer*)>& func);
+    uint64_t post(std::function<void(SDL_Renderer*)> func);
+    bool isDone(uint64_t ticket);
+
+private:
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    void threadMain(SDL_Window* p_window, Uint32 renderer_flags);
+
+    SDL_Renderer* mp_renderer;
+    RenderList m_lists[2];
+    size_t m_record_index; ///< Index into `m_lists` of the list the main thread records into
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup; ///< Signals the render thread new work
+    std::condition_variable m_done;   ///< Signals the main thread finished work
+    RenderList* mp_pending;           ///< Submitted list not yet completely executed
+    const std::function<void(SDL_Renderer*)>* mp_task; ///< invoke()d function not yet completely run
+    std::deque<std::function<void(SDL_Renderer*)>> m_posted; ///< post()ed functions not yet started
+    uint64_t m_posted_count; ///< Number of post()ed functions so far
+    uint64_t m_done_count;   ///< Number of post()ed functions that have completely run
+    bool m_started;
+    bool m_stop;
+    std::string m_error;
+
+    std::thread m_thread;
+};
+
+#endif /* ILMENDUR_RENDER_THREAD_HPP */
@@ -6,6 +6,7 @@
 #include "../actors/hero.hpp"
 #include "../ilmendur.hpp"
 #include "../gui.hpp"
+#include "../profiler.hpp"
 #include <cassert>
 
 using namespace std;
@@ -23,6 +24,8 @@ DebugMapScene::DebugMapScene(const std::string& map)
     mp_cam2->setBounds(mp_map->drawRect());
     mp_cam1->setViewport(Ilmendur::instance().viewportPlayer1());
     mp_cam2->setViewport(Ilmendur::instance().viewportPlayer2());
+    mp_map->setMergeViews(true);
+    mp_map->setCacheViews(true);
 
     if (mp_map->backgroundMusic().empty()) {
         Ilmendur::instance().audioSystem().stopBackgroundMusic();
@@ -57,12 +60,16 @@ void DebugMapScene::setup()
     }
 
     mp_map->heroes(&mp_freya, &mp_benjamin);
+    mp_cam1->setHero(mp_freya);
 }
 
 void DebugMapScene::update()
 {
     // Update all actors
-    mp_map->update();
+    {
+        PROFILE_SCOPE("Map::update");
+        mp_map->update();
+    }
 
     // Centre camera on the hero
     if (mp_freya) {
@@ -71,17 +78,16 @@ void DebugMapScene::update()
     mp_cam2->setPosition(Vector2f(1600, 2600));
 }
 
-void DebugMapScene::draw(SDL_Renderer* p_stage)
+void DebugMapScene::draw(RenderList* p_stage)
+{
+    PROFILE_SCOPE("Map::draw");
+    Camera* cameras[] = {mp_cam1, mp_cam2};
+    mp_map->draw(p_stage, cameras, 2);
+}
+
+bool DebugMapScene::isIdle(uint64_t* p_wakeup) const
 {
-    // Camera 1
-    SDL_Rect camview = mp_cam1->view();
-    mp_cam1->draw(p_stage);
-    mp_map->draw(p_stage, &camview);
-
-    // Camera 2
-    camview = mp_cam2->view();
-    mp_cam2->draw(p_stage);
-    mp_map->draw(p_stage, &camview);
+    return mp_map->isIdle(p_wakeup);
 }
 
 void DebugMapScene::handleKeyDown(const SDL_Event& event)
@@ -16,9 +16,10 @@ public:
 
     virtual void setup();
     virtual void update();
-    virtual void draw(SDL_Renderer* p_renderer);
+    virtual void draw(RenderList* p_renderer);
     virtual void handleKeyDown(const SDL_Event& event);
     virtual void handleKeyUp(const SDL_Event& event);
+    virtual bool isIdle(uint64_t* p_wakeup) const;
 
     Hero* freya() { return mp_freya; }
     Hero* benjamin() { return mp_benjamin; }
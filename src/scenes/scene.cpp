@@ -15,3 +15,11 @@ void Scene::setup()
 {
     m_is_set_up = true;
 }
+
+/**
+ * Scenes are assumed to change every frame unless they say otherwise.
+ */
+bool Scene::isIdle(uint64_t*) const
+{
+    return false;
+}
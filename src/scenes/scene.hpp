@@ -1,7 +1,10 @@
 #ifndef ILMENDUR_SCENE_HPP
 #define ILMENDUR_SCENE_HPP
+#include <cstdint>
 #include <SDL2/SDL.h>
 
+class RenderList;
+
 class Scene
 {
 public:
@@ -10,9 +13,10 @@ public:
 
     virtual void setup(); // Optional code to run once when the scene has been placed on top of the stack for the first time
     virtual void update() = 0; // Update scene actors. Also call ImGui methods here, not in draw().
-    virtual void draw(SDL_Renderer* p_renderer) = 0; // Draw the state as left by update(). ImGui elements created by update() will be drawn on top of this after draw() completes.
+    virtual void draw(RenderList* p_renderer) = 0; // Draw the state as left by update(). ImGui elements created by update() will be drawn on top of this after draw() completes.
     virtual void handleKeyDown(const SDL_Event&) {};
     virtual void handleKeyUp(const SDL_Event&) {};
+    virtual bool isIdle(uint64_t* p_wakeup) const; // True if nothing changes until input arrives or Clock::ticks() reaches *p_wakeup, which may only be lowered. See Ilmendur::waitWhileIdle().
 
     inline bool isSetUp() const { return m_is_set_up; } // True if setup() has been run
 private:
@@ -37,7 +37,7 @@ void TitleScene::update()
         } else {
             static string msg;
             if (msg.empty()) {
-                msg = to_string(m_user_maps.size()) + " map(s) found in " + (OS::userDataDir() / fs::u8path("maps")).u8string() + ":";
+                msg = to_string(m_user_maps.size()) + " map(s) found in " + OS::utf8String(OS::userDataDir() / OS::utf8Path("maps")) + ":";
             }
 
             ImGui::Text(msg.c_str());
@@ -58,7 +58,7 @@ void TitleScene::update()
             if (ImGui::Button("Load map")) {
                 // Not quite efficient way to strip the .tmx suffix,
                 // but this menu entry is for debugging purposes anyway.
-                startGame(fs::u8path(m_user_maps[m_chosen_map]).stem().u8string());
+                startGame(OS::utf8String(OS::utf8Path(m_user_maps[m_chosen_map]).stem()));
             }
         }
     } else {
@@ -75,10 +75,19 @@ void TitleScene::update()
     ImGui::End();
 }
 
-void TitleScene::draw(SDL_Renderer*)
+void TitleScene::draw(RenderList*)
 {
 }
 
+/**
+ * The title menu only consists of ImGui widgets, which only change on
+ * input.
+ */
+bool TitleScene::isIdle(uint64_t*) const
+{
+    return true;
+}
+
 void TitleScene::startGame(const std::string& mapname)
 {
     DebugMapScene* p_testscene = new DebugMapScene(mapname);
@@ -96,18 +105,18 @@ void TitleScene::quitGame()
 
 void TitleScene::readUserMapList()
 {
-    fs::path mapdir = OS::userDataDir() / fs::u8path("maps");
+    fs::path mapdir = OS::userDataDir() / OS::utf8Path("maps");
     if (!fs::exists(mapdir)) {
         fs::create_directories(mapdir);
     }
 
     if (!fs::is_directory(mapdir)) {
-        throw(runtime_error(string(mapdir.u8string()) + " is not a directory"));
+        throw(runtime_error(OS::utf8String(mapdir) + " is not a directory"));
     }
 
     for (const fs::directory_entry& iter: fs::directory_iterator(mapdir)) {
-        if (iter.path().extension() == fs::u8path(".tmx")) {
-            m_user_maps.push_back(iter.path().filename().u8string());
+        if (iter.path().extension() == OS::utf8Path(".tmx")) {
+            m_user_maps.push_back(OS::utf8String(iter.path().filename()));
         }
     }
 
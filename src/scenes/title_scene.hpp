@@ -11,7 +11,8 @@ public:
     virtual ~TitleScene();
 
     virtual void update();
-    virtual void draw(SDL_Renderer* p_renderer);
+    virtual void draw(RenderList* p_renderer);
+    virtual bool isIdle(uint64_t* p_wakeup) const;
 private:
     void readUserMapList();
     void startGame(const std::string& mapname);
@@ -0,0 +1,253 @@
+#include "script.hpp"
+#include "ilmendur.hpp"
+#include "actors/actor.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+using namespace std;
+
+namespace {
+
+    /* A running script. Script IDs combine the slot index (low 32 bits)
+     * with the slot's generation (high 32 bits), which is incremented
+     * whenever the slot is freed, so that the IDs of ended scripts do
+     * not refer to later ones. */
+    struct Slot
+    {
+        Script::handle_type handle; // Null if the slot is free
+        uint32_t generation;
+        const void* p_owner;
+    };
+
+    /* A script suspended on Scripts::Until. */
+    struct PolledWait
+    {
+        uint64_t id;
+        bool (*p_done)(void*);
+        void* p_context;
+    };
+}
+
+static vector<Slot> s_slots;
+static vector<uint32_t> s_free_slots;
+static vector<PolledWait> s_polled;
+static vector<uint64_t> s_ready;     // Scripts to resume in the next update()
+static vector<uint64_t> s_resuming;  // Scratch space of update()
+static uint64_t s_running = 0;       // Script being resumed, 0 if none
+static size_t s_count = 0;
+
+// Returns the slot of the script `id`, or nullptr if that script has ended.
+static Slot* findSlot(uint64_t id)
+{
+    uint32_t index = static_cast<uint32_t>(id);
+    if (index >= s_slots.size() || !s_slots[index].handle || s_slots[index].generation != (id >> 32)) {
+        return nullptr;
+    }
+    return &s_slots[index];
+}
+
+static void freeSlot(uint32_t index)
+{
+    Slot& slot = s_slots[index];
+    slot.handle.destroy();
+    slot.handle  = nullptr;
+    slot.p_owner = nullptr;
+    slot.generation++;
+    s_free_slots.push_back(index);
+    s_count--;
+}
+
+// Resumes the script `id` unless it has ended, and frees it if it ends now.
+static void resume(uint64_t id)
+{
+    Slot* p_slot = findSlot(id);
+    if (!p_slot) {
+        return;
+    }
+
+    // The script may start others, which may reallocate `s_slots`.
+    Script::handle_type handle = p_slot->handle;
+    uint64_t outer = s_running;
+    s_running = id;
+    handle.resume();
+    s_running = outer;
+
+    if (handle.done()) {
+        freeSlot(static_cast<uint32_t>(id));
+    }
+}
+
+static bool alwaysDone(void*)
+{
+    return true;
+}
+
+static bool actorStopped(void* p_actor)
+{
+    return !static_cast<Actor*>(p_actor)->isMoving();
+}
+
+static bool soundEnded(void* p_channel)
+{
+    return !Ilmendur::instance().audioSystem().isPlaying(static_cast<AudioSystem::channel>(reinterpret_cast<intptr_t>(p_channel)));
+}
+
+Script::Script(Script&& other)
+    : m_handle(other.m_handle)
+{
+    other.m_handle = nullptr;
+}
+
+/**
+ * Destroys the coroutine if it was not handed to Scripts::start().
+ */
+Script::~Script()
+{
+    if (m_handle) {
+        m_handle.destroy();
+    }
+}
+
+/**
+ * Hands the coroutine over to the caller, who is responsible for
+ * destroying it from then on.
+ */
+Script::handle_type Script::release()
+{
+    handle_type handle = m_handle;
+    m_handle = nullptr;
+    return handle;
+}
+
+/**
+ * Runs `script` up to its first suspension and schedules it from
+ * then on. Returns the script's ID. If `p_owner` is given, stop()
+ * with the same owner ends the script early; a map passes itself, so
+ * that no script outlives the actors it refers to.
+ */
+uint64_t Scripts::start(Script script, const void* p_owner)
+{
+    uint32_t index;
+    if (s_free_slots.empty()) {
+        index = static_cast<uint32_t>(s_slots.size());
+        s_slots.push_back(Slot{nullptr, 1, nullptr}); // Generation 1, so that no script has ID 0
+    } else {
+        index = s_free_slots.back();
+        s_free_slots.pop_back();
+    }
+
+    Slot& slot   = s_slots[index];
+    slot.handle  = script.release();
+    slot.p_owner = p_owner;
+    uint64_t id  = (static_cast<uint64_t>(slot.generation) << 32) | index;
+    slot.handle.promise().id = id;
+    s_count++;
+
+    resume(id);
+    return id;
+}
+
+/**
+ * Ends all scripts started with `p_owner` wherever they are
+ * suspended, destroying their local variables. Do not call this
+ * from a script that would be ended by it.
+ */
+void Scripts::stop(const void* p_owner)
+{
+    assert(p_owner);
+    for(uint32_t index=0; index < s_slots.size(); index++) {
+        const Slot& slot = s_slots[index];
+        if (!slot.handle || slot.p_owner != p_owner) {
+            continue;
+        }
+
+        uint64_t id = (static_cast<uint64_t>(slot.generation) << 32) | index;
+        assert(id != s_running);
+        s_polled.erase(remove_if(s_polled.begin(), s_polled.end(), [id](const PolledWait& wait) { return wait.id == id; }), s_polled.end());
+        freeSlot(index); // IDs in `s_ready` become stale by the new generation
+    }
+}
+
+/**
+ * Resumes all scripts that wait for something that has happened.
+ * Call this once per frame from the main loop, after Timer::updateAll();
+ * do not call it from any scene.
+ */
+void Scripts::update()
+{
+    size_t waiting = 0;
+    for(size_t i=0; i < s_polled.size(); i++) {
+        if (s_polled[i].p_done(s_polled[i].p_context)) {
+            s_ready.push_back(s_polled[i].id);
+        } else {
+            s_polled[waiting++] = s_polled[i];
+        }
+    }
+    s_polled.resize(waiting);
+
+    // Scripts that suspend again now are resumed in the next frame
+    // at the earliest.
+    s_resuming.swap(s_ready);
+    for(uint64_t id: s_resuming) {
+        resume(id);
+    }
+    s_resuming.clear();
+}
+
+/**
+ * Returns true if no script needs to be resumed before input arrives
+ * or a Timer is due; see Ilmendur::waitWhileIdle().
+ */
+bool Scripts::isIdle()
+{
+    return s_ready.empty() && s_polled.empty();
+}
+
+/// Number of scripts started and not yet ended.
+size_t Scripts::count()
+{
+    return s_count;
+}
+
+void Scripts::Sleep::await_suspend(Script::handle_type handle)
+{
+    uint64_t id = handle.promise().id;
+    m_timer.emplace(static_cast<float>(m_ms), false, [id]{ s_ready.push_back(id); });
+}
+
+void Scripts::Until::await_suspend(Script::handle_type handle)
+{
+    s_polled.push_back(PolledWait{handle.promise().id, mp_done, mp_context});
+}
+
+void Scripts::NextFrame::await_suspend(Script::handle_type handle)
+{
+    s_polled.push_back(PolledWait{handle.promise().id, alwaysDone, nullptr});
+}
+
+void Scripts::Dialog::await_suspend(Script::handle_type handle)
+{
+    uint64_t id = handle.promise().id;
+    GUISystem::messageDialog(m_herono, m_vel, move(m_charname), move(m_texts), [id]{ s_ready.push_back(id); });
+}
+
+/// Suspends until `p_actor` stops moving, however it started to.
+Scripts::Until Scripts::movement(Actor* p_actor)
+{
+    return Until(actorStopped, p_actor);
+}
+
+/// Moves `p_actor` like Actor::moveTo() and suspends until it arrives.
+Scripts::Until Scripts::moveTo(Actor* p_actor, const Vector2f& targetpos, float velocity)
+{
+    p_actor->moveTo(targetpos, velocity);
+    return Until(actorStopped, p_actor);
+}
+
+/// Plays a sound like AudioSystem::playSound() and suspends until it has ended.
+Scripts::Until Scripts::sound(StringId sound, AudioSystem::channel chan)
+{
+    AudioSystem::channel played = Ilmendur::instance().audioSystem().playSound(sound, chan);
+    return Until(soundEnded, reinterpret_cast<void*>(static_cast<intptr_t>(played)));
+}
@@ -0,0 +1,134 @@
+#ifndef ILMENDUR_SCRIPT_HPP
+#define ILMENDUR_SCRIPT_HPP
+#include "gui.hpp"
+#include "audio.hpp"
+#include "timer.hpp"
+#include "util.hpp"
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Actor;
+
+/**
+ * A script is a coroutine returning Script, like
+ *
+ *     Script walkAround(NonPlayableCharacter* p_npc)
+ *     {
+ *         co_await Scripts::dialog(1, GUISystem::text_velocity::normal, "Guard", "Halt!");
+ *         co_await Scripts::moveTo(p_npc, target, 64.0f);
+ *         co_await Scripts::sleep(500);
+ *     }
+ *
+ * Calling the function only creates the script; pass the result to
+ * Scripts::start() to run it. Each co_await of one of the awaitables
+ * in the Scripts namespace suspends the script until the awaited thing
+ * has happened, without blocking the frame. Scripts are resumed from
+ * the main loop in the main thread only. The coroutine frame is
+ * allocated once per script; suspending does not allocate.
+ *
+ * GCC 12 fails on braced initialiser lists within a co_await
+ * expression ("array used as initializer"), so put several dialog
+ * texts into a local std::vector first.
+ */
+class Script
+{
+public:
+    struct promise_type
+    {
+        uint64_t id = 0; ///< Assigned by Scripts::start()
+
+        Script get_return_object() { return Script(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { throw; }
+    };
+    typedef std::coroutine_handle<promise_type> handle_type;
+
+    Script(Script&& other);
+    ~Script();
+    Script(const Script&) = delete;
+    Script& operator=(const Script&) = delete;
+
+    handle_type release();
+private:
+    explicit Script(handle_type handle) : m_handle(handle) {}
+    handle_type m_handle;
+};
+
+/**
+ * The scheduler of all running scripts, and the awaitables scripts
+ * can co_await. See Script.
+ */
+namespace Scripts {
+    uint64_t start(Script script, const void* p_owner = nullptr);
+    void stop(const void* p_owner);
+    void update();
+    bool isIdle();
+    size_t count();
+
+    /// Suspends until `ms` milliseconds have passed on Clock::ticks().
+    class Sleep
+    {
+    public:
+        Sleep(uint64_t ms) : m_ms(ms) {}
+        bool await_ready() const noexcept { return m_ms == 0; }
+        void await_suspend(Script::handle_type handle);
+        void await_resume() const noexcept {}
+    private:
+        uint64_t m_ms;
+        std::optional<Timer> m_timer;
+    };
+
+    /// Suspends until `p_done(p_context)` returns true, checked once per frame.
+    class Until
+    {
+    public:
+        Until(bool (*p_done)(void*), void* p_context) : mp_done(p_done), mp_context(p_context) {}
+        bool await_ready() const { return mp_done(mp_context); }
+        void await_suspend(Script::handle_type handle);
+        void await_resume() const noexcept {}
+    private:
+        bool (*mp_done)(void*);
+        void* mp_context;
+    };
+
+    /// Suspends until the next call to update().
+    class NextFrame
+    {
+    public:
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Script::handle_type handle);
+        void await_resume() const noexcept {}
+    };
+
+    /// Suspends until the message dialog shown on suspension has been clicked through.
+    class Dialog
+    {
+    public:
+        Dialog(unsigned int herono, GUISystem::text_velocity vel, std::string charname, std::vector<std::string> texts)
+            : m_herono(herono), m_vel(vel), m_charname(std::move(charname)), m_texts(std::move(texts)) {}
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(Script::handle_type handle);
+        void await_resume() const noexcept {}
+    private:
+        unsigned int m_herono;
+        GUISystem::text_velocity m_vel;
+        std::string m_charname;
+        std::vector<std::string> m_texts;
+    };
+
+    inline Sleep sleep(uint64_t ms) { return Sleep(ms); }
+    inline Until until(bool (*p_done)(void*), void* p_context) { return Until(p_done, p_context); }
+    inline NextFrame nextFrame() { return NextFrame(); }
+    Until movement(Actor* p_actor);
+    Until moveTo(Actor* p_actor, const Vector2f& targetpos, float velocity);
+    Until sound(StringId sound, AudioSystem::channel chan);
+    inline Dialog dialog(unsigned int herono, GUISystem::text_velocity vel, std::string charname, std::vector<std::string> texts) { return Dialog(herono, vel, std::move(charname), std::move(texts)); }
+    inline Dialog dialog(unsigned int herono, GUISystem::text_velocity vel, std::string charname, std::string text) { return Dialog(herono, vel, std::move(charname), std::vector<std::string>(1, std::move(text))); }
+}
+
+#endif /* ILMENDUR_SCRIPT_HPP */
@@ -0,0 +1,51 @@
+#include "simd.hpp"
+#include <SDL2/SDL.h>
+
+using namespace std;
+
+/**
+ * Returns the highest level the CPU supports. The CPU is queried
+ * only once.
+ */
+SIMD::level SIMD::bestLevel()
+{
+    static const level s_best = isSupported(level::avx2) ? level::avx2 : (isSupported(level::sse2) ? level::sse2 : level::scalar);
+    return s_best;
+}
+
+/// Checks whether kernels for `l` are compiled in and supported by the CPU.
+bool SIMD::isSupported(level l)
+{
+    switch (l) {
+    case level::scalar:
+        return true;
+    case level::sse2:
+#ifdef ILMENDUR_SIMD_X86
+        return SDL_HasSSE2();
+#else
+        return false;
+#endif
+    case level::avx2:
+#ifdef ILMENDUR_SIMD_X86
+        return SDL_HasAVX2();
+#else
+        return false;
+#endif
+    } // No default to provoke compiler warnings on missing elements
+
+    return false;
+}
+
+const char* SIMD::levelName(level l)
+{
+    switch (l) {
+    case level::scalar:
+        return "scalar";
+    case level::sse2:
+        return "sse2";
+    case level::avx2:
+        return "avx2";
+    } // No default to provoke compiler warnings on missing elements
+
+    return "";
+}
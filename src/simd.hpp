@@ -0,0 +1,25 @@
+#ifndef ILMENDUR_SIMD_HPP
+#define ILMENDUR_SIMD_HPP
+
+// SIMD kernels are compiled with per-function target attributes so
+// that the rest of the game does not require SSE2/AVX2 support from
+// the CPU. Which kernel is used is decided at runtime.
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ILMENDUR_SIMD_X86 1
+#endif
+
+/**
+ * Runtime CPU feature detection for the modules with SIMD kernels
+ * (see Integrator and AABB). Each such module has one kernel per
+ * level and dispatches on bestLevel().
+ */
+namespace SIMD {
+
+    enum class level { scalar, sse2, avx2 };
+
+    level bestLevel();
+    bool isSupported(level l);
+    const char* levelName(level l);
+}
+
+#endif /* ILMENDUR_SIMD_HPP */
@@ -0,0 +1,105 @@
+#include "string_id.hpp"
+#include <cassert>
+#include <deque>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace {
+
+    /* The string table. A deque does not move its elements when
+     * it grows. The index maps the FNV-1a hashes of the strings to
+     * their IDs. Function-local static, because StringIds are used
+     * in the initialisers of static variables in other files. */
+    struct StringTable
+    {
+        StringTable()
+        {
+            strings.emplace_back();
+            index.emplace(fnv1a(string_view()), 0);
+        }
+
+        deque<string> strings;
+        unordered_map<uint32_t, uint32_t> index;
+    };
+
+    StringTable& stringTable()
+    {
+        static StringTable s_table;
+        return s_table;
+    }
+
+    /* Looks up the hash of `hstr` in the index. Returns `fallback` if
+     * no string with that hash is interned. The string found may still
+     * differ from `hstr` if the hashes collide. */
+    uint32_t lookup(const StringTable& table, const HashedString& hstr, uint32_t fallback)
+    {
+        auto iter = table.index.find(hstr.hash);
+        if (iter == table.index.end()) {
+            return fallback;
+        }
+
+        return iter->second;
+    }
+
+    uint32_t intern(const HashedString& hstr)
+    {
+        StringTable& table = stringTable();
+
+        uint32_t id = lookup(table, hstr, UINT32_MAX);
+        if (id == UINT32_MAX) {
+            id = static_cast<uint32_t>(table.strings.size());
+            table.strings.emplace_back(hstr.str);
+            table.index.emplace(hstr.hash, id);
+        } else if (table.strings[id] != hstr.str) {
+            throw(runtime_error("StringId hash collision between `" + table.strings[id] + "' and `" + string(hstr.str) + "'!"));
+        }
+
+        return id;
+    }
+
+}
+
+/// Interns `str` if it was not interned yet.
+StringId::StringId(string_view str)
+    : m_id(intern(HashedString(str)))
+{
+}
+
+/// Interns `hstr` if it was not interned yet.
+StringId::StringId(const HashedString& hstr)
+    : m_id(intern(hstr))
+{
+}
+
+/**
+ * Returns the StringId of `str` without interning it and without
+ * allocating memory. If `str` was never interned, the returned
+ * StringId is invalid; it compares unequal to all valid ones. This
+ * includes strings whose hash collides with an interned string.
+ */
+StringId StringId::find(string_view str)
+{
+    return find(HashedString(str));
+}
+
+/// Like find(std::string_view), but with a precomputed hash.
+StringId StringId::find(const HashedString& hstr)
+{
+    const StringTable& table = stringTable();
+
+    StringId result;
+    result.m_id = lookup(table, hstr, INVALID);
+    if (result.m_id != INVALID && table.strings[result.m_id] != hstr.str) {
+        result.m_id = INVALID;
+    }
+    return result;
+}
+
+/// The interned string. Must not be called on invalid StringIds.
+const string& StringId::str() const
+{
+    assert(isValid());
+    return stringTable().strings[m_id];
+}
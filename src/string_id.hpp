@@ -0,0 +1,85 @@
+#ifndef ILMENDUR_STRING_ID_HPP
+#define ILMENDUR_STRING_ID_HPP
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// 32-bit FNV-1a hash of `str`. Usable at compile time.
+constexpr uint32_t fnv1a(std::string_view str)
+{
+    uint32_t hash = 2166136261u;
+    for(char c: str) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * A string together with its hash as computed by fnv1a(). Create
+ * these from literals with the `_hs` suffix, which hashes at compile
+ * time; see StringId.
+ */
+struct HashedString
+{
+    constexpr HashedString(std::string_view s) : str(s), hash(fnv1a(s)) {}
+
+    std::string_view str;
+    uint32_t hash;
+};
+
+constexpr HashedString operator""_hs(const char* str, size_t len)
+{
+    return HashedString(std::string_view(str, len));
+}
+
+/**
+ * Interned string. Equal strings are represented by the same small
+ * integer, so that StringIds are compared and ordered by integer
+ * comparison. The strings themselves are kept in a global table
+ * for the rest of the program run. Only intern strings from a
+ * bounded set, like TMX property names, not arbitrary user text.
+ *
+ * The ordering of StringIds is the order in which the strings were
+ * interned first, not the lexical order of the strings. As StringIds
+ * are small and dense, they can be used as indices into arrays; that
+ * is how TexturePool and AudioSystem look up their assets.
+ *
+ * The table is indexed by the FNV-1a hash of the strings; for
+ * literals, the `_hs` suffix has the compiler compute the hash. To
+ * refer to an asset by a literal name, resolve it once into a
+ * function-local static after the assets have been loaded:
+ *
+ *     static const StringId s_sound = StringId::find("ui/talkfin1.ogg"_hs);
+ *     playSound(s_sound, ...);
+ *
+ * From then on, only an array index remains. As find() does not
+ * intern, a misspelt name yields an invalid StringId, which the
+ * asset lookups reject. Interning two different strings with the
+ * same hash is an error; find() reports such a string as not found.
+ */
+class StringId
+{
+public:
+    /// The empty string.
+    StringId() : m_id(0) {}
+    explicit StringId(std::string_view str);
+    explicit StringId(const HashedString& hstr);
+
+    static StringId find(std::string_view str);
+    static StringId find(const HashedString& hstr);
+
+    const std::string& str() const;
+    inline uint32_t value() const { return m_id; }
+    inline bool isValid() const { return m_id != INVALID; }
+
+    inline bool operator==(const StringId& other) const { return m_id == other.m_id; }
+    inline bool operator!=(const StringId& other) const { return m_id != other.m_id; }
+    inline bool operator<(const StringId& other) const { return m_id < other.m_id; }
+private:
+    static const uint32_t INVALID = UINT32_MAX;
+
+    uint32_t m_id;
+};
+
+#endif /* ILMENDUR_STRING_ID_HPP */
@@ -1,8 +1,11 @@
 #include "texture_pool.hpp"
 #include "ilmendur.hpp"
+#include "render_thread.hpp"
 #include "os.hpp"
 #include "util.hpp"
 #include "ini.h"
+#include "profiler.hpp"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <fstream>
@@ -104,60 +107,106 @@ static void parseIni(TextureInfo* p_texinfo, const fs::path& inipath)
 }
 
 TexturePool::TexturePool()
+    : m_can_downscale(false)
 {
-    int result = 0;
-    for (const fs::directory_entry& iter: fs::directory_iterator(OS::gameDataDir() / fs::u8path("tilesets"))) {
-        if (iter.path().extension() == fs::u8path(".png")) {
+    PROFILE_SCOPE("TexturePool::TexturePool");
+    Ilmendur::instance().renderThread().invoke([this](SDL_Renderer* p_renderer){
+        m_can_downscale = SDL_RenderTargetSupported(p_renderer);
+    });
+
+    for (const fs::directory_entry& iter: fs::directory_iterator(OS::gameDataDir() / OS::utf8Path("tilesets"))) {
+        if (iter.path().extension() == OS::utf8Path(".png")) {
+            PROFILE_SCOPE_DYNAMIC("Load texture " + OS::utf8String(iter.path().filename()));
             ifstream file(iter.path(), ifstream::in | ifstream::binary);
             string binary(READ_FILE(file));
             assert(binary.size() > 1);
 
             TextureInfo* p_texinfo = new TextureInfo;
-            p_texinfo->name = string("tilesets/") + iter.path().filename().u8string();
-            p_texinfo->p_texture = IMG_LoadTexture_RW(Ilmendur::instance().sdlRenderer(), SDL_RWFromMem(binary.data(), binary.size()), 1);
-            assert(p_texinfo->p_texture);
-
-            result = SDL_QueryTexture(p_texinfo->p_texture, nullptr, nullptr, &p_texinfo->width, &p_texinfo->height);
-            assert(result == 0);
-            assert(p_texinfo->width > 0 && p_texinfo->height > 0);
+            p_texinfo->name = string("tilesets/") + OS::utf8String(iter.path().filename());
+            loadTexture(p_texinfo, binary);
+            if (m_can_downscale) {
+                downscale(p_texinfo);
+            }
 
-            m_textures[p_texinfo->name] = p_texinfo;
+            add(p_texinfo);
         }
     }
 
-    for (const fs::directory_entry& iter: fs::recursive_directory_iterator(OS::gameDataDir() / fs::u8path("gfx"))) {
-        if (iter.path().extension() == fs::u8path(".png")) {
+    for (const fs::directory_entry& iter: fs::recursive_directory_iterator(OS::gameDataDir() / OS::utf8Path("gfx"))) {
+        if (iter.path().extension() == OS::utf8Path(".png")) {
+            PROFILE_SCOPE_DYNAMIC("Load texture " + OS::utf8String(iter.path().filename()));
             ifstream file(iter.path(), ifstream::in | ifstream::binary);
             string binary(READ_FILE(file));
             assert(binary.size() > 1);
 
             TextureInfo* p_texinfo = new TextureInfo;
-            p_texinfo->name = fs::relative(iter.path(), OS::gameDataDir() / fs::u8path("gfx")).u8string();
-            p_texinfo->p_texture = IMG_LoadTexture_RW(Ilmendur::instance().sdlRenderer(), SDL_RWFromMem(binary.data(), binary.size()), 1);
-            assert(p_texinfo->p_texture);
+            p_texinfo->name = OS::utf8String(fs::relative(iter.path(), OS::gameDataDir() / OS::utf8Path("gfx")));
+            loadTexture(p_texinfo, binary);
 
-            result = SDL_QueryTexture(p_texinfo->p_texture, nullptr, nullptr, &p_texinfo->width, &p_texinfo->height);
-            assert(result == 0);
-            assert(p_texinfo->width > 0 && p_texinfo->height > 0);
-
-            fs::path ini_path = iter.path().parent_path() / fs::u8path(iter.path().stem().u8string() + ".ini");
+            fs::path ini_path = iter.path().parent_path() / OS::utf8Path(OS::utf8String(iter.path().stem()) + ".ini");
             if (fs::exists(ini_path)) {
                 parseIni(p_texinfo, ini_path);
             }
 
-            m_textures[p_texinfo->name] = p_texinfo;
+            add(p_texinfo);
         }
     }
 }
 
 TexturePool::~TexturePool()
 {
-    for(auto iter=m_textures.begin(); iter != m_textures.end(); iter++) {
-        if (iter->second->p_texture) {
-            SDL_DestroyTexture(iter->second->p_texture);
+    Ilmendur::instance().renderThread().invoke([this](SDL_Renderer*){
+        for(TextureInfo* p_texinfo: m_textures) {
+            if (p_texinfo && p_texinfo->p_texture) {
+                SDL_DestroyTexture(p_texinfo->p_texture);
+            }
+            for(int i=0; p_texinfo && i < TextureInfo::DOWNSCALE_LEVELS; i++) {
+                if (p_texinfo->p_downscaled[i]) {
+                    SDL_DestroyTexture(p_texinfo->p_downscaled[i]);
+                }
+            }
         }
-        delete iter->second;
+    });
+
+    for(TextureInfo* p_texinfo: m_textures) {
+        delete p_texinfo;
+    }
+}
+
+/**
+ * Decodes the PNG file contents `binary` on the calling thread and
+ * uploads the result into `p_texinfo`'s texture on the render thread,
+ * which owns the renderer. Sets the width and height of `p_texinfo`.
+ */
+void TexturePool::loadTexture(TextureInfo* p_texinfo, const string& binary)
+{
+    SDL_Surface* p_surface = IMG_Load_RW(SDL_RWFromConstMem(binary.data(), binary.size()), 1);
+    assert(p_surface);
+
+    Ilmendur::instance().renderThread().invoke([&](SDL_Renderer* p_renderer){
+        p_texinfo->p_texture = SDL_CreateTextureFromSurface(p_renderer, p_surface);
+    });
+    assert(p_texinfo->p_texture);
+    for(int i=0; i < TextureInfo::DOWNSCALE_LEVELS; i++) {
+        p_texinfo->p_downscaled[i] = nullptr;
     }
+
+    p_texinfo->width  = p_surface->w;
+    p_texinfo->height = p_surface->h;
+    assert(p_texinfo->width > 0 && p_texinfo->height > 0);
+
+    SDL_FreeSurface(p_surface);
+}
+
+void TexturePool::add(TextureInfo* p_texinfo)
+{
+    p_texinfo->id = StringId(p_texinfo->name);
+    if (p_texinfo->id.value() >= m_textures.size()) {
+        m_textures.resize(p_texinfo->id.value() + 1, nullptr);
+    }
+
+    assert(!m_textures[p_texinfo->id.value()]);
+    m_textures[p_texinfo->id.value()] = p_texinfo;
 }
 
 /**
@@ -169,11 +218,85 @@ TexturePool::~TexturePool()
  * - Any other string, which is treated as a filename relative to the
  *   `gfx/` directory.
  *
- * The method returns an instance of TextureInfo. Access its `p_texture`
- * member to gain access to the actual SDL texture. The returned pointer
- * must not be freed; it is owned by TexturePool.
+ * The method returns an instance of TextureInfo, or nullptr if there is
+ * no such texture. Access its `p_texture` member to gain access to the
+ * actual SDL texture. The returned pointer must not be freed; it is
+ * owned by TexturePool.
+ */
+TextureInfo* TexturePool::operator[](StringId id)
+{
+    if (id.isValid() && id.value() < m_textures.size()) {
+        return m_textures[id.value()];
+    } else {
+        return nullptr;
+    }
+}
+
+/**
+ * Like the other [] operator, but looks up the StringId of `name`
+ * first. Does not intern `name`.
  */
 TextureInfo* TexturePool::operator[](const std::string& name)
 {
-    return m_textures[name];
+    return (*this)[StringId::find(name)];
+}
+
+/**
+ * Returns the texture of `p_texinfo` scaled down by 2^`level`, which
+ * must be between 0 (the texture itself) and DOWNSCALE_LEVELS. Only
+ * tileset textures have downscaled copies; drawing from them at 1/2
+ * or 1/4 zoom samples one texel per pixel instead of skipping most of
+ * the original. Requires canDownscale().
+ */
+SDL_Texture* TexturePool::downscaled(TextureInfo* p_texinfo, int level)
+{
+    assert(level >= 0 && level <= TextureInfo::DOWNSCALE_LEVELS);
+    if (level == 0) {
+        return p_texinfo->p_texture;
+    }
+
+    assert(m_can_downscale);
+    assert(p_texinfo->p_downscaled[level - 1]);
+    return p_texinfo->p_downscaled[level - 1];
+}
+
+/**
+ * Creates the downscaled copies of `p_texinfo`'s texture; see
+ * downscaled(). The copies are filtered linearly. This happens while
+ * the pool is constructed, because creating textures later would
+ * make the main thread wait for the frame in flight.
+ */
+void TexturePool::downscale(TextureInfo* p_texinfo)
+{
+    assert(m_can_downscale);
+    PROFILE_SCOPE_DYNAMIC("Downscale texture " + p_texinfo->name);
+    string error; // SDL_GetError() is per thread
+    Ilmendur::instance().renderThread().invoke([&](SDL_Renderer* p_renderer){
+        for(int level=1; level <= TextureInfo::DOWNSCALE_LEVELS; level++) {
+            SDL_Texture*& p_result = p_texinfo->p_downscaled[level - 1];
+            p_result = SDL_CreateTexture(p_renderer,
+                                         SDL_PIXELFORMAT_ARGB8888,
+                                         SDL_TEXTUREACCESS_TARGET,
+                                         max(p_texinfo->width >> level, 1),
+                                         max(p_texinfo->height >> level, 1));
+            if (!p_result) {
+                error = SDL_GetError();
+                return;
+            }
+
+            // Copy the alpha channel as is instead of blending it onto
+            // the cleared target
+            SDL_SetTextureBlendMode(p_result, SDL_BLENDMODE_BLEND);
+            SDL_SetTextureBlendMode(p_texinfo->p_texture, SDL_BLENDMODE_NONE);
+            SDL_SetTextureScaleMode(p_texinfo->p_texture, SDL_ScaleModeLinear);
+            SDL_SetRenderTarget(p_renderer, p_result);
+            SDL_RenderCopy(p_renderer, p_texinfo->p_texture, nullptr, nullptr);
+            SDL_SetRenderTarget(p_renderer, nullptr);
+            SDL_SetTextureScaleMode(p_texinfo->p_texture, SDL_ScaleModeNearest);
+            SDL_SetTextureBlendMode(p_texinfo->p_texture, SDL_BLENDMODE_BLEND);
+        }
+    });
+    if (!error.empty()) {
+        throw(runtime_error(string("Failed to downscale texture '") + p_texinfo->name + "': " + error));
+    }
 }
@@ -1,7 +1,8 @@
 #ifndef ILMENDUR_TEXTURE_POOL_HPP
 #define ILMENDUR_TEXTURE_POOL_HPP
+#include "string_id.hpp"
 #include <string>
-#include <map>
+#include <vector>
 #include <SDL2/SDL.h>
 
 /**
@@ -13,8 +14,13 @@
  */
 struct TextureInfo
 {
+    /// Number of downscaled copies of a texture; see TexturePool::downscaled().
+    static const int DOWNSCALE_LEVELS = 2;
+
     SDL_Texture* p_texture; ///< Underlying SDL texture
+    SDL_Texture* p_downscaled[DOWNSCALE_LEVELS]; ///< `p_texture` at 1/2, 1/4 size; only set for tilesets
     std::string name;       ///< Name of this texture in the texture pool
+    StringId id;            ///< Interned `name`, the handle of this texture
     int width;              ///< Width in pixels
     int height;             ///< Height in pixels
     int frames;             ///< For animated graphics: number of frames (1 otherwise)
@@ -39,6 +45,9 @@ struct TextureInfo
  * textures, along with the metadata stored in the corresponding
  * INI files, is available through the [] operator.
  *
+ * Textures are identified by the StringId of their name; looking up
+ * a texture by StringId is an array access. Resolve literal texture
+ * names once with StringId::find(); see StringId.
  */
 class TexturePool
 {
@@ -46,9 +55,19 @@ public:
     TexturePool();
     ~TexturePool();
 
+    TextureInfo* operator[](StringId id);
     TextureInfo* operator[](const std::string& name);
+
+    SDL_Texture* downscaled(TextureInfo* p_texinfo, int level);
+    /// Whether downscaled() works with the renderer in use.
+    inline bool canDownscale() const { return m_can_downscale; }
 private:
-    std::map<std::string,TextureInfo*> m_textures;
+    void loadTexture(TextureInfo* p_texinfo, const std::string& binary);
+    void downscale(TextureInfo* p_texinfo);
+    void add(TextureInfo* p_texinfo);
+
+    std::vector<TextureInfo*> m_textures; ///< Indexed by StringId value; nullptr if there is no such texture
+    bool m_can_downscale;
 };
 
 #endif /* ILMENDUR_TEXTURE_POOL_HPP */
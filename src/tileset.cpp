@@ -3,6 +3,7 @@
 #include "os.hpp"
 #include "texture_pool.hpp"
 #include "util.hpp"
+#include "profiler.hpp"
 #include <fstream>
 #include <utility>
 #include <cassert>
@@ -17,9 +18,12 @@ namespace fs = std::filesystem;
 Tileset::Tileset(const fs::path& filename)
     : m_columns(0),
       m_tilecount(0),
+      mp_texinfo(nullptr),
       mp_texid(nullptr)
 {
-    fs::path abs_path(OS::gameDataDir() / fs::u8path("tilesets") / filename);
+    PROFILE_SCOPE_DYNAMIC("Tileset::Tileset " + OS::utf8String(filename));
+
+    fs::path abs_path(OS::gameDataDir() / OS::utf8Path("tilesets") / filename);
     ifstream file(abs_path);
     assert(fs::exists(abs_path));
 
@@ -49,8 +53,29 @@ Tileset::Tileset(const fs::path& filename)
     assert(TILEWIDTH == doc.child("tileset").attribute("tileheight").as_int());
     file.close();
 
+    for (const pugi::xml_node& tile: doc.child("tileset").children("tile")) {
+        TileAnimation anim;
+        anim.lid            = tile.attribute("id").as_int();
+        anim.total_duration = 0;
+        for (const pugi::xml_node& frame: tile.child("animation").children("frame")) {
+            TileAnimation::Frame f;
+            f.lid      = frame.attribute("tileid").as_int();
+            f.duration = frame.attribute("duration").as_int();
+            if (anim.lid < 0 || anim.lid >= m_tilecount || f.lid < 0 || f.lid >= m_tilecount || f.duration <= 0) {
+                throw(std::runtime_error(string("Invalid animation frame for tile ") + to_string(anim.lid) + " in tileset '" + m_name + "'"));
+            }
+            anim.frames.push_back(f);
+            anim.total_duration += f.duration;
+        }
+        if (!anim.frames.empty()) {
+            m_animations.push_back(move(anim));
+        }
+    }
+
     string imgpath = string("tilesets/") + doc.child("tileset").child("image").attribute("source").value();
-    mp_texid = Ilmendur::instance().texturePool()[imgpath]->p_texture;
+    mp_texinfo = Ilmendur::instance().texturePool()[imgpath];
+    assert(mp_texinfo);
+    mp_texid = mp_texinfo->p_texture;
     assert(mp_texid);
 }
 
@@ -59,25 +84,53 @@ Tileset::~Tileset()
     // mp_texid is owned by the texture pool and destroyed there
 }
 
+/**
+ * The level of the tileset texture to draw from when the camera zooms
+ * by `zoom`; see sdlTexture(). Below 1/2 and 1/4 zoom, the texture
+ * scaled down by that much is used, so that the renderer scales the
+ * tiles by at most a factor of two down.
+ */
+int Tileset::atlasLevel(float zoom)
+{
+    if (!Ilmendur::instance().texturePool().canDownscale()) {
+        return 0;
+    }
+
+    int level = 0;
+    while (level < TextureInfo::DOWNSCALE_LEVELS && zoom <= 0.5f) {
+        zoom *= 2.0f;
+        level++;
+    }
+    return level;
+}
+
 /**
  * Fills an SDL_Rect with the region describing the tileset texture
- * that corresponds to the Tiled local tile ID `lid`.
+ * of level `level` (see sdlTexture()) that corresponds to the Tiled
+ * local tile ID `lid`.
  */
-void Tileset::readTile(SDL_Rect& rect, int lid) const
+void Tileset::readTile(SDL_Rect& rect, int lid, int level) const
 {
     assert(lid < m_tilecount);
-    rect.x = lid % m_columns * TILEWIDTH;
-    rect.y = lid / m_columns * TILEWIDTH;
-    rect.w = TILEWIDTH;
-    rect.h = TILEWIDTH;
+    const int width = TILEWIDTH >> level;
+    rect.x = lid % m_columns * width;
+    rect.y = lid / m_columns * width;
+    rect.w = width;
+    rect.h = width;
 }
 
 /**
- * Retrieves the SDL_Texture corresponding to this tileset.
+ * Retrieves the SDL_Texture corresponding to this tileset, scaled
+ * down by 2^`level`; see atlasLevel(). Scaled textures are created by
+ * the texture pool when it loads the tileset.
  * Do not delete or modify this pointer; the memory is owned
- * by this class.
+ * by the texture pool.
  */
-SDL_Texture* Tileset::sdlTexture()
+SDL_Texture* Tileset::sdlTexture(int level)
 {
-    return mp_texid;
+    if (level == 0) {
+        return mp_texid;
+    } else {
+        return Ilmendur::instance().texturePool().downscaled(mp_texinfo, level);
+    }
 }
@@ -1,9 +1,30 @@
 #ifndef ILMENDUR_TILESET_HPP
 #define ILMENDUR_TILESET_HPP
 #include <string>
+#include <vector>
 #include <filesystem>
 #include <SDL2/SDL.h>
 
+struct TextureInfo;
+
+/**
+ * A tile animation as written by Tiled: the tile `lid` shows the
+ * `frames` one after the other, each for its duration, and then
+ * starts over.
+ */
+struct TileAnimation
+{
+    struct Frame
+    {
+        int lid;      ///< Local tile ID shown during this frame
+        int duration; ///< Milliseconds
+    };
+
+    int lid;
+    std::vector<Frame> frames;
+    int total_duration; ///< Sum of the frame durations, in milliseconds
+};
+
 /**
  * Class representing a tileset. This object is not copyable --
  * it contains an SDL_Texture, which refers to memory on the
@@ -17,13 +38,18 @@ public:
     Tileset(const std::filesystem::path& filename);
     ~Tileset();
 
-    void readTile(SDL_Rect& rect, int lid) const;
-    SDL_Texture* sdlTexture();
+    static int atlasLevel(float zoom);
+    void readTile(SDL_Rect& rect, int lid, int level) const;
+    SDL_Texture* sdlTexture(int level);
+    inline int tileCount() const { return m_tilecount; }
+    inline const std::vector<TileAnimation>& animations() const { return m_animations; }
 private:
     std::string m_name;
     int m_columns;
     int m_tilecount;
+    TextureInfo* mp_texinfo;
     SDL_Texture* mp_texid;
+    std::vector<TileAnimation> m_animations;
 };
 
 #endif /* ILMENDUR_TILESET_HPP */
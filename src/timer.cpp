@@ -1,13 +1,50 @@
 #include "timer.hpp"
-#include "ilmendur.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <cmath>
+
+/* The timing wheel has WHEEL_LEVELS levels of WHEEL_SLOTS slots each.
+ * A slot of level 0 holds the timers due in one millisecond, a slot
+ * of level 1 those due in a span of WHEEL_SLOTS milliseconds, and so
+ * on; each timer goes into the lowest level whose slots still reach
+ * its deadline. Whenever the slot index of a level wraps around, the
+ * next slot of the level above is emptied into the lower levels. */
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 4
 
 using namespace std;
 
+static TimerLink s_wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static uint64_t s_now = 0;   // Time up to which the wheel has been advanced
+static size_t s_count = 0;   // Timers in the wheel
+
+static inline bool isEmpty(const TimerLink& list)
+{
+    return list.p_next == &list;
+}
+
+// Moves all nodes of `from` into the empty list `to`.
+static void splice(TimerLink& from, TimerLink& to)
+{
+    if (isEmpty(from)) {
+        return;
+    }
+
+    to.p_next = from.p_next;
+    to.p_prev = from.p_prev;
+    to.p_next->p_prev = &to;
+    to.p_prev->p_next = &to;
+    from.p_next = &from;
+    from.p_prev = &from;
+}
+
 /**
  * Creates a new timer. The timer starts ticking immediately.
  *
  * \param[ms]
- * Timer interval in milliseconds.
+ * Timer interval in milliseconds. Intervals shorter than one
+ * millisecond are rounded up to one.
  *
  * \param[repeat]
  * Whether the timer stops ticking after the timer interval has passed.
@@ -17,11 +54,13 @@ using namespace std;
  */
 Timer::Timer(float ms, bool repeat, function<void()> cb)
     : m_cb(cb),
-      m_ticks(0),
-      m_interval((ms / 1000.0f) * ILMENDUR_TARGET_FRAMERATE), // Target framerate is in seconds, thus convert the milliseconds to seconds here
+      m_deadline(0),
+      m_interval(max(1L, lround(ms))),
+      m_remaining(m_interval),
       m_repeat(repeat),
-      m_ticking(true)
+      m_ticking(false)
 {
+    schedule(Clock::ticks() + m_interval);
 }
 
 /**
@@ -34,36 +73,170 @@ Timer::~Timer()
 }
 
 /**
- * Checks if the timer interval has passed and executes the callback if so.
- * Call this function once per frame.
+ * Freeze the timer. Any amount of time elapsed is stored;
+ * subsequently calling start() will continue at exactly the amount of
+ * time that has already passed.
  */
-void Timer::update()
+void Timer::stop()
 {
-    if (m_ticking) {
-        if (++m_ticks >= m_interval) {
-            m_cb();
-            m_ticks = 0;
-            if (!m_repeat) {
-                m_ticking = false;
-            }
-        }
+    if (!m_ticking) {
+        return;
+    }
+
+    uint64_t now = Clock::ticks();
+    m_remaining  = m_deadline > now ? m_deadline - now : 0;
+    m_ticking    = false;
+    unlink();
+}
+
+/**
+ * Continue ticking after the timer was stopped with stop(). A
+ * non-repeating timer that has already run its callback starts
+ * over with its full interval.
+ */
+void Timer::start()
+{
+    if (!m_ticking) {
+        schedule(Clock::ticks() + m_remaining);
     }
 }
 
 /**
- * Freeze the timer. Any amount of time elapsed is stored;
- * subsequently calling start() will continue at exactly the amount of
- * time that has already passed.
+ * Runs the callbacks of all timers whose deadline has passed, in
+ * the order of their deadlines. Call this once per frame from the
+ * main loop; do not call it from any scene.
  */
-void Timer::stop()
+void Timer::updateAll()
 {
-    m_ticking = false;
+    advance(Clock::ticks());
 }
 
 /**
- * Continue ticking after the timer was stopped with stop().
+ * Returns the Clock::ticks() value at which the next timer callback
+ * is due, or UINT64_MAX if no timer is ticking. The main loop may
+ * sleep until then.
  */
-void Timer::start()
+uint64_t Timer::nextDeadline()
 {
-    m_ticking = true;
+    if (s_count == 0) {
+        return UINT64_MAX;
+    }
+
+    // The slots of each level are in deadline order starting after
+    // the current one, but the levels may overlap, as a timer stays
+    // in its level until that level's slot is emptied.
+    uint64_t next = UINT64_MAX;
+    for(int level=0; level < WHEEL_LEVELS; level++) {
+        uint64_t current = s_now >> (WHEEL_BITS * level);
+        for(uint64_t i=1; i <= WHEEL_SLOTS; i++) {
+            const TimerLink& list = s_wheel[level][(current + i) & (WHEEL_SLOTS - 1)];
+            if (!isEmpty(list)) {
+                for(const TimerLink* p_link = list.p_next; p_link != &list; p_link = p_link->p_next) {
+                    next = min(next, static_cast<const Timer*>(p_link)->m_deadline);
+                }
+                break;
+            }
+        }
+    }
+
+    return next;
+}
+
+/**
+ * Puts the timer into the wheel to run its callback at `deadline`,
+ * but not before the wheel's next millisecond.
+ */
+void Timer::schedule(uint64_t deadline)
+{
+    if (s_count == 0) {
+        // Nothing to advance the empty wheel over; this also follows
+        // Clock::setVirtual() resetting the clock.
+        s_now = Clock::ticks();
+    }
+
+    m_deadline = max(deadline, s_now + 1);
+    m_ticking  = true;
+    s_count++;
+    place(this);
+}
+
+/// Removes the timer from the wheel, if it is in there.
+void Timer::unlink()
+{
+    if (p_next != this) {
+        p_prev->p_next = p_next;
+        p_next->p_prev = p_prev;
+        p_prev = this;
+        p_next = this;
+        s_count--;
+    }
+}
+
+/// Appends `p_timer` to the slot of its deadline, relative to `s_now`.
+void Timer::place(Timer* p_timer)
+{
+    uint64_t delta = p_timer->m_deadline - s_now;
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >> (WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+
+    // Beyond the top level's reach, park the timer in its farthest
+    // slot; it is placed again when that slot is emptied.
+    uint64_t when = p_timer->m_deadline;
+    if (delta >> (WHEEL_BITS * WHEEL_LEVELS)) {
+        when = s_now + (1ULL << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    }
+
+    TimerLink& list = s_wheel[level][(when >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)];
+    p_timer->p_prev = list.p_prev;
+    p_timer->p_next = &list;
+    list.p_prev->p_next = p_timer;
+    list.p_prev = p_timer;
+}
+
+/// Advances the wheel millisecond by millisecond up to `now`.
+void Timer::advance(uint64_t now)
+{
+    while (s_now < now) {
+        if (s_count == 0) {
+            s_now = now;
+            break;
+        }
+
+        s_now++;
+
+        // Refill the lower levels from the level above whenever their
+        // slot index wraps around.
+        for(int level=1; level < WHEEL_LEVELS; level++) {
+            if ((s_now >> (WHEEL_BITS * (level - 1))) & (WHEEL_SLOTS - 1)) {
+                break;
+            }
+
+            TimerLink pending;
+            splice(s_wheel[level][(s_now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)], pending);
+            while (!isEmpty(pending)) {
+                Timer* p_timer = static_cast<Timer*>(pending.p_next);
+                pending.p_next = p_timer->p_next;
+                pending.p_next->p_prev = &pending;
+                place(p_timer);
+            }
+        }
+
+        // Callbacks may stop, start, and destroy any timer other than
+        // their own, including those still in `due`.
+        TimerLink due;
+        splice(s_wheel[0][s_now & (WHEEL_SLOTS - 1)], due);
+        while (!isEmpty(due)) {
+            Timer* p_timer = static_cast<Timer*>(due.p_next);
+            p_timer->unlink();
+            if (p_timer->m_repeat) {
+                p_timer->schedule(s_now + p_timer->m_interval);
+            } else {
+                p_timer->m_ticking   = false;
+                p_timer->m_remaining = p_timer->m_interval;
+            }
+            p_timer->m_cb();
+        }
+    }
 }
@@ -1,6 +1,15 @@
 #ifndef ILMENDUR_TIMER_HPP
 #define ILMENDUR_TIMER_HPP
 #include <functional>
+#include <cstdint>
+
+/// Node of the intrusive lists of the timer wheel; see Timer.
+struct TimerLink
+{
+    TimerLink() : p_prev(this), p_next(this) {}
+    TimerLink* p_prev;
+    TimerLink* p_next;
+};
 
 /**
  * A timer that executes a callback after a certain delay of time.
@@ -10,24 +19,36 @@
  * function to access outer variables, but be sure to not let them
  * go out of scope while the timer is active.
  *
- * It is necessary to call update() on a timer once per frame,
- * as that is the function that will invoke the timer callback
- * at the appropriate intervals.
+ * All ticking timers are kept in one hierarchical timing wheel, which
+ * the main loop advances once per frame with updateAll(); the owner
+ * of a timer does not need to poll it. Starting and stopping a timer
+ * takes constant time, and destroying a timer stops it. Do not
+ * destroy a timer from within its own callback.
  */
-class Timer
+class Timer: private TimerLink
 {
 public:
     Timer(float ms, bool repeat, std::function<void()> cb);
     ~Timer();
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
 
     void stop();
     void start();
+    inline bool isTicking() const { return m_ticking; }
 
-    void update();
+    static void updateAll();
+    static uint64_t nextDeadline();
 private:
+    void schedule(uint64_t deadline);
+    void unlink();
+    static void place(Timer* p_timer);
+    static void advance(uint64_t now);
+
     std::function<void()> m_cb;
-    float m_ticks;
-    float m_interval;
+    uint64_t m_deadline;  ///< Clock::ticks() at which the callback runs next
+    uint64_t m_interval;  ///< Milliseconds
+    uint64_t m_remaining; ///< Milliseconds left when stop() was called
     bool m_repeat;
     bool m_ticking;
 };
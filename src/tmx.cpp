@@ -8,6 +8,7 @@
 #include "actors/npc.hpp"
 #include "actors/teleport.hpp"
 #include "map.hpp"
+#include "arena.hpp"
 #include "i18n.hpp"
 #include <cassert>
 #include <algorithm>
@@ -18,24 +19,90 @@
 using namespace std;
 using namespace TMX;
 
-Properties TMX::readProperties(const pugi::xml_node& node)
+namespace {
+
+    enum class object_type { unknown, static_actor, startpos, npc, signpost, collbox, teleport, entry, passage };
+
+    // Property names used by readTmxObjects(), interned once.
+    const StringId s_key_type("type");
+    const StringId s_key_graphic("graphic");
+    const StringId s_key_animation_mode("animation_mode");
+    const StringId s_key_startpos("startpos");
+    const StringId s_key_direction("direction");
+    const StringId s_key_text("text");
+    const StringId s_key_entry("entry");
+    const StringId s_key_map("map");
+    const StringId s_key_enter_dir("enter_dir");
+    const StringId s_key_target("target");
+
+    /* Maps the value of the "type" property to the object type.
+     * The type names are interned, so that each object needs one
+     * hash lookup and a few integer comparisons rather than a chain
+     * of string comparisons. */
+    object_type objectType(string_view type)
+    {
+        static const pair<StringId, object_type> s_types[] = {
+            {StringId("static"),   object_type::static_actor},
+            {StringId("startpos"), object_type::startpos},
+            {StringId("npc"),      object_type::npc},
+            {StringId("signpost"), object_type::signpost},
+            {StringId("collbox"),  object_type::collbox},
+            {StringId("teleport"), object_type::teleport},
+            {StringId("entry"),    object_type::entry},
+            {StringId("passage"),  object_type::passage}
+        };
+
+        StringId id = StringId::find(type);
+        for(const auto& entry: s_types) {
+            if (entry.first == id) {
+                return entry.second;
+            }
+        }
+        return object_type::unknown;
+    }
+
+    /* Parses the "animation_mode" property value of object `id`.
+     * Returns false if the property is empty. */
+    bool parseAnimationMode(string_view ani, int id, Actor::animation_mode& mode)
+    {
+        if (ani.empty()) {
+            return false;
+        } else if (ani == "never") {
+            mode = Actor::animation_mode::never;
+        } else if (ani == "on_move") {
+            mode = Actor::animation_mode::on_move;
+        } else if (ani == "always") {
+            mode = Actor::animation_mode::always;
+        } else {
+            throw(runtime_error("Invalid animation mode `" + string(ani) + "' for object with ID " + to_string(id) + "!"));
+        }
+        return true;
+    }
+
+}
+
+/**
+ * Reads the <properties> child of `node`. The returned Properties
+ * allocate from `p_res`.
+ */
+Properties TMX::readProperties(const pugi::xml_node& node, pmr::memory_resource* p_res)
 {
-    Properties props;
+    Properties props(p_res);
     const pugi::xml_node& properties_node = node.child("properties");
 
     if (properties_node) {
         for (const pugi::xml_node& prop_node: properties_node.children("property")) {
-            string prop_name = prop_node.attribute("name").value();
-            string prop_val  = prop_node.attribute("value").value();
-            string prop_type = prop_node.attribute("type").value();
+            StringId prop_name(prop_node.attribute("name").value());
+            const char* prop_val = prop_node.attribute("value").value();
+            string_view prop_type = prop_node.attribute("type").value();
             if (prop_type == "int") {
-                props.int_props[prop_name] = atoi(prop_val.c_str());
+                props.setInt(prop_name, atoi(prop_val));
             } else if (prop_type == "float") {
-                props.float_props[prop_name] = atof(prop_val.c_str());
+                props.setFloat(prop_name, atof(prop_val));
             } else if (prop_type == "bool") {
-                props.int_props[prop_name] = prop_val == "true";
+                props.setBool(prop_name, prop_val == string_view("true"));
             } else { // Treat all the rest as strings, these types are not used
-                props.string_props[prop_name] = prop_val;
+                props.setString(prop_name, prop_val);
             }
         }
     }
@@ -43,9 +110,15 @@ Properties TMX::readProperties(const pugi::xml_node& node)
     return props;
 }
 
-vector<int> TMX::parseGidCsv(const std::string& csv)
+/**
+ * Parses the CSV-encoded tile data of a TMX layer. The returned
+ * vector allocates from `p_res`.
+ */
+pmr::vector<int> TMX::parseGidCsv(const std::string& csv, pmr::memory_resource* p_res)
 {
-    vector<int> result;
+    pmr::vector<int> result(p_res);
+    result.reserve(count(csv.begin(), csv.end(), ',') + 1);
+
     size_t pos = 0;
     size_t ppos = 0;
     while ((pos = csv.find(",", pos)) != string::npos) {
@@ -69,48 +142,52 @@ vector<int> TMX::parseGidCsv(const std::string& csv)
  */
 void TMX::readTmxObjects(const pugi::xml_node& node, ObjectLayer* p_target_layer)
 {
-    vector<Actor*> result;
+    // All actors belong to the map's arena.
+    Arena& arena = p_target_layer->map().arena();
+
+    // The objects' properties are only needed while reading the
+    // object. Allocate them from a scratch buffer that is reset
+    // for each object instead of from the heap.
+    char scratch_buf[4096];
+    pmr::monotonic_buffer_resource scratch(scratch_buf, sizeof(scratch_buf));
 
+    // Note: Actors add themselves to p_target_layer on construction,
+    // which keeps them sorted by ID.
     for(const pugi::xml_node& obj_node: node.children("object")) {
+        scratch.release();
+
         int id              = obj_node.attribute("id").as_int();
         float x             = obj_node.attribute("x").as_float();
         float y             = obj_node.attribute("y").as_float();
         float w             = obj_node.attribute("width").as_float(); // zero if unset
         float h             = obj_node.attribute("height").as_float(); // zero if unset
-        Properties props    = readProperties(obj_node);
+        Properties props    = readProperties(obj_node, &scratch);
 
         assert(id > 0);
 
-        string type = props.get("type");
-        if (type == string("static")) {
-            const string& graphic = props.get("graphic");
-            const string& ani     = props.get("animation_mode");
+        string_view type = props.get(s_key_type);
+        Actor::animation_mode ani = Actor::animation_mode::on_move;
+        switch (objectType(type)) {
+        case object_type::static_actor: {
+            string graphic(props.get(s_key_graphic));
             assert(!graphic.empty());
 
             // Note: Static actors should always be placed with Point objects in
             // Tiled, which do not have width/height values in the TMX file.
-            Actor* p_actor = new Actor(id, p_target_layer, graphic);
+            Actor* p_actor = arena.create<Actor>(id, p_target_layer, graphic);
             p_actor->warp(Vector2f(x, y));
 
-            if (!ani.empty()) {
-                if (ani == string("never")) {
-                    p_actor->setAnimationMode(Actor::animation_mode::never);
-                } else if (ani == string("on_move")) {
-                    p_actor->setAnimationMode(Actor::animation_mode::on_move);
-                } else if (ani == string("always")) {
-                    p_actor->setAnimationMode(Actor::animation_mode::always);
-                } else {
-                    throw(runtime_error("Invalid animation mode `" + ani + "' for object with ID " + to_string(id) + "!"));
-                }
+            if (parseAnimationMode(props.get(s_key_animation_mode), id, ani)) {
+                p_actor->setAnimationMode(ani);
             }
-
-            result.push_back(p_actor);
-        } else if (type == "startpos") {
-            result.push_back(new StartPosition(id, p_target_layer, Vector2f(x, y), atoi(props.get("startpos").c_str())));
-        } else if (type == string("npc")) {
-            const string& graphic = props.get("graphic");
-            const string& ani     = props.get("animation_mode");
-            const string& dirstr  = props.get("direction");
+            break;
+        }
+        case object_type::startpos:
+            arena.create<StartPosition>(id, p_target_layer, Vector2f(x, y), atoi(string(props.get(s_key_startpos)).c_str()));
+            break;
+        case object_type::npc: {
+            string graphic(props.get(s_key_graphic));
+            string_view dirstr = props.get(s_key_direction);
             assert(!graphic.empty());
 
             direction dir = direction::down;
@@ -130,40 +207,35 @@ void TMX::readTmxObjects(const pugi::xml_node& node, ObjectLayer* p_target_layer
 
             // Note: NPCs should always be placed with Point objects in
             // Tiled, which do not have width/height values in the TMX file.
-            NonPlayableCharacter* p_npc = new NonPlayableCharacter(id, p_target_layer, graphic);
+            NonPlayableCharacter* p_npc = arena.create<NonPlayableCharacter>(id, p_target_layer, graphic);
             p_npc->warp(Vector2f(x, y));
             p_npc->turn(dir);
 
-            if (!ani.empty()) {
-                if (ani == string("never")) {
-                    p_npc->setAnimationMode(Actor::animation_mode::never);
-                } else if (ani == string("on_move")) {
-                    p_npc->setAnimationMode(Actor::animation_mode::on_move);
-                } else if (ani == string("always")) {
-                    p_npc->setAnimationMode(Actor::animation_mode::always);
-                } else {
-                    throw(runtime_error("Invalid animation mode `" + ani + "' for object with ID " + to_string(id) + "!"));
-                }
+            if (parseAnimationMode(props.get(s_key_animation_mode), id, ani)) {
+                p_npc->setAnimationMode(ani);
             }
-
-            result.push_back(p_npc);
-        } else if (type == "signpost") {
-            string translated_text = gettext(props.get("text").c_str());
+            break;
+        }
+        case object_type::signpost: {
+            string translated_text = gettext(string(props.get(s_key_text)).c_str());
             vector<string> texts = splitString(translated_text, "<NM>");
 
-            Signpost* p_sign = new Signpost(id, p_target_layer, texts);
+            Signpost* p_sign = arena.create<Signpost>(id, p_target_layer, texts);
             p_sign->warp(Vector2f(x, y));
-            result.push_back(p_sign);
-        } else if (type == string("collbox")) {
+            break;
+        }
+        case object_type::collbox: {
             SDL_Rect rect;
             rect.x = x;
             rect.y = y;
             rect.w = w;
             rect.h = h;
-            result.push_back(new CollisionBox(id, p_target_layer, rect));
-        } else if (type == string("teleport")) {
-            int target_entry_id = props.getInt("entry");
-            string target_map_name = props.get("map");
+            arena.create<CollisionBox>(id, p_target_layer, rect);
+            break;
+        }
+        case object_type::teleport: {
+            int target_entry_id = props.getInt(s_key_entry);
+            string target_map_name(props.get(s_key_map));
             SDL_Rect rect;
             rect.x = x;
             rect.y = y;
@@ -172,80 +244,62 @@ void TMX::readTmxObjects(const pugi::xml_node& node, ObjectLayer* p_target_layer
 
             assert(target_entry_id > 0);
 
-            result.push_back(new Teleport(id, p_target_layer, rect, target_entry_id, target_map_name));
-        } else if (type == string("entry")) {
-            string dirstr = props.get("enter_dir");
+            arena.create<Teleport>(id, p_target_layer, rect, target_entry_id, target_map_name);
+            break;
+        }
+        case object_type::entry: {
+            string_view dirstr = props.get(s_key_enter_dir);
             direction dir = direction::down;
-            if (dirstr == string("up")) {
+            if (dirstr == "up") {
                 dir = direction::up;
-            } else if (dirstr == string("right")) {
+            } else if (dirstr == "right") {
                 dir = direction::right;
-            } else if (dirstr == string("down")) {
+            } else if (dirstr == "down") {
                 dir = direction::down;
-            } else if (dirstr == string("left")) {
+            } else if (dirstr == "left") {
                 dir = direction::left;
             } else {
-                throw(string("Invalid value for `enter_dir': `") + dirstr + "' (TMX object ID: " + to_string(id) + ")!");
+                throw(string("Invalid value for `enter_dir': `") + string(dirstr) + "' (TMX object ID: " + to_string(id) + ")!");
             }
 
-            Entry* p_entry = new Entry(id, p_target_layer, dir);
+            Entry* p_entry = arena.create<Entry>(id, p_target_layer, dir);
             p_entry->warp(Vector2f(x, y));
-            result.push_back(p_entry);
-        } else if (type == string("passage")) {
+            break;
+        }
+        case object_type::passage: {
             SDL_Rect rect;
             rect.x = x;
             rect.y = y;
             rect.w = w;
             rect.h = h;
 
-            const string& direction = props.get("direction");
+            string_view direction = props.get(s_key_direction);
             Passage::pass_direction dir = 0;
-            if (direction.find("all") != string::npos) {
+            if (direction.find("all") != string_view::npos) {
                 dir = Passage::up | Passage::right | Passage::down | Passage::left;
             } else {
-                if (direction.find("up") != string::npos) {
+                if (direction.find("up") != string_view::npos) {
                     dir |= Passage::up;
                 }
-                if (direction.find("right") != string::npos) {
+                if (direction.find("right") != string_view::npos) {
                     dir |= Passage::right;
                 }
-                if (direction.find("down") != string::npos) {
+                if (direction.find("down") != string_view::npos) {
                     dir |= Passage::down;
                 }
-                if (direction.find("left") != string::npos) {
+                if (direction.find("left") != string_view::npos) {
                     dir |= Passage::left;
                 }
             }
 
-            const string& target = props.get("target");
+            string target(props.get(s_key_target));
             assert(!target.empty());
-            result.push_back(new Passage(id, p_target_layer, rect, dir, target));
-        } else {
-            // Valid TMX, but an error by the map editor: unknown object type requested.
-            throw(runtime_error(string("Unknown object type `") + type + "' found in TMX file!"));
+            arena.create<Passage>(id, p_target_layer, rect, dir, target);
+            break;
         }
-
-    }
-
-    // Ensure all actors are sorted by ID
-    sort(result.begin(),
-         result.end(),
-         [](Actor*& a, Actor*& b) { return a->id() < b->id(); });
-
-    // Important final step: Make the counter-link from the layer to
-    // to the actors so that the layer owns the actors.
-    for(Actor* p_actor: result) {
-        tmxAddActor(p_target_layer, p_actor);
+        case object_type::unknown:
+            // Valid TMX, but an error by the map editor: unknown object type requested.
+            throw(runtime_error("Unknown object type `" + string(type) + "' found in TMX file!"));
+        } // No default to provoke compiler warnings on missing elements
     }
 }
-
-/**
- * Internal function used by TMX::readTmxObjects() that is `friend`
- * with ObjectLayer.
- *
- * \internal
- */
-void TMX::tmxAddActor(ObjectLayer* p_target_layer, Actor* p_actor)
-{
-    p_target_layer->addActor(p_actor);
-}
@@ -2,8 +2,10 @@
 #define ILMENDUR_TMX_HPP
 #include "util.hpp"
 #include "globals.hpp"
+#include "properties.hpp"
 #include <string>
 #include <vector>
+#include <memory_resource>
 #include <pugixml.hpp>
 // Various utilities related to specifically dealing with Tiled's TMX map format
 
@@ -12,8 +14,8 @@ class ObjectLayer;
 
 namespace TMX {
 
-    std::vector<int> parseGidCsv(const std::string& csv);
-    Properties readProperties(const pugi::xml_node& node);
+    std::pmr::vector<int> parseGidCsv(const std::string& csv, std::pmr::memory_resource* p_res = std::pmr::get_default_resource());
+    Properties readProperties(const pugi::xml_node& node, std::pmr::memory_resource* p_res = std::pmr::get_default_resource());
     void readTmxObjects(const pugi::xml_node& node, ObjectLayer* p_target_layer);
 }
 
@@ -1,6 +1,7 @@
 #include "util.hpp"
 #include <cstdarg>
 #include <cstring>
+#include <cstdio>
 #include <cassert>
 
 using namespace std;
@@ -54,3 +55,25 @@ vector<string> splitString(string str, const string& sep)
     result.push_back(str);
     return result;
 }
+
+/**
+ * Writes `str` as a JSON string literal to `stream`, escaping quotes,
+ * backslashes, and control characters. The stream's formatting flags
+ * are left alone.
+ */
+void writeJsonString(ostream& stream, const string& str)
+{
+    stream << '"';
+    for(char c: str) {
+        if (c == '"' || c == '\\') {
+            stream << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[7];
+            snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned int>(c));
+            stream << escape;
+        } else {
+            stream << c;
+        }
+    }
+    stream << '"';
+}
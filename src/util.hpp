@@ -2,6 +2,7 @@
 #define ILMENDUR_UTIL_HPP
 #include <SDL2/SDL.h>
 #include <cmath>
+#include <ostream>
 #include <stdexcept>
 #include <vector>
 #include <string>
@@ -29,10 +30,10 @@ public:
     T x;
     T y;
 
-    Vector2<T>() { x = 0; y = 0; } ///< Default constructor creates a zero-length vector.
-    Vector2<T>(const Vector2<T>& other) { x = other.x; y = other.y; }
-    Vector2<T>(Vector2<T>&& other) { x = other.x; y = other.y; other.clear(); }
-    Vector2<T>(T other_x, T other_y) { x = other_x; y = other_y; }
+    Vector2() { x = 0; y = 0; } ///< Default constructor creates a zero-length vector.
+    Vector2(const Vector2<T>& other) { x = other.x; y = other.y; }
+    Vector2(Vector2<T>&& other) { x = other.x; y = other.y; other.clear(); }
+    Vector2(T other_x, T other_y) { x = other_x; y = other_y; }
 
     /// Resets this vector to a zero length vector.
     void clear() {
@@ -168,5 +169,6 @@ inline bool isPointInRect(const Vector2f& point, const SDL_Rect& rect)
 std::string format(const char* source, ...);
 bool hasOverlap(float a1, float a2, float b1, float b2);
 std::vector<std::string> splitString(std::string str, const std::string& sep);
+void writeJsonString(std::ostream& stream, const std::string& str);
 
 #endif /* ILMENDUR_UTIL_HPP */